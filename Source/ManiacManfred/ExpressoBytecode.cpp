@@ -0,0 +1,936 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#include "ExpressoBytecode.h"
+#include "ArticyGlobalVariables.h"
+#include "ArticyScriptFragment.h"
+#include "Math/RandomStream.h"
+#include "UObject/UObjectIterator.h"
+
+#pragma region Variable store
+
+void FExpressoVariableStore::Bind(UArticyGlobalVariables* InGlobalVariables)
+{
+	GlobalVariables = InGlobalVariables;
+	Values.Reset();
+	Variables.Reset();
+	Names.Reset();
+	IndexByName.Reset();
+	BoolVariables.Reset();
+
+	if (!InGlobalVariables)
+		return;
+
+	// the generated classes hold a property per namespace and the namespaces a property per variable, named like in the scripts
+	for (TFieldIterator<FObjectProperty> setIt(InGlobalVariables->GetClass()); setIt; ++setIt)
+	{
+		UArticyBaseVariableSet* variableSet = Cast<UArticyBaseVariableSet>(setIt->GetObjectPropertyValue_InContainer(InGlobalVariables));
+		if (!variableSet)
+			continue;
+
+		for (TFieldIterator<FObjectProperty> variableIt(variableSet->GetClass()); variableIt; ++variableIt)
+		{
+			UArticyVariable* variable = Cast<UArticyVariable>(variableIt->GetObjectPropertyValue_InContainer(variableSet));
+			if (!variable || (!variable->IsA<UArticyBool>() && !variable->IsA<UArticyInt>()))
+				continue;
+
+			const FString name = setIt->GetName() + TEXT(".") + variableIt->GetName();
+			IndexByName.Add(name, Names.Num());
+			Names.Add(name);
+			Variables.Add(variable);
+			BoolVariables.Add(variable->IsA<UArticyBool>());
+		}
+	}
+
+	Values.SetNumZeroed(Variables.Num());
+	Gather();
+}
+
+int32 FExpressoVariableStore::FindVariable(const FString& Name) const
+{
+	const int32* index = IndexByName.Find(Name);
+	return index ? *index : INDEX_NONE;
+}
+
+void FExpressoVariableStore::Gather()
+{
+	for (int32 i = 0; i < Variables.Num(); ++i)
+		GatherVariable(i);
+
+	bCurrent = true;
+}
+
+void FExpressoVariableStore::Gather(TArrayView<const int32> Indices)
+{
+	for (int32 index : Indices)
+		GatherVariable(index);
+}
+
+int32 FExpressoVariableStore::Flush()
+{
+	int32 written = 0;
+	for (int32 i = 0; i < Variables.Num(); ++i)
+		written += FlushVariable(i) ? 1 : 0;
+
+	bCurrent = true;
+	return written;
+}
+
+int32 FExpressoVariableStore::Flush(TArrayView<const int32> Indices)
+{
+	int32 written = 0;
+	for (int32 index : Indices)
+		written += FlushVariable(index) ? 1 : 0;
+
+	return written;
+}
+
+void FExpressoVariableStore::GatherVariable(int32 Index)
+{
+	if (UArticyBool* boolVariable = Cast<UArticyBool>(Variables[Index].Get()))
+		Values[Index] = boolVariable->Get() ? 1 : 0;
+	else if (UArticyInt* intVariable = Cast<UArticyInt>(Variables[Index].Get()))
+		Values[Index] = intVariable->Get();
+}
+
+bool FExpressoVariableStore::FlushVariable(int32 Index)
+{
+	if (UArticyBool* boolVariable = Cast<UArticyBool>(Variables[Index].Get()))
+	{
+		if (boolVariable->Get() != (Values[Index] != 0))
+		{
+			*boolVariable = Values[Index] != 0;
+			return true;
+		}
+	}
+	else if (UArticyInt* intVariable = Cast<UArticyInt>(Variables[Index].Get()))
+	{
+		if (intVariable->Get() != Values[Index])
+		{
+			*intVariable = Values[Index];
+			return true;
+		}
+	}
+
+	return false;
+}
+
+#pragma endregion
+
+#pragma region Compiler
+
+/* A token of the script source */
+struct FExpressoToken
+{
+	enum class EType : uint8
+	{
+		End,
+		Identifier,
+		Number,
+		Operator,
+		String,
+		Unsupported,
+	};
+
+	EType Type = EType::End;
+	FString Text;
+	int32 Value = 0;
+};
+
+/* Splits the script source into tokens, skipping whitespace and comments */
+static bool Tokenize(const FString& Source, TArray<FExpressoToken>& OutTokens, FString& OutError)
+{
+	static const TCHAR* operators[] = { TEXT("=="), TEXT("!="), TEXT("<="), TEXT(">="), TEXT("&&"), TEXT("||"), TEXT("+="), TEXT("-="), TEXT("*="), TEXT("/="),
+		TEXT("++"), TEXT("--"), TEXT("<"), TEXT(">"), TEXT("!"), TEXT("="), TEXT("+"), TEXT("-"), TEXT("*"), TEXT("/"), TEXT("%"), TEXT("("), TEXT(")"), TEXT(";"), TEXT(",") };
+
+	const TCHAR* c = *Source;
+	while (*c)
+	{
+		if (FChar::IsWhitespace(*c))
+		{
+			++c;
+			continue;
+		}
+
+		if (c[0] == '/' && c[1] == '/')
+		{
+			while (*c && *c != '\n')
+				++c;
+			continue;
+		}
+
+		if (c[0] == '/' && c[1] == '*')
+		{
+			const TCHAR* end = FCString::Strstr(c + 2, TEXT("*/"));
+			c = end ? end + 2 : c + FCString::Strlen(c);
+			continue;
+		}
+
+		FExpressoToken& token = OutTokens.AddDefaulted_GetRef();
+		if (FChar::IsAlpha(*c) || *c == '_')
+		{
+			// namespaced variables keep their dot, e.g. GameState.awake
+			const TCHAR* start = c;
+			while (FChar::IsAlnum(*c) || *c == '_' || *c == '.')
+				++c;
+			token.Type = FExpressoToken::EType::Identifier;
+			token.Text = FString::ConstructFromPtrSize(start, c - start);
+		}
+		else if (FChar::IsDigit(*c))
+		{
+			const TCHAR* start = c;
+			int64 value = 0;
+			while (FChar::IsDigit(*c))
+				value = value * 10 + (*c++ - '0');
+
+			token.Text = FString::ConstructFromPtrSize(start, c - start);
+			if (*c == '.' || value > MAX_int32)
+			{
+				OutError = FString::Printf(TEXT("unsupported number %s"), *token.Text);
+				return false;
+			}
+
+			token.Type = FExpressoToken::EType::Number;
+			token.Value = (int32)value;
+		}
+		else if (*c == '"')
+		{
+			const TCHAR* start = ++c;
+			while (*c && *c != '"')
+				c += c[0] == '\\' && c[1] ? 2 : 1;
+			token.Type = FExpressoToken::EType::String;
+			token.Text = FString::ConstructFromPtrSize(start, c - start);
+			if (*c)
+				++c;
+		}
+		else
+		{
+			token.Type = FExpressoToken::EType::Unsupported;
+			for (const TCHAR* op : operators)
+			{
+				const int32 length = FCString::Strlen(op);
+				if (FCString::Strncmp(c, op, length) == 0)
+				{
+					token.Type = FExpressoToken::EType::Operator;
+					token.Text = op;
+					break;
+				}
+			}
+
+			if (token.Type == FExpressoToken::EType::Unsupported)
+				token.Text = FString::ConstructFromPtrSize(c, 1);
+			c += token.Text.Len();
+		}
+	}
+
+	OutTokens.AddDefaulted();
+	return true;
+}
+
+/* Parses the tokens into a small tree and generates the bytecode from it */
+class FExpressoParser
+{
+public:
+
+	FExpressoParser(const TArray<FExpressoToken>& InTokens, const FExpressoVariableStore& InStore)
+		: Tokens(InTokens)
+		, Store(InStore)
+	{
+	}
+
+	bool CompileCondition(TArray<uint32>& OutCode)
+	{
+		// an empty condition is true, like ConditionOrTrue does it
+		if (Peek().Type == FExpressoToken::EType::End)
+		{
+			EmitConst(EExpressoOpcode::LoadConst, 0, 1);
+			Emit(EExpressoOpcode::Return, 0);
+		}
+		else
+		{
+			const int32 node = ParseExpression();
+			if (node == INDEX_NONE || !Expect(FExpressoToken::EType::End, nullptr))
+				return Fail(TEXT("unexpected token after the condition"));
+
+			Generate(node, 0);
+			Emit(EExpressoOpcode::Return, 0);
+		}
+
+		OutCode.Append(Code);
+		return Error.IsEmpty();
+	}
+
+	bool CompileInstruction(TArray<uint32>& OutCode)
+	{
+		while (Peek().Type != FExpressoToken::EType::End)
+		{
+			if (Match(TEXT(";")))
+				continue;
+
+			if (!ParseStatement())
+				return false;
+
+			if (Peek().Type != FExpressoToken::EType::End && !Expect(FExpressoToken::EType::Operator, TEXT(";")))
+				return Fail(TEXT("missing ;"));
+		}
+
+		Emit(EExpressoOpcode::Return, 0);
+		OutCode.Append(Code);
+		return Error.IsEmpty();
+	}
+
+	FString Error;
+	TArray<int32> Variables;
+	TArray<int32> Constants;
+
+private:
+
+	enum class ENodeKind : uint8
+	{
+		Constant,
+		Variable,
+		Unary,
+		Binary,
+	};
+
+	struct FNode
+	{
+		ENodeKind Kind = ENodeKind::Constant;
+		EExpressoOpcode Op = EExpressoOpcode::LoadConst;
+		int32 Value = 0;
+		int32 Left = INDEX_NONE;
+		int32 Right = INDEX_NONE;
+	};
+
+	const FExpressoToken& Peek() const { return Tokens[Position]; }
+
+	bool IsOperator(const TCHAR* Text) const
+	{
+		return Peek().Type == FExpressoToken::EType::Operator && Peek().Text == Text;
+	}
+
+	bool Match(const TCHAR* Text)
+	{
+		if (!IsOperator(Text))
+			return false;
+
+		++Position;
+		return true;
+	}
+
+	bool Expect(FExpressoToken::EType Type, const TCHAR* Text)
+	{
+		if (Peek().Type != Type || (Text && Peek().Text != Text))
+			return false;
+
+		++Position;
+		return true;
+	}
+
+	bool Fail(const FString& Message)
+	{
+		if (Error.IsEmpty())
+			Error = Message;
+		return false;
+	}
+
+	int32 FailNode(const FString& Message)
+	{
+		Fail(Message);
+		return INDEX_NONE;
+	}
+
+	int32 AddNode(ENodeKind Kind, EExpressoOpcode Op, int32 Value, int32 Left = INDEX_NONE, int32 Right = INDEX_NONE)
+	{
+		FNode& node = Nodes.AddDefaulted_GetRef();
+		node.Kind = Kind;
+		node.Op = Op;
+		node.Value = Value;
+		node.Left = Left;
+		node.Right = Right;
+		return Nodes.Num() - 1;
+	}
+
+	/* Parses a chain of binary operators of the same precedence, Next parses the operands */
+	template<typename NextType>
+	int32 ParseBinary(std::initializer_list<TPair<const TCHAR*, EExpressoOpcode>> Operators, NextType Next)
+	{
+		int32 left = Next();
+		while (left != INDEX_NONE)
+		{
+			const TPair<const TCHAR*, EExpressoOpcode>* op = nullptr;
+			for (const TPair<const TCHAR*, EExpressoOpcode>& candidate : Operators)
+			{
+				if (IsOperator(candidate.Key) || (Peek().Type == FExpressoToken::EType::Identifier && Peek().Text == candidate.Key))
+				{
+					op = &candidate;
+					break;
+				}
+			}
+
+			if (!op)
+				break;
+
+			++Position;
+			const int32 right = Next();
+			if (right == INDEX_NONE)
+				return INDEX_NONE;
+
+			left = AddNode(ENodeKind::Binary, op->Value, 0, left, right);
+		}
+
+		return left;
+	}
+
+	/* The precedence of the operators from lowest to highest, the same as in C# and C++ */
+	int32 ParseExpression() { return ParseBinary({ { TEXT("||"), EExpressoOpcode::Or }, { TEXT("or"), EExpressoOpcode::Or } }, [this]() { return ParseAnd(); }); }
+	int32 ParseAnd() { return ParseBinary({ { TEXT("&&"), EExpressoOpcode::And }, { TEXT("and"), EExpressoOpcode::And } }, [this]() { return ParseEquality(); }); }
+	int32 ParseEquality() { return ParseBinary({ { TEXT("=="), EExpressoOpcode::Equal }, { TEXT("!="), EExpressoOpcode::NotEqual } }, [this]() { return ParseRelational(); }); }
+
+	int32 ParseRelational()
+	{
+		return ParseBinary({ { TEXT("<="), EExpressoOpcode::LessEqual }, { TEXT(">="), EExpressoOpcode::GreaterEqual }, { TEXT("<"), EExpressoOpcode::Less }, { TEXT(">"), EExpressoOpcode::Greater } },
+			[this]() { return ParseAdditive(); });
+	}
+
+	int32 ParseAdditive() { return ParseBinary({ { TEXT("+"), EExpressoOpcode::Add }, { TEXT("-"), EExpressoOpcode::Subtract } }, [this]() { return ParseMultiplicative(); }); }
+
+	int32 ParseMultiplicative()
+	{
+		return ParseBinary({ { TEXT("*"), EExpressoOpcode::Multiply }, { TEXT("/"), EExpressoOpcode::Divide }, { TEXT("%"), EExpressoOpcode::Modulo } },
+			[this]() { return ParseUnary(); });
+	}
+
+	int32 ParseUnary()
+	{
+		const bool bNotKeyword = Peek().Type == FExpressoToken::EType::Identifier && Peek().Text == TEXT("not");
+		if (bNotKeyword)
+			++Position;
+
+		if (bNotKeyword || Match(TEXT("!")))
+		{
+			const int32 operand = ParseUnary();
+			return operand != INDEX_NONE ? AddNode(ENodeKind::Unary, EExpressoOpcode::Not, 0, operand) : INDEX_NONE;
+		}
+
+		if (Match(TEXT("-")))
+		{
+			// a negative constant stays a constant, so comparisons with it are still fused
+			if (Peek().Type == FExpressoToken::EType::Number)
+			{
+				Constants.AddUnique(-Peek().Value);
+				return AddNode(ENodeKind::Constant, EExpressoOpcode::LoadConst, -Tokens[Position++].Value);
+			}
+
+			const int32 operand = ParseUnary();
+			return operand != INDEX_NONE ? AddNode(ENodeKind::Unary, EExpressoOpcode::Negate, 0, operand) : INDEX_NONE;
+		}
+
+		return ParsePrimary();
+	}
+
+	int32 ParsePrimary()
+	{
+		const FExpressoToken& token = Peek();
+		switch (token.Type)
+		{
+		case FExpressoToken::EType::Number:
+			++Position;
+			Constants.AddUnique(token.Value);
+			return AddNode(ENodeKind::Constant, EExpressoOpcode::LoadConst, token.Value);
+
+		case FExpressoToken::EType::Identifier:
+		{
+			++Position;
+			if (token.Text == TEXT("true") || token.Text == TEXT("false"))
+				return AddNode(ENodeKind::Constant, EExpressoOpcode::LoadConst, token.Text == TEXT("true") ? 1 : 0);
+
+			if (IsOperator(TEXT("(")))
+				return FailNode(FString::Printf(TEXT("calls method %s"), *token.Text));
+
+			const int32 variable = Store.FindVariable(token.Text);
+			if (variable == INDEX_NONE)
+				return FailNode(FString::Printf(TEXT("unknown or unsupported variable %s"), *token.Text));
+
+			Variables.AddUnique(variable);
+			return AddNode(ENodeKind::Variable, EExpressoOpcode::LoadVariable, variable);
+		}
+
+		case FExpressoToken::EType::Operator:
+			if (Match(TEXT("(")))
+			{
+				const int32 node = ParseExpression();
+				if (node == INDEX_NONE)
+					return INDEX_NONE;
+				if (!Match(TEXT(")")))
+					return FailNode(TEXT("missing )"));
+				return node;
+			}
+			return FailNode(FString::Printf(TEXT("unexpected %s"), *token.Text));
+
+		case FExpressoToken::EType::String:
+			return FailNode(TEXT("uses a string"));
+
+		default:
+			return FailNode(FString::Printf(TEXT("unexpected %s"), token.Type == FExpressoToken::EType::End ? TEXT("end") : *token.Text));
+		}
+	}
+
+	bool ParseStatement()
+	{
+		const FExpressoToken& target = Peek();
+		if (target.Type != FExpressoToken::EType::Identifier)
+			return Fail(TEXT("statement doesn't start with a variable"));
+
+		++Position;
+		if (IsOperator(TEXT("(")))
+			return Fail(FString::Printf(TEXT("calls method %s"), *target.Text));
+
+		const int32 variable = Store.FindVariable(target.Text);
+		if (variable == INDEX_NONE)
+			return Fail(FString::Printf(TEXT("unknown or unsupported variable %s"), *target.Text));
+		Variables.AddUnique(variable);
+
+		static const TPair<const TCHAR*, EExpressoOpcode> assignments[] = { { TEXT("+="), EExpressoOpcode::Add }, { TEXT("-="), EExpressoOpcode::Subtract },
+			{ TEXT("*="), EExpressoOpcode::Multiply }, { TEXT("/="), EExpressoOpcode::Divide } };
+
+		const TPair<const TCHAR*, EExpressoOpcode>* compound = nullptr;
+		for (const TPair<const TCHAR*, EExpressoOpcode>& assignment : assignments)
+		{
+			if (IsOperator(assignment.Key))
+				compound = &assignment;
+		}
+
+		if (!compound && !IsOperator(TEXT("=")))
+			return Fail(FString::Printf(TEXT("unsupported statement on %s"), *target.Text));
+		++Position;
+
+		const int32 value = ParseExpression();
+		if (value == INDEX_NONE)
+			return false;
+
+		if (compound)
+		{
+			Generate(value, 1);
+			EmitVariable(EExpressoOpcode::LoadVariable, 0, variable);
+			Emit(compound->Value, 0, 0, 1);
+		}
+		else
+			Generate(value, 0);
+
+		EmitVariable(Store.IsBool(variable) ? EExpressoOpcode::StoreBool : EExpressoOpcode::StoreVariable, 0, variable);
+		return Error.IsEmpty();
+	}
+
+	/* True if the node already produces 0 or 1 */
+	bool IsBoolean(int32 Node) const
+	{
+		const FNode& node = Nodes[Node];
+		switch (node.Kind)
+		{
+		case ENodeKind::Constant:
+			return node.Value == 0 || node.Value == 1;
+		case ENodeKind::Variable:
+			return Store.IsBool(node.Value);
+		case ENodeKind::Unary:
+			return node.Op == EExpressoOpcode::Not;
+		default:
+			return node.Op >= EExpressoOpcode::Equal && node.Op <= EExpressoOpcode::Or;
+		}
+	}
+
+	/* Generates the code that puts the value of a node into a register, its operands use the registers above */
+	void Generate(int32 Node, uint32 Register)
+	{
+		if (Register > MAX_uint8)
+		{
+			Fail(TEXT("expression is nested too deep"));
+			return;
+		}
+
+		const FNode& node = Nodes[Node];
+		switch (node.Kind)
+		{
+		case ENodeKind::Constant:
+			EmitConst(EExpressoOpcode::LoadConst, Register, node.Value);
+			return;
+
+		case ENodeKind::Variable:
+			EmitVariable(EExpressoOpcode::LoadVariable, Register, node.Value);
+			return;
+
+		case ENodeKind::Unary:
+			Generate(node.Left, Register);
+			Emit(node.Op, Register, Register);
+			return;
+
+		case ENodeKind::Binary:
+		{
+			const FNode& left = Nodes[node.Left];
+			const FNode& right = Nodes[node.Right];
+			if (node.Op == EExpressoOpcode::Equal || node.Op == EExpressoOpcode::NotEqual)
+			{
+				const FNode* variable = left.Kind == ENodeKind::Variable ? &left : right.Kind == ENodeKind::Variable ? &right : nullptr;
+				const FNode* constant = left.Kind == ENodeKind::Constant ? &left : right.Kind == ENodeKind::Constant ? &right : nullptr;
+				// a bool variable compared with a number other than 0 or 1 is promoted like in C++, the generic path handles that
+				if (variable && constant && (!Store.IsBool(variable->Value) || constant->Value == 0 || constant->Value == 1))
+				{
+					EmitVariable(node.Op == EExpressoOpcode::Equal ? EExpressoOpcode::EqualVariableConst : EExpressoOpcode::NotEqualVariableConst, Register, variable->Value);
+					Code.Add((uint32)constant->Value);
+					return;
+				}
+			}
+
+			Generate(node.Left, Register);
+			Generate(node.Right, Register + 1);
+
+			// the logical operators work bitwise, so their operands have to be 0 or 1
+			if (node.Op == EExpressoOpcode::And || node.Op == EExpressoOpcode::Or)
+			{
+				if (!IsBoolean(node.Left))
+					Emit(EExpressoOpcode::ToBool, Register, Register);
+				if (!IsBoolean(node.Right))
+					Emit(EExpressoOpcode::ToBool, Register + 1, Register + 1);
+			}
+
+			Emit(node.Op, Register, Register, Register + 1);
+			return;
+		}
+		}
+	}
+
+	void Emit(EExpressoOpcode Op, uint32 A, uint32 B = 0, uint32 C = 0)
+	{
+		Code.Add((uint32)Op | (A << 8) | (B << 16) | (C << 24));
+	}
+
+	/* Instructions on a variable keep its 16 bit index in B and C */
+	void EmitVariable(EExpressoOpcode Op, uint32 A, int32 Variable)
+	{
+		if (Variable > MAX_uint16)
+			Fail(TEXT("too many variables"));
+		Code.Add((uint32)Op | (A << 8) | ((uint32)Variable << 16));
+	}
+
+	void EmitConst(EExpressoOpcode Op, uint32 A, int32 Value)
+	{
+		Code.Add((uint32)Op | (A << 8));
+		Code.Add((uint32)Value);
+	}
+
+	const TArray<FExpressoToken>& Tokens;
+	const FExpressoVariableStore& Store;
+	int32 Position = 0;
+	TArray<FNode> Nodes;
+	TArray<uint32> Code;
+};
+
+bool FExpressoCompiler::Compile(const FString& Source, bool bCondition, const FExpressoVariableStore& Store, TArray<uint32>& OutCode, TArray<int32>& OutVariables, TArray<int32>& OutConstants, FString& OutError)
+{
+	TArray<FExpressoToken> tokens;
+	if (!Tokenize(Source, tokens, OutError))
+		return false;
+
+	FExpressoParser parser(tokens, Store);
+	TArray<uint32> code;
+	const bool bCompiled = bCondition ? parser.CompileCondition(code) : parser.CompileInstruction(code);
+	if (!bCompiled)
+	{
+		OutError = parser.Error.IsEmpty() ? TEXT("syntax error") : parser.Error;
+		return false;
+	}
+
+	OutCode.Append(code);
+	OutVariables = MoveTemp(parser.Variables);
+	OutConstants = MoveTemp(parser.Constants);
+	return true;
+}
+
+#pragma endregion
+
+#pragma region VM
+
+int32 FExpressoVM::Run(const uint32* Code, int32* Variables)
+{
+	// every register is written before it is read, so they don't need to be cleared
+	int32 r[256];
+
+	for (const uint32* pc = Code;;)
+	{
+		const uint32 word = *pc++;
+		const uint32 a = (word >> 8) & 0xff;
+		const uint32 b = (word >> 16) & 0xff;
+		const uint32 c = word >> 24;
+		const uint32 variable = word >> 16;
+
+		switch ((EExpressoOpcode)(word & 0xff))
+		{
+		case EExpressoOpcode::LoadConst:				r[a] = (int32)*pc++; break;
+		case EExpressoOpcode::LoadVariable:				r[a] = Variables[variable]; break;
+		case EExpressoOpcode::StoreVariable:			Variables[variable] = r[a]; break;
+		case EExpressoOpcode::StoreBool:				Variables[variable] = r[a] != 0; break;
+		case EExpressoOpcode::EqualVariableConst:		r[a] = Variables[variable] == (int32)*pc++; break;
+		case EExpressoOpcode::NotEqualVariableConst:	r[a] = Variables[variable] != (int32)*pc++; break;
+		case EExpressoOpcode::Not:						r[a] = r[b] == 0; break;
+		case EExpressoOpcode::Negate:					r[a] = -r[b]; break;
+		case EExpressoOpcode::ToBool:					r[a] = r[b] != 0; break;
+		case EExpressoOpcode::Equal:					r[a] = r[b] == r[c]; break;
+		case EExpressoOpcode::NotEqual:					r[a] = r[b] != r[c]; break;
+		case EExpressoOpcode::Less:						r[a] = r[b] < r[c]; break;
+		case EExpressoOpcode::LessEqual:				r[a] = r[b] <= r[c]; break;
+		case EExpressoOpcode::Greater:					r[a] = r[b] > r[c]; break;
+		case EExpressoOpcode::GreaterEqual:				r[a] = r[b] >= r[c]; break;
+		case EExpressoOpcode::And:						r[a] = r[b] & r[c]; break;
+		case EExpressoOpcode::Or:						r[a] = r[b] | r[c]; break;
+		case EExpressoOpcode::Add:						r[a] = r[b] + r[c]; break;
+		case EExpressoOpcode::Subtract:					r[a] = r[b] - r[c]; break;
+		case EExpressoOpcode::Multiply:					r[a] = r[b] * r[c]; break;
+		// a script dividing by zero would crash as a lambda, here it yields 0
+		case EExpressoOpcode::Divide:					r[a] = r[c] != 0 ? r[b] / r[c] : 0; break;
+		case EExpressoOpcode::Modulo:					r[a] = r[c] != 0 ? r[b] % r[c] : 0; break;
+		case EExpressoOpcode::Return:					return r[a];
+		default:
+			checkNoEntry();
+			return 0;
+		}
+	}
+}
+
+#pragma endregion
+
+#pragma region Scripts
+
+void FExpressoBytecodeScripts::Build(UArticyGlobalVariables* GlobalVariables)
+{
+	Code.Reset();
+	Programs.Reset();
+	ConditionPrograms.Reset();
+	InstructionPrograms.Reset();
+	Failures.Reset();
+	Store.Bind(GlobalVariables);
+
+	// the scripts are subobjects of the articy objects, every loaded one belongs to the database
+	for (TObjectIterator<UArticyScriptCondition> it; it; ++it)
+	{
+		const int32 hash = it->GetExpressionHash();
+		if (ConditionPrograms.Contains(hash))
+			continue;
+
+		const int32 program = AddProgram(it->GetExpression(), true);
+		if (program != INDEX_NONE)
+			ConditionPrograms.Add(hash, program);
+	}
+
+	for (TObjectIterator<UArticyScriptInstruction> it; it; ++it)
+	{
+		const int32 hash = it->GetExpressionHash();
+		if (InstructionPrograms.Contains(hash))
+			continue;
+
+		const int32 program = AddProgram(it->GetExpression(), false);
+		if (program != INDEX_NONE)
+			InstructionPrograms.Add(hash, program);
+	}
+
+	Code.Shrink();
+}
+
+int32 FExpressoBytecodeScripts::FindCondition(const UArticyScriptCondition* Condition) const
+{
+	const int32* program = Condition ? ConditionPrograms.Find(Condition->GetExpressionHash()) : nullptr;
+	return program ? *program : INDEX_NONE;
+}
+
+int32 FExpressoBytecodeScripts::FindInstruction(const UArticyScriptInstruction* Instruction) const
+{
+	const int32* program = Instruction ? InstructionPrograms.Find(Instruction->GetExpressionHash()) : nullptr;
+	return program ? *program : INDEX_NONE;
+}
+
+bool FExpressoBytecodeScripts::Evaluate(UArticyScriptCondition* Condition, UObject* MethodProvider)
+{
+	if (!Condition)
+		return true;
+
+	const int32 program = FindCondition(Condition);
+	if (program != INDEX_NONE)
+	{
+		Store.Refresh();
+		return Run(program) != 0;
+	}
+
+	return Condition->Evaluate(Store.GetGlobalVariables(), MethodProvider);
+}
+
+void FExpressoBytecodeScripts::Execute(UArticyScriptInstruction* Instruction, UObject* MethodProvider)
+{
+	if (!Instruction)
+		return;
+
+	const int32 program = FindInstruction(Instruction);
+	if (program != INDEX_NONE)
+	{
+		// only the variables of the program, so the store and the global variables stay the same
+		Store.Refresh();
+		Run(program);
+		Store.Flush(Programs[program].Variables);
+		return;
+	}
+
+	// the lambda changes the global variables directly
+	Instruction->Execute(Store.GetGlobalVariables(), MethodProvider);
+	Store.Invalidate();
+}
+
+int32 FExpressoBytecodeScripts::AddProgram(const FString& Source, bool bCondition)
+{
+	FProgram program;
+	program.Start = Code.Num();
+	program.bCondition = bCondition;
+
+	FString error;
+	if (!FExpressoCompiler::Compile(Source, bCondition, Store, Code, program.Variables, program.Constants, error))
+	{
+		Failures.Emplace(Source, error);
+		return INDEX_NONE;
+	}
+
+	return Programs.Add(MoveTemp(program));
+}
+
+#pragma endregion
+
+#pragma region Comparison
+
+/* The variable states a script is tested with */
+struct FExpressoSampler
+{
+	FExpressoSampler(const FExpressoBytecodeScripts::FProgram& InProgram, const FExpressoVariableStore& Store, int32 Samples)
+		: Program(InProgram)
+	{
+		bExhaustive = Program.Variables.Num() <= 8;
+		for (int32 variable : Program.Variables)
+			bExhaustive &= Store.IsBool(variable);
+
+		NumSamples = bExhaustive ? 1 << Program.Variables.Num() : Samples;
+
+		// ints are tested around the constants of the script, so every comparison can go both ways
+		IntValues.Add(0);
+		for (int32 constant : Program.Constants)
+		{
+			IntValues.AddUnique(constant - 1);
+			IntValues.AddUnique(constant);
+			IntValues.AddUnique(constant + 1);
+		}
+	}
+
+	/* Puts the sample into the store, only touching the variables of the script */
+	void Apply(int32 Sample, FExpressoVariableStore& Store, FRandomStream& Random) const
+	{
+		for (int32 i = 0; i < Program.Variables.Num(); ++i)
+		{
+			const int32 variable = Program.Variables[i];
+			if (bExhaustive)
+				Store.Values[variable] = (Sample >> i) & 1;
+			else if (Store.IsBool(variable))
+				Store.Values[variable] = Random.RandRange(0, 1);
+			else
+				Store.Values[variable] = Random.RandRange(0, 3) == 0 ? Random.RandRange(-100, 100) : IntValues[Random.RandRange(0, IntValues.Num() - 1)];
+		}
+	}
+
+	const FExpressoBytecodeScripts::FProgram& Program;
+	bool bExhaustive = false;
+	int32 NumSamples = 0;
+	TArray<int32> IntValues;
+};
+
+/* The variables of a script and their values, for the log */
+static FString DescribeSample(const FExpressoBytecodeScripts::FProgram& Program, const FExpressoVariableStore& Store, const TArray<int32>& Values)
+{
+	FString description;
+	for (int32 variable : Program.Variables)
+		description += FString::Printf(TEXT("%s%s=%d"), description.IsEmpty() ? TEXT("") : TEXT(", "), *Store.GetName(variable), Values[variable]);
+
+	return description;
+}
+
+FExpressoBytecodeComparison FExpressoBytecodeComparison::Run(FExpressoBytecodeScripts& Scripts, int32 Samples, int32 Seed, int32 MaxDescribedMismatches)
+{
+	FExpressoBytecodeComparison comparison;
+	FExpressoVariableStore& store = Scripts.GetStore();
+	UArticyGlobalVariables* globalVariables = store.GetGlobalVariables();
+	if (!globalVariables)
+		return comparison;
+
+	FRandomStream random(Seed);
+	auto addMismatch = [&comparison, MaxDescribedMismatches](FString&& Description)
+	{
+		if (++comparison.Mismatches <= MaxDescribedMismatches)
+			comparison.Descriptions.Add(MoveTemp(Description));
+	};
+
+	// every expression once, the scripts of many objects share the same one
+	TSet<int32> conditionHashes;
+	for (TObjectIterator<UArticyScriptCondition> it; it; ++it)
+	{
+		bool bAlreadyInSet = false;
+		conditionHashes.Add(it->GetExpressionHash(), &bAlreadyInSet);
+		const int32 program = Scripts.FindCondition(*it);
+		if (bAlreadyInSet || program == INDEX_NONE)
+			continue;
+
+		const FExpressoBytecodeScripts::FProgram& programInfo = Scripts.GetProgram(program);
+		const FExpressoSampler sampler(programInfo, store, Samples);
+		for (int32 sample = 0; sample < sampler.NumSamples; ++sample)
+		{
+			sampler.Apply(sample, store, random);
+			store.Flush();
+
+			const bool bExpected = it->Evaluate(globalVariables, nullptr);
+			const bool bActual = Scripts.Run(program) != 0;
+			++comparison.Samples;
+
+			if (bExpected != bActual)
+			{
+				addMismatch(FString::Printf(TEXT("Condition %s is %s as lambda but %s as bytecode with %s."), *it->GetExpression().TrimStartAndEnd(),
+					bExpected ? TEXT("true") : TEXT("false"), bActual ? TEXT("true") : TEXT("false"), *DescribeSample(programInfo, store, store.Values)));
+			}
+		}
+	}
+
+	TSet<int32> instructionHashes;
+	for (TObjectIterator<UArticyScriptInstruction> it; it; ++it)
+	{
+		bool bAlreadyInSet = false;
+		instructionHashes.Add(it->GetExpressionHash(), &bAlreadyInSet);
+		const int32 program = Scripts.FindInstruction(*it);
+		if (bAlreadyInSet || program == INDEX_NONE)
+			continue;
+
+		const FExpressoBytecodeScripts::FProgram& programInfo = Scripts.GetProgram(program);
+		const FExpressoSampler sampler(programInfo, store, Samples);
+		for (int32 sample = 0; sample < sampler.NumSamples; ++sample)
+		{
+			sampler.Apply(sample, store, random);
+			store.Flush();
+			const TArray<int32> before = store.Values;
+
+			// the bytecode runs on the store, the lambda on the global variables, which are gathered afterwards
+			Scripts.Run(program);
+			const TArray<int32> actual = store.Values;
+			it->Execute(globalVariables, nullptr);
+			store.Gather();
+			++comparison.Samples;
+
+			if (actual != store.Values)
+			{
+				addMismatch(FString::Printf(TEXT("Instruction %s changes the variables differently with %s: %s as lambda, %s as bytecode."), *it->GetExpression().TrimStartAndEnd(),
+					*DescribeSample(programInfo, store, before), *DescribeSample(programInfo, store, store.Values), *DescribeSample(programInfo, store, actual)));
+			}
+		}
+	}
+
+	return comparison;
+}
+
+#pragma endregion
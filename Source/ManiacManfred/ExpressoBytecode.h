@@ -0,0 +1,203 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+
+class UArticyGlobalVariables;
+class UArticyScriptCondition;
+class UArticyScriptInstruction;
+class UArticyVariable;
+
+/* The instructions of the Expresso bytecode. Every instruction is one 32 bit word: the opcode in the low byte, then the registers A, B and C.
+*  Instructions on a variable keep its index in B and C, instructions with a constant are followed by a second word holding it.
+*  Comparisons and logical operators produce 0 or 1, && and || evaluate both sides, since conditions have no side effects.
+*/
+enum class EExpressoOpcode : uint8
+{
+	/* A = constant */
+	LoadConst,
+	/* A = variable */
+	LoadVariable,
+	/* variable = A, StoreBool stores A != 0 */
+	StoreVariable,
+	StoreBool,
+	/* A = variable == constant, the most common condition in one instruction */
+	EqualVariableConst,
+	NotEqualVariableConst,
+	/* A = op B */
+	Not,
+	Negate,
+	ToBool,
+	/* A = B op C */
+	Equal,
+	NotEqual,
+	Less,
+	LessEqual,
+	Greater,
+	GreaterEqual,
+	And,
+	Or,
+	Add,
+	Subtract,
+	Multiply,
+	Divide,
+	Modulo,
+	/* Ends the program, the result of a condition is A */
+	Return,
+};
+
+/* The bool and int variables of the global variables packed into a single array, which is what the bytecode reads and writes.
+*  Gather copies the values of the articy variables into the store, Flush writes the values the bytecode changed back.
+*  Both take the indices of the variables to copy, so values the bytecode didn't touch never overwrite changes made elsewhere.
+*  Once gathered the store stays current as long as only the bytecode changes variables, anything else changing them has to Invalidate it.
+*/
+struct MANIACMANFRED_API FExpressoVariableStore
+{
+public:
+
+	/* Collects the bool and int variables of all namespaces, by the names scripts use for them (e.g. GameState.awake) */
+	void Bind(UArticyGlobalVariables* InGlobalVariables);
+
+	/* Returns the index of a variable, INDEX_NONE if there is none with this name or it is neither bool nor int */
+	int32 FindVariable(const FString& Name) const;
+
+	/* Gathering the whole store makes it current again */
+	void Gather();
+	void Gather(TArrayView<const int32> Indices);
+
+	/* Tells the store the global variables changed behind its back, e.g. by a lambda, a Blueprint or loading a save game */
+	void Invalidate() { bCurrent = false; }
+
+	/* Gathers all variables, but only if the store was invalidated since it last did */
+	void Refresh()
+	{
+		if (!bCurrent)
+			Gather();
+	}
+
+	/* Writes the values that differ from their articy variables back, returns how many were written.
+	*  Flushing the whole store makes it the source of truth for all variables, e.g. when testing scripts with made up values.
+	*/
+	int32 Flush();
+	int32 Flush(TArrayView<const int32> Indices);
+
+	int32 Num() const { return Values.Num(); }
+
+	const FString& GetName(int32 Index) const { return Names[Index]; }
+
+	bool IsBool(int32 Index) const { return BoolVariables[Index]; }
+
+	UArticyGlobalVariables* GetGlobalVariables() const { return GlobalVariables.Get(); }
+
+	TArray<int32> Values;
+
+private:
+
+	TWeakObjectPtr<UArticyGlobalVariables> GlobalVariables;
+	TArray<TWeakObjectPtr<UArticyVariable>> Variables;
+	TArray<FString> Names;
+	TMap<FString, int32> IndexByName;
+	TBitArray<> BoolVariables;
+	bool bCurrent = false;
+
+	void GatherVariable(int32 Index);
+	bool FlushVariable(int32 Index);
+};
+
+/* Turns the source of a condition or instruction into bytecode, the same source the importer turns into the lambdas of the expresso scripts.
+*  Supported are bool and int variables and constants, the arithmetic, comparison and logical operators and the assignments =, +=, -=, *= and /=.
+*  Scripts calling methods (e.g. getProp) or using strings or floats aren't compiled, they keep running as lambdas.
+*/
+struct MANIACMANFRED_API FExpressoCompiler
+{
+public:
+
+	/* Appends the program to OutCode. OutVariables gets the variables the script reads or writes, OutConstants its constants.
+	*  Returns false and leaves OutCode unchanged if the script uses anything unsupported.
+	*/
+	static bool Compile(const FString& Source, bool bCondition, const FExpressoVariableStore& Store, TArray<uint32>& OutCode, TArray<int32>& OutVariables, TArray<int32>& OutConstants, FString& OutError);
+};
+
+/* Runs bytecode against the values of a variable store */
+struct MANIACMANFRED_API FExpressoVM
+{
+public:
+
+	/* Returns the result of a condition, instructions return 0 */
+	static int32 Run(const uint32* Code, int32* Variables);
+};
+
+/* The bytecode of all conditions and instructions of the articy database, in one array, and the variable store they run against.
+*  Scripts that couldn't be compiled are still run as lambdas by Evaluate and Execute.
+*  The store is the source of truth for the bytecode: it is only gathered after it was invalidated, Execute writes the variables of a program through
+*  to the global variables and invalidates the store after running a lambda. Whoever else changes the global variables has to invalidate the store.
+*  Using the bytecode is opt-in, the flow player and the articy objects keep evaluating their scripts as lambdas.
+*/
+class MANIACMANFRED_API FExpressoBytecodeScripts
+{
+public:
+
+	struct FProgram
+	{
+		int32 Start = 0;
+		bool bCondition = true;
+		TArray<int32> Variables;
+		TArray<int32> Constants;
+	};
+
+	/* Binds the store to the global variables and compiles every loaded condition and instruction */
+	void Build(UArticyGlobalVariables* GlobalVariables);
+
+	/* Returns the program of a script, INDEX_NONE if it wasn't compiled */
+	int32 FindCondition(const UArticyScriptCondition* Condition) const;
+	int32 FindInstruction(const UArticyScriptInstruction* Instruction) const;
+
+	bool Evaluate(UArticyScriptCondition* Condition, UObject* MethodProvider = nullptr);
+
+	/* Writes the changed variables back to the global variables */
+	void Execute(UArticyScriptInstruction* Instruction, UObject* MethodProvider = nullptr);
+
+	/* Runs a program against the store as it is, without gathering or flushing any variables */
+	int32 Run(int32 Program) { return FExpressoVM::Run(&Code[Programs[Program].Start], Store.Values.GetData()); }
+
+	const FProgram& GetProgram(int32 Program) const { return Programs[Program]; }
+
+	FExpressoVariableStore& GetStore() { return Store; }
+
+	int32 NumPrograms() const { return Programs.Num(); }
+	int32 NumCodeWords() const { return Code.Num(); }
+
+	/* The scripts that weren't compiled, with the reason */
+	const TArray<TPair<FString, FString>>& GetFailures() const { return Failures; }
+
+private:
+
+	int32 AddProgram(const FString& Source, bool bCondition);
+
+	TArray<uint32> Code;
+	TArray<FProgram> Programs;
+	/* The expression hashes of the scripts, the same keys the expresso scripts use for their lambdas */
+	TMap<int32, int32> ConditionPrograms;
+	TMap<int32, int32> InstructionPrograms;
+	TArray<TPair<FString, FString>> Failures;
+	FExpressoVariableStore Store;
+};
+
+/* Runs every compiled script both as bytecode and as its lambda with the same variable states and compares the results.
+*  Conditions are compared by their result, instructions by the values of all variables afterwards.
+*  The samples are flushed to the global variables the scripts were built with, so they should be a copy nobody else uses.
+*/
+struct MANIACMANFRED_API FExpressoBytecodeComparison
+{
+public:
+
+	/* Samples is the number of variable states per script, scripts on at most 8 bool variables are tested with every combination instead */
+	static FExpressoBytecodeComparison Run(FExpressoBytecodeScripts& Scripts, int32 Samples, int32 Seed, int32 MaxDescribedMismatches = 20);
+
+	int32 Samples = 0;
+	int32 Mismatches = 0;
+
+	/* The first mismatches, with the variable values they occurred with */
+	TArray<FString> Descriptions;
+};
@@ -0,0 +1,133 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#include "ExpressoBytecodeCommandlet.h"
+#include "ExpressoBytecode.h"
+#include "ArticyDatabase.h"
+#include "ArticyScriptFragment.h"
+#include "ArticyGenerated/ManiacManfredGlobalVariables.h"
+#include "UObject/Package.h"
+#include "UObject/UObjectIterator.h"
+
+/* Everything we can pass to the commandlet, see ExpressoBytecodeCommandlet.h */
+struct FExpressoBytecodeOptions
+{
+	int32 Samples = 256;
+	int32 Iterations = 1000;
+	int32 Seed = 1;
+	bool bListFailures = false;
+
+	static FExpressoBytecodeOptions Parse(const FString& Params)
+	{
+		FExpressoBytecodeOptions options;
+		FParse::Value(*Params, TEXT("Samples="), options.Samples);
+		FParse::Value(*Params, TEXT("Iterations="), options.Iterations);
+		FParse::Value(*Params, TEXT("Seed="), options.Seed);
+		options.bListFailures = FParse::Param(*Params, TEXT("ListFailures"));
+
+		options.Samples = FMath::Max(options.Samples, 1);
+		options.Iterations = FMath::Max(options.Iterations, 1);
+
+		return options;
+	}
+};
+
+UExpressoBytecodeCommandlet::UExpressoBytecodeCommandlet()
+{
+	IsClient = false;
+	IsServer = false;
+	IsEditor = true;
+	LogToConsole = true;
+	ShowErrorCount = true;
+}
+
+int32 UExpressoBytecodeCommandlet::Main(const FString& Params)
+{
+	FExpressoBytecodeOptions options = FExpressoBytecodeOptions::Parse(Params);
+
+	// loading the database loads all scripts, they are subobjects of the articy objects
+	if (!UArticyDatabase::GetMutableOriginal())
+	{
+		UE_LOG(LogTemp, Error, TEXT("Could not load the articy database."));
+		return 1;
+	}
+
+	// our own global variables, so the scripts can change them without touching the asset
+	UManiacManfredGlobalVariables* globalVariables = NewObject<UManiacManfredGlobalVariables>(GetTransientPackage());
+
+	FExpressoBytecodeScripts scripts;
+	scripts.Build(globalVariables);
+	FExpressoVariableStore& store = scripts.GetStore();
+
+	TArray<TPair<UArticyScriptCondition*, int32>> conditions;
+	TSet<int32> conditionHashes;
+	for (TObjectIterator<UArticyScriptCondition> it; it; ++it)
+	{
+		bool bAlreadyInSet = false;
+		conditionHashes.Add(it->GetExpressionHash(), &bAlreadyInSet);
+		const int32 program = scripts.FindCondition(*it);
+		if (!bAlreadyInSet && program != INDEX_NONE)
+			conditions.Emplace(*it, program);
+	}
+
+	TArray<TPair<UArticyScriptInstruction*, int32>> instructions;
+	TSet<int32> instructionHashes;
+	for (TObjectIterator<UArticyScriptInstruction> it; it; ++it)
+	{
+		bool bAlreadyInSet = false;
+		instructionHashes.Add(it->GetExpressionHash(), &bAlreadyInSet);
+		const int32 program = scripts.FindInstruction(*it);
+		if (!bAlreadyInSet && program != INDEX_NONE)
+			instructions.Emplace(*it, program);
+	}
+
+	UE_LOG(LogTemp, Display, TEXT("Compiled %d of %d conditions and %d of %d instructions into %d words of bytecode over %d variables."),
+		conditions.Num(), conditionHashes.Num(), instructions.Num(), instructionHashes.Num(), scripts.NumCodeWords(), store.Num());
+
+	if (options.bListFailures)
+	{
+		for (const TPair<FString, FString>& failure : scripts.GetFailures())
+			UE_LOG(LogTemp, Display, TEXT("Not compiled (%s): %s"), *failure.Value, *failure.Key.TrimStartAndEnd().Replace(TEXT("\n"), TEXT(" ")));
+	}
+
+	const FExpressoBytecodeComparison comparison = FExpressoBytecodeComparison::Run(scripts, options.Samples, options.Seed);
+	for (const FString& description : comparison.Descriptions)
+		UE_LOG(LogTemp, Error, TEXT("%s"), *description);
+
+	// both paths evaluate the same conditions with the same variables, the store is current after flushing it, like at runtime when nothing changes the variables behind its back.
+	// The xor keeps the compiler from dropping either loop.
+	for (int32& value : store.Values)
+		value = 0;
+	store.Flush();
+	int32 lambdaResults = 0;
+	int32 bytecodeResults = 0;
+
+	const double lambdaStart = FPlatformTime::Seconds();
+	for (int32 iteration = 0; iteration < options.Iterations; ++iteration)
+	{
+		for (const TPair<UArticyScriptCondition*, int32>& condition : conditions)
+			lambdaResults ^= condition.Key->Evaluate(globalVariables, nullptr) ? 1 : 0;
+	}
+	const double lambdaSeconds = FPlatformTime::Seconds() - lambdaStart;
+
+	const double bytecodeStart = FPlatformTime::Seconds();
+	for (int32 iteration = 0; iteration < options.Iterations; ++iteration)
+	{
+		for (const TPair<UArticyScriptCondition*, int32>& condition : conditions)
+			bytecodeResults ^= scripts.Evaluate(condition.Key) ? 1 : 0;
+	}
+	const double bytecodeSeconds = FPlatformTime::Seconds() - bytecodeStart;
+
+	const int32 evaluations = FMath::Max(conditions.Num() * options.Iterations, 1);
+	UE_LOG(LogTemp, Display, TEXT("Evaluating a condition takes %.1f ns as lambda and %.1f ns as bytecode (%.1fx)%s."),
+		lambdaSeconds * 1e9 / evaluations, bytecodeSeconds * 1e9 / evaluations, bytecodeSeconds > 0 ? lambdaSeconds / bytecodeSeconds : 0.0,
+		lambdaResults != bytecodeResults ? TEXT(", the results differ") : TEXT(""));
+
+	if (comparison.Mismatches > 0)
+	{
+		UE_LOG(LogTemp, Error, TEXT("%d of %d samples gave different results."), comparison.Mismatches, comparison.Samples);
+		return 1;
+	}
+
+	UE_LOG(LogTemp, Display, TEXT("All %d samples gave the same results."), comparison.Samples);
+	return 0;
+}
@@ -0,0 +1,31 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Commandlets/Commandlet.h"
+#include "ExpressoBytecodeCommandlet.generated.h"
+
+/* Compiles every condition and instruction of the articy database to Expresso bytecode and checks that the VM gives the same results as the generated lambdas.
+*
+*  UnrealEditor-Cmd ManiacManfred.uproject -run=ExpressoBytecode -nullrhi -unattended [options]
+*
+*  -Samples=256        variable states tested per script, scripts on at most 8 bool variables are tested with every combination instead
+*  -Iterations=1000    how often all conditions are evaluated for the timing of both paths
+*  -Seed=1             seed for the random variable states
+*  -ListFailures       also lists the scripts that weren't compiled and why, they keep running as lambdas
+*
+*  Conditions are compared by their result, instructions by the values of all variables afterwards.
+*  Returns 1 if any script gave a different result, the first mismatches are logged with the variable values they occurred with.
+*/
+UCLASS()
+class MANIACMANFRED_API UExpressoBytecodeCommandlet : public UCommandlet
+{
+	GENERATED_BODY()
+
+public:
+
+	UExpressoBytecodeCommandlet();
+
+	virtual int32 Main(const FString& Params) override;
+};
@@ -0,0 +1,667 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#include "GenerateLocationsCommandlet.h"
+#include "LocationCookedLayout.h"
+#include "LocationGenerator.h"
+#include "LocationLayout.h"
+#include "LocationOverdraw.h"
+#include "LocationTextureBudget.h"
+#include "ArticyDatabase.h"
+#include "Engine/World.h"
+#include "EngineUtils.h"
+#include "HAL/PlatformProcess.h"
+#include "Misc/FileHelper.h"
+#include "Misc/PackageName.h"
+#include "Misc/Paths.h"
+#include "UObject/Package.h"
+#include "UObject/SavePackage.h"
+#include "UObject/UObjectIterator.h"
+#include "Dom/JsonObject.h"
+#include "Serialization/JsonReader.h"
+#include "Serialization/JsonSerializer.h"
+#include "Serialization/JsonWriter.h"
+
+/* Everything we can pass to the commandlet, see GenerateLocationsCommandlet.h */
+struct FGenerateLocationsOptions
+{
+	TArray<FString> Locations;
+	int32 Workers = 1;
+	bool bReconcile = false;
+	bool bSave = true;
+	FString MapPath = TEXT("/Game/Maps");
+	/* 0 means we use the value stored in the generator actor of the map */
+	float PixelsToUnits = 0;
+	/* 0 means the colliders aren't simplified */
+	float ColliderSimplifyTolerance = 0;
+	bool bDecomposeColliders = false;
+	/* 0 means the images aren't packed into atlases */
+	int32 MaxAtlasSize = 0;
+	int32 AtlasPadding = 2;
+	bool bTightSprites = false;
+	float SpriteAlphaThreshold = 0;
+	bool bClassifyAlpha = false;
+	float MaskedAlphaTolerance = 0.01f;
+	bool bBatchStaticImages = false;
+	bool bLightweightObjects = false;
+	bool bStreamTextures = false;
+	/* Empty means the textures aren't touched */
+	TArray<FIntPoint> TargetResolutions;
+	float MaxCameraZoom = 1;
+	/* Zero means the overdraw isn't analyzed */
+	FIntPoint OverdrawResolution = FIntPoint::ZeroValue;
+	/* Zero means any overdraw is accepted */
+	float MaxOverdraw = 0;
+	bool bWriteBinaryLayout = false;
+	/* Empty means the locations aren't baked */
+	FString BakePath;
+	FString ReportFile;
+
+	/* Parses a resolution like 1920x1080 */
+	static bool ParseResolution(const FString& Resolution, FIntPoint& OutResolution)
+	{
+		FString width, height;
+		if (!Resolution.Split(TEXT("x"), &width, &height))
+			return false;
+
+		OutResolution = FIntPoint(FCString::Atoi(*width), FCString::Atoi(*height));
+		return true;
+	}
+
+	static FGenerateLocationsOptions Parse(const FString& Params)
+	{
+		FGenerateLocationsOptions options;
+
+		FString locations;
+		if (FParse::Value(*Params, TEXT("Locations="), locations, false))
+			locations.ParseIntoArray(options.Locations, TEXT("+"));
+
+		FParse::Value(*Params, TEXT("Workers="), options.Workers);
+		FParse::Value(*Params, TEXT("MapPath="), options.MapPath);
+		FParse::Value(*Params, TEXT("BakePath="), options.BakePath);
+		FParse::Value(*Params, TEXT("PixelsToUnits="), options.PixelsToUnits);
+		FParse::Value(*Params, TEXT("SimplifyColliders="), options.ColliderSimplifyTolerance);
+		FParse::Value(*Params, TEXT("PackAtlas="), options.MaxAtlasSize);
+		FParse::Value(*Params, TEXT("AtlasPadding="), options.AtlasPadding);
+		FParse::Value(*Params, TEXT("MaxCameraZoom="), options.MaxCameraZoom);
+		FParse::Value(*Params, TEXT("SpriteAlphaThreshold="), options.SpriteAlphaThreshold);
+		FParse::Value(*Params, TEXT("MaskedAlphaTolerance="), options.MaskedAlphaTolerance);
+
+		FString targetResolutions;
+		if (FParse::Value(*Params, TEXT("TextureBudget="), targetResolutions, false))
+		{
+			TArray<FString> resolutionStrings;
+			targetResolutions.ParseIntoArray(resolutionStrings, TEXT("+"));
+			for (auto& resolution : resolutionStrings)
+			{
+				FIntPoint targetResolution;
+				if (ParseResolution(resolution, targetResolution))
+					options.TargetResolutions.Add(targetResolution);
+			}
+		}
+
+		FString overdrawResolution;
+		if (FParse::Value(*Params, TEXT("Overdraw="), overdrawResolution, false))
+			ParseResolution(overdrawResolution, options.OverdrawResolution);
+		FParse::Value(*Params, TEXT("MaxOverdraw="), options.MaxOverdraw);
+
+		options.bReconcile = FParse::Param(*Params, TEXT("Reconcile"));
+		options.bDecomposeColliders = FParse::Param(*Params, TEXT("DecomposeColliders"));
+		options.bTightSprites = FParse::Param(*Params, TEXT("TightSprites"));
+		options.bClassifyAlpha = FParse::Param(*Params, TEXT("ClassifyAlpha"));
+		options.bBatchStaticImages = FParse::Param(*Params, TEXT("BatchStaticImages"));
+		options.bLightweightObjects = FParse::Param(*Params, TEXT("LightweightObjects"));
+		options.bStreamTextures = FParse::Param(*Params, TEXT("StreamTextures"));
+		options.bWriteBinaryLayout = FParse::Param(*Params, TEXT("WriteBinaryLayout"));
+		options.bSave = !FParse::Param(*Params, TEXT("NoSave"));
+
+		if (!FParse::Value(*Params, TEXT("Report="), options.ReportFile))
+			options.ReportFile = FPaths::ProjectLogDir() / TEXT("GenerateLocations.json");
+		options.ReportFile = FPaths::ConvertRelativePathToFull(options.ReportFile);
+
+		return options;
+	}
+
+	/* The command line for a worker process which generates only the given locations and writes its own report */
+	FString ToWorkerParams(const TArray<FString>& WorkerLocations, const FString& WorkerReportFile) const
+	{
+		FString params = FString::Printf(TEXT("\"%s\" -run=GenerateLocations -Locations=%s -Workers=1 -MapPath=%s -Report=\"%s\""),
+			*FPaths::ConvertRelativePathToFull(FPaths::GetProjectFilePath()), *FString::Join(WorkerLocations, TEXT("+")), *MapPath, *WorkerReportFile);
+
+		if (PixelsToUnits > 0)
+			params += FString::Printf(TEXT(" -PixelsToUnits=%f"), PixelsToUnits);
+		if (ColliderSimplifyTolerance > 0)
+			params += FString::Printf(TEXT(" -SimplifyColliders=%f"), ColliderSimplifyTolerance);
+		if (bDecomposeColliders)
+			params += TEXT(" -DecomposeColliders");
+		if (MaxAtlasSize > 0)
+			params += FString::Printf(TEXT(" -PackAtlas=%d -AtlasPadding=%d"), MaxAtlasSize, AtlasPadding);
+		if (bTightSprites)
+			params += FString::Printf(TEXT(" -TightSprites -SpriteAlphaThreshold=%f"), SpriteAlphaThreshold);
+		if (bClassifyAlpha)
+			params += FString::Printf(TEXT(" -ClassifyAlpha -MaskedAlphaTolerance=%f"), MaskedAlphaTolerance);
+		if (bBatchStaticImages)
+			params += TEXT(" -BatchStaticImages");
+		if (bLightweightObjects)
+			params += TEXT(" -LightweightObjects");
+		if (bStreamTextures)
+			params += TEXT(" -StreamTextures");
+		if (TargetResolutions.Num() > 0)
+		{
+			TArray<FString> resolutionStrings;
+			for (const FIntPoint& resolution : TargetResolutions)
+				resolutionStrings.Add(FString::Printf(TEXT("%dx%d"), resolution.X, resolution.Y));
+			params += FString::Printf(TEXT(" -TextureBudget=%s -MaxCameraZoom=%f"), *FString::Join(resolutionStrings, TEXT("+")), MaxCameraZoom);
+		}
+		if (OverdrawResolution.X > 0 && OverdrawResolution.Y > 0)
+			params += FString::Printf(TEXT(" -Overdraw=%dx%d -MaxOverdraw=%f"), OverdrawResolution.X, OverdrawResolution.Y, MaxOverdraw);
+		if (bWriteBinaryLayout)
+			params += TEXT(" -WriteBinaryLayout");
+		if (!BakePath.IsEmpty())
+			params += FString::Printf(TEXT(" -BakePath=%s"), *BakePath);
+		if (bReconcile)
+			params += TEXT(" -Reconcile");
+		if (!bSave)
+			params += TEXT(" -NoSave");
+
+		return params + TEXT(" -nullrhi -unattended -nopause -nosplash");
+	}
+};
+
+/* What happened to a single location, one entry of the report */
+struct FLocationGenerationReport
+{
+	FString Location;
+	FString Map;
+	/* The cooked layout asset, empty if the location wasn't baked */
+	FString CookedLayout;
+	bool bSuccess = false;
+	FString Error;
+
+	double LoadSeconds = 0;
+	double GenerateSeconds = 0;
+	double SaveSeconds = 0;
+
+	int32 ArticyObjects = 0;
+	int32 Actors = 0;
+	int32 CreatedActors = 0;
+	int32 DeletedActors = 0;
+
+	/* Estimated memory of the textures of the location images before and after the texture budget pass */
+	int64 TextureBytesBefore = 0;
+	int64 TextureBytesAfter = 0;
+	int32 ChangedTextures = 0;
+
+	/* Pixels shaded per frame by the location images, without and with the conditional layers, and the heat map of the latter */
+	double ShadedPixels = 0;
+	double WorstCaseShadedPixels = 0;
+	float Overdraw = 0;
+	FString OverdrawHeatMap;
+
+	TSharedRef<FJsonObject> ToJson() const
+	{
+		auto json = MakeShared<FJsonObject>();
+		json->SetStringField(TEXT("location"), Location);
+		json->SetStringField(TEXT("map"), Map);
+		json->SetStringField(TEXT("cookedLayout"), CookedLayout);
+		json->SetBoolField(TEXT("success"), bSuccess);
+		json->SetStringField(TEXT("error"), Error);
+		json->SetNumberField(TEXT("loadSeconds"), LoadSeconds);
+		json->SetNumberField(TEXT("generateSeconds"), GenerateSeconds);
+		json->SetNumberField(TEXT("saveSeconds"), SaveSeconds);
+		json->SetNumberField(TEXT("articyObjects"), ArticyObjects);
+		json->SetNumberField(TEXT("actors"), Actors);
+		json->SetNumberField(TEXT("createdActors"), CreatedActors);
+		json->SetNumberField(TEXT("deletedActors"), DeletedActors);
+		json->SetNumberField(TEXT("textureBytesBefore"), TextureBytesBefore);
+		json->SetNumberField(TEXT("textureBytesAfter"), TextureBytesAfter);
+		json->SetNumberField(TEXT("changedTextures"), ChangedTextures);
+		json->SetNumberField(TEXT("shadedPixels"), ShadedPixels);
+		json->SetNumberField(TEXT("worstCaseShadedPixels"), WorstCaseShadedPixels);
+		json->SetNumberField(TEXT("overdraw"), Overdraw);
+		json->SetStringField(TEXT("overdrawHeatMap"), OverdrawHeatMap);
+		return json;
+	}
+
+	static FLocationGenerationReport FromJson(const FJsonObject& Json)
+	{
+		FLocationGenerationReport report;
+		report.Location = Json.GetStringField(TEXT("location"));
+		report.Map = Json.GetStringField(TEXT("map"));
+		report.CookedLayout = Json.GetStringField(TEXT("cookedLayout"));
+		report.bSuccess = Json.GetBoolField(TEXT("success"));
+		report.Error = Json.GetStringField(TEXT("error"));
+		report.LoadSeconds = Json.GetNumberField(TEXT("loadSeconds"));
+		report.GenerateSeconds = Json.GetNumberField(TEXT("generateSeconds"));
+		report.SaveSeconds = Json.GetNumberField(TEXT("saveSeconds"));
+		report.ArticyObjects = (int32)Json.GetNumberField(TEXT("articyObjects"));
+		report.Actors = (int32)Json.GetNumberField(TEXT("actors"));
+		report.CreatedActors = (int32)Json.GetNumberField(TEXT("createdActors"));
+		report.DeletedActors = (int32)Json.GetNumberField(TEXT("deletedActors"));
+		report.TextureBytesBefore = (int64)Json.GetNumberField(TEXT("textureBytesBefore"));
+		report.TextureBytesAfter = (int64)Json.GetNumberField(TEXT("textureBytesAfter"));
+		report.ChangedTextures = (int32)Json.GetNumberField(TEXT("changedTextures"));
+		report.ShadedPixels = Json.GetNumberField(TEXT("shadedPixels"));
+		report.WorstCaseShadedPixels = Json.GetNumberField(TEXT("worstCaseShadedPixels"));
+		report.Overdraw = (float)Json.GetNumberField(TEXT("overdraw"));
+		report.OverdrawHeatMap = Json.GetStringField(TEXT("overdrawHeatMap"));
+		return report;
+	}
+};
+
+#if WITH_EDITOR
+
+/* The actor inside a map which triggers the generation (the Location Blueprint) and the values it would pass to the generator */
+struct FLocationGeneratorActor
+{
+	AActor* Actor = nullptr;
+	TMap<TSubclassOf<class UArticyBaseObject>, TSubclassOf<class UActorComponent>> ObjectComponentMap;
+	float PixelsToUnits = 1;
+};
+
+/* The generator actor is a Blueprint, so we look for the actor which has an articy type to component map and a PixelsToUnits variable */
+static bool FindGeneratorActor(UWorld* World, FLocationGeneratorActor& OutGenerator)
+{
+	for (TActorIterator<AActor> it(World); it; ++it)
+	{
+		AActor* actor = *it;
+		FNumericProperty* pixelsToUnitsProp = CastField<FNumericProperty>(actor->GetClass()->FindPropertyByName(TEXT("PixelsToUnits")));
+		if (!pixelsToUnitsProp || !pixelsToUnitsProp->IsFloatingPoint())
+			continue;
+
+		for (TFieldIterator<FMapProperty> propIt(actor->GetClass()); propIt; ++propIt)
+		{
+			FMapProperty* mapProp = *propIt;
+			auto keyProp = CastField<FClassProperty>(mapProp->KeyProp);
+			auto valueProp = CastField<FClassProperty>(mapProp->ValueProp);
+			if (!keyProp || !valueProp || !keyProp->MetaClass->IsChildOf(UArticyBaseObject::StaticClass()) || !valueProp->MetaClass->IsChildOf(UActorComponent::StaticClass()))
+				continue;
+
+			OutGenerator.Actor = actor;
+			OutGenerator.PixelsToUnits = (float)pixelsToUnitsProp->GetFloatingPointPropertyValue(pixelsToUnitsProp->ContainerPtrToValuePtr<void>(actor));
+
+			FScriptMapHelper mapHelper(mapProp, mapProp->ContainerPtrToValuePtr<void>(actor));
+			for (int32 i = 0; i < mapHelper.GetMaxIndex(); ++i)
+			{
+				if (!mapHelper.IsValidIndex(i))
+					continue;
+
+				auto key = Cast<UClass>(keyProp->GetObjectPropertyValue(mapHelper.GetKeyPtr(i)));
+				auto value = Cast<UClass>(valueProp->GetObjectPropertyValue(mapHelper.GetValuePtr(i)));
+				if (key && value)
+					OutGenerator.ObjectComponentMap.Add(key, value);
+			}
+
+			return true;
+		}
+	}
+
+	return false;
+}
+
+/* Same hierarchy the LocationGenerator uses, generated actors are owned by their parent */
+static void CollectOwnedActors(AActor* Actor, TArray<AActor*>& OutActors)
+{
+	for (auto child : Actor->Children)
+	{
+		OutActors.Add(child);
+		CollectOwnedActors(child, OutActors);
+	}
+}
+
+/* Bakes a location with the same values it was generated with into its cooked layout asset, returns false if the asset couldn't be saved */
+static bool BakeCookedLayout(UManiacManfredLocation* Location, const FGenerateLocationsOptions& Options, const FLocationGeneratorActor& Generator, const FLocationGeneratorSettings& Settings, float PixelsToUnits, FLocationGenerationReport& Report)
+{
+	Report.CookedLayout = Options.BakePath / (Report.Location + TEXT("_Layout"));
+	const FString assetName = FPackageName::GetLongPackageAssetName(Report.CookedLayout);
+
+	UPackage* package = FPackageName::DoesPackageExist(Report.CookedLayout) ? LoadPackage(nullptr, *Report.CookedLayout, LOAD_None) : CreatePackage(*Report.CookedLayout);
+	ULocationCookedLayout* cookedLayout = package ? FindObject<ULocationCookedLayout>(package, *assetName) : nullptr;
+	if (package && !cookedLayout)
+		cookedLayout = NewObject<ULocationCookedLayout>(package, *assetName, RF_Public | RF_Standalone);
+	if (!cookedLayout)
+		return false;
+
+	// the sprites of the map belong to the map, the cooked layout needs its own, the textures were already sized when generating
+	FLocationGeneratorSettings settings = Settings;
+	settings.SpriteCache = nullptr;
+	settings.bOptimizeTextureBudget = false;
+	ULocationGenerator::BakeLocation(Location, PixelsToUnits, Generator.ObjectComponentMap, settings, cookedLayout);
+
+	if (!Options.bSave)
+		return true;
+
+	FSavePackageArgs saveArgs;
+	saveArgs.TopLevelFlags = RF_Public | RF_Standalone;
+	saveArgs.Error = GWarn;
+	FString filename = FPackageName::LongPackageNameToFilename(Report.CookedLayout, FPackageName::GetAssetPackageExtension());
+	return UPackage::SavePackage(package, cookedLayout, *filename, saveArgs);
+}
+
+/* Saves the textures the texture budget pass changed, returns false if any of them couldn't be saved */
+static bool SaveChangedTextures(const FLocationTextureBudgetReport& TextureBudget)
+{
+	bool bSaved = true;
+	for (const FLocationTextureBudgetEntry& entry : TextureBudget.Entries)
+	{
+		UTexture2D* texture = entry.bChanged ? FindObject<UTexture2D>(nullptr, *entry.Texture) : nullptr;
+		if (!texture)
+			continue;
+
+		FSavePackageArgs saveArgs;
+		saveArgs.TopLevelFlags = RF_Public | RF_Standalone;
+		saveArgs.Error = GWarn;
+		UPackage* package = texture->GetOutermost();
+		FString filename = FPackageName::LongPackageNameToFilename(package->GetName(), FPackageName::GetAssetPackageExtension());
+		bSaved &= UPackage::SavePackage(package, texture, *filename, saveArgs);
+	}
+	return bSaved;
+}
+
+/* Loads the map of a location, generates the location into it and saves it again */
+static FLocationGenerationReport GenerateLocationInMap(UManiacManfredLocation* Location, const FGenerateLocationsOptions& Options)
+{
+	FLocationGenerationReport report;
+	report.Location = Location->GetTechnicalName().ToString();
+	report.Map = Options.MapPath / report.Location;
+
+	FLocationLayout layout;
+	layout.Build(Location);
+	report.ArticyObjects = layout.Num();
+
+	if (!FPackageName::DoesPackageExist(report.Map))
+	{
+		report.Error = TEXT("There is no map for this location.");
+		return report;
+	}
+
+	double startTime = FPlatformTime::Seconds();
+	UPackage* package = LoadPackage(nullptr, *report.Map, LOAD_None);
+	UWorld* world = package ? UWorld::FindWorldInPackage(package) : nullptr;
+	if (!world)
+	{
+		report.Error = TEXT("Could not load the map.");
+		return report;
+	}
+
+	world->WorldType = EWorldType::Editor;
+	world->AddToRoot();
+	if (!world->bIsWorldInitialized)
+		world->InitWorld(UWorld::InitializationValues().AllowAudioPlayback(false).CreateNavigation(false).CreateAISystem(false).ShouldSimulatePhysics(false));
+	world->UpdateWorldComponents(true, false);
+	report.LoadSeconds = FPlatformTime::Seconds() - startTime;
+
+	FLocationGeneratorActor generator;
+	if (FindGeneratorActor(world, generator))
+	{
+		TArray<AActor*> previousActors;
+		CollectOwnedActors(generator.Actor, previousActors);
+		TArray<TWeakObjectPtr<AActor>> previousWeakActors(previousActors);
+
+		FLocationGeneratorSettings settings;
+		settings.bReconcileExistingActors = Options.bReconcile;
+		settings.bSimplifyColliders = Options.ColliderSimplifyTolerance > 0;
+		settings.ColliderSimplifyTolerance = Options.ColliderSimplifyTolerance;
+		settings.bDecomposeColliders = Options.bDecomposeColliders;
+		settings.bPackSpriteAtlas = Options.MaxAtlasSize > 0;
+		settings.MaxAtlasSize = Options.MaxAtlasSize > 0 ? Options.MaxAtlasSize : settings.MaxAtlasSize;
+		settings.AtlasPadding = Options.AtlasPadding;
+		settings.bTightSpriteGeometry = Options.bTightSprites;
+		settings.SpriteAlphaThreshold = Options.SpriteAlphaThreshold;
+		settings.bClassifyImageAlpha = Options.bClassifyAlpha;
+		settings.MaskedAlphaTolerance = Options.MaskedAlphaTolerance;
+		settings.bBatchStaticImages = Options.bBatchStaticImages;
+		settings.bLightweightObjects = Options.bLightweightObjects;
+		settings.bStreamTexturesAsync = Options.bStreamTextures;
+		settings.bWriteBinaryLayout = Options.bWriteBinaryLayout;
+		settings.bOptimizeTextureBudget = Options.TargetResolutions.Num() > 0;
+		settings.TargetResolutions = Options.TargetResolutions;
+		settings.MaxCameraZoom = Options.MaxCameraZoom;
+		FLocationTextureBudgetReport textureBudget;
+		settings.TextureBudgetReport = &textureBudget;
+		settings.bAnalyzeOverdraw = Options.OverdrawResolution.X > 0 && Options.OverdrawResolution.Y > 0;
+		settings.OverdrawResolution = Options.OverdrawResolution;
+		FLocationOverdrawResult overdraw;
+		settings.OverdrawResult = &overdraw;
+		float pixelsToUnits = Options.PixelsToUnits > 0 ? Options.PixelsToUnits : generator.PixelsToUnits;
+
+		startTime = FPlatformTime::Seconds();
+		UManiacManfredLocationImage* backgroundLayer = nullptr;
+		ULocationGenerator::GenerateLocationWithSettings(Location, pixelsToUnits, generator.ObjectComponentMap, settings, generator.Actor, backgroundLayer);
+		report.GenerateSeconds = FPlatformTime::Seconds() - startTime;
+
+		TArray<AActor*> actors;
+		CollectOwnedActors(generator.Actor, actors);
+		TSet<AActor*> previousActorSet(previousActors);
+		report.Actors = actors.Num();
+		report.CreatedActors = actors.FilterByPredicate([&](AActor* Actor) { return !previousActorSet.Contains(Actor); }).Num();
+		report.DeletedActors = previousWeakActors.FilterByPredicate([](const TWeakObjectPtr<AActor>& Actor) { return !Actor.IsValid(); }).Num();
+		report.TextureBytesBefore = textureBudget.GetBytesBefore();
+		report.TextureBytesAfter = textureBudget.GetBytesAfter();
+		report.ChangedTextures = textureBudget.GetChangedTextures();
+		if (settings.bAnalyzeOverdraw)
+		{
+			report.ShadedPixels = overdraw.ShadedPixels;
+			report.WorstCaseShadedPixels = overdraw.WorstCaseShadedPixels;
+			report.Overdraw = overdraw.GetAverageOverdraw(true);
+			report.OverdrawHeatMap = FPaths::ConvertRelativePathToFull(FLocationOverdraw::GetDefaultHeatMapFilename(Location->GetTechnicalName()));
+		}
+
+		const bool bBaked = Options.BakePath.IsEmpty() || BakeCookedLayout(Location, Options, generator, settings, pixelsToUnits, report);
+
+		if (Options.bSave)
+		{
+			startTime = FPlatformTime::Seconds();
+			FSavePackageArgs saveArgs;
+			saveArgs.TopLevelFlags = RF_Standalone;
+			saveArgs.Error = GWarn;
+			FString filename = FPackageName::LongPackageNameToFilename(report.Map, FPackageName::GetMapPackageExtension());
+			report.bSuccess = UPackage::SavePackage(package, world, *filename, saveArgs);
+			report.SaveSeconds = FPlatformTime::Seconds() - startTime;
+
+			if (!report.bSuccess)
+				report.Error = FString::Printf(TEXT("Could not save %s."), *filename);
+		}
+		else
+			report.bSuccess = true;
+
+		if (Options.bSave && !SaveChangedTextures(textureBudget))
+		{
+			report.bSuccess = false;
+			report.Error = TEXT("Could not save the textures changed by the texture budget.");
+		}
+
+		if (!bBaked)
+		{
+			report.bSuccess = false;
+			report.Error = FString::Printf(TEXT("Could not bake %s."), *report.CookedLayout);
+		}
+
+		// the level budget, so CI fails before the art lands
+		if (settings.bAnalyzeOverdraw && Options.MaxOverdraw > 0 && report.Overdraw > Options.MaxOverdraw)
+		{
+			report.bSuccess = false;
+			report.Error = FString::Printf(TEXT("Overdraw of %.2f exceeds the budget of %.2f, see %s."), report.Overdraw, Options.MaxOverdraw, *report.OverdrawHeatMap);
+		}
+	}
+	else
+		report.Error = TEXT("The map contains no actor with a PixelsToUnits variable and an articy type to component map.");
+
+	if (world->bIsWorldInitialized)
+		world->CleanupWorld();
+	world->RemoveFromRoot();
+	CollectGarbage(GARBAGE_COLLECTION_KEEPFLAGS);
+
+	return report;
+}
+
+static bool ReadReportFile(const FString& Filename, TArray<FLocationGenerationReport>& OutReports)
+{
+	FString content;
+	if (!FFileHelper::LoadFileToString(content, *Filename))
+		return false;
+
+	TSharedPtr<FJsonObject> json;
+	if (!FJsonSerializer::Deserialize(TJsonReaderFactory<>::Create(content), json) || !json.IsValid())
+		return false;
+
+	for (auto& entry : json->GetArrayField(TEXT("locations")))
+		OutReports.Add(FLocationGenerationReport::FromJson(*entry->AsObject()));
+
+	return true;
+}
+
+static void WriteReportFile(const FString& Filename, const TArray<FLocationGenerationReport>& Reports, int32 Workers, double TotalSeconds)
+{
+	auto json = MakeShared<FJsonObject>();
+	json->SetNumberField(TEXT("workers"), Workers);
+	json->SetNumberField(TEXT("totalSeconds"), TotalSeconds);
+
+	TArray<TSharedPtr<FJsonValue>> locations;
+	for (auto& report : Reports)
+		locations.Add(MakeShared<FJsonValueObject>(report.ToJson()));
+	json->SetArrayField(TEXT("locations"), locations);
+
+	FString content;
+	FJsonSerializer::Serialize(json, TJsonWriterFactory<>::Create(&content));
+	FFileHelper::SaveStringToFile(content, *Filename);
+}
+
+/* Splits the locations round robin across worker processes and collects their reports */
+static void RunWorkers(const FGenerateLocationsOptions& Options, const TArray<FString>& Locations, int32 Workers, TArray<FLocationGenerationReport>& OutReports)
+{
+	TArray<TArray<FString>> workerLocations;
+	workerLocations.SetNum(Workers);
+	for (int32 i = 0; i < Locations.Num(); ++i)
+		workerLocations[i % Workers].Add(Locations[i]);
+
+	TArray<FProcHandle> processes;
+	TArray<FString> reportFiles;
+	for (int32 i = 0; i < Workers; ++i)
+	{
+		FString reportFile = FPaths::ConvertRelativePathToFull(FPaths::ProjectSavedDir() / TEXT("Temp") / FString::Printf(TEXT("GenerateLocations_Worker%d.json"), i));
+		IFileManager::Get().Delete(*reportFile);
+
+		FString params = Options.ToWorkerParams(workerLocations[i], reportFile);
+		UE_LOG(LogTemp, Display, TEXT("Starting worker %d for %s"), i, *FString::Join(workerLocations[i], TEXT(", ")));
+
+		processes.Add(FPlatformProcess::CreateProc(FPlatformProcess::ExecutablePath(), *params, false, true, true, nullptr, 0, nullptr, nullptr));
+		reportFiles.Add(reportFile);
+	}
+
+	for (int32 i = 0; i < Workers; ++i)
+	{
+		int32 returnCode = -1;
+		if (processes[i].IsValid())
+		{
+			FPlatformProcess::WaitForProc(processes[i]);
+			FPlatformProcess::GetProcReturnCode(processes[i], &returnCode);
+			FPlatformProcess::CloseProc(processes[i]);
+		}
+
+		// a worker which crashed doesn't leave a report, so we have to report its locations as failed
+		if (!ReadReportFile(reportFiles[i], OutReports))
+		{
+			for (auto& location : workerLocations[i])
+			{
+				FLocationGenerationReport report;
+				report.Location = location;
+				report.Map = Options.MapPath / location;
+				report.Error = FString::Printf(TEXT("Worker %d failed with exit code %d."), i, returnCode);
+				OutReports.Add(report);
+			}
+		}
+	}
+}
+
+#endif // WITH_EDITOR
+
+UGenerateLocationsCommandlet::UGenerateLocationsCommandlet()
+{
+	IsClient = false;
+	IsServer = false;
+	IsEditor = true;
+	LogToConsole = true;
+	ShowErrorCount = true;
+}
+
+int32 UGenerateLocationsCommandlet::Main(const FString& Params)
+{
+#if WITH_EDITOR
+
+	const double startTime = FPlatformTime::Seconds();
+	FGenerateLocationsOptions options = FGenerateLocationsOptions::Parse(Params);
+
+	UArticyDatabase* database = UArticyDatabase::GetMutableOriginal();
+	if (!database)
+	{
+		UE_LOG(LogTemp, Error, TEXT("Could not load the articy database."));
+		return 1;
+	}
+
+	TMap<FString, UManiacManfredLocation*> locations;
+	for (auto object : database->GetObjectsOfClass(UManiacManfredLocation::StaticClass()))
+	{
+		auto location = Cast<UManiacManfredLocation>(object);
+		FString name = location ? location->GetTechnicalName().ToString() : FString();
+		if (location && (options.Locations.Num() == 0 || options.Locations.Contains(name)))
+			locations.Add(name, location);
+	}
+
+	for (auto& name : options.Locations)
+	{
+		if (!locations.Contains(name))
+			UE_LOG(LogTemp, Warning, TEXT("There is no articy location named %s."), *name);
+	}
+
+	locations.KeySort(TLess<FString>());
+	TArray<FString> locationNames;
+	locations.GetKeys(locationNames);
+
+	TArray<FLocationGenerationReport> reports;
+	const int32 workers = FMath::Clamp(options.Workers, 1, FMath::Max(locationNames.Num(), 1));
+	if (workers > 1)
+		RunWorkers(options, locationNames, workers, reports);
+	else
+	{
+		for (auto& name : locationNames)
+			reports.Add(GenerateLocationInMap(locations[name], options));
+	}
+
+	const double totalSeconds = FPlatformTime::Seconds() - startTime;
+	WriteReportFile(options.ReportFile, reports, workers, totalSeconds);
+
+	int32 failed = 0;
+	for (auto& report : reports)
+	{
+		if (report.bSuccess)
+		{
+			UE_LOG(LogTemp, Display, TEXT("%-24s load %6.2fs  generate %6.2fs  save %6.2fs  %5d articy objects  %5d actors (%d created, %d deleted)"),
+				*report.Location, report.LoadSeconds, report.GenerateSeconds, report.SaveSeconds, report.ArticyObjects, report.Actors, report.CreatedActors, report.DeletedActors);
+
+			if (options.TargetResolutions.Num() > 0)
+			{
+				UE_LOG(LogTemp, Display, TEXT("%-24s textures %.2f MB -> %.2f MB (%d changed)"),
+					*report.Location, report.TextureBytesBefore / (1024.0 * 1024.0), report.TextureBytesAfter / (1024.0 * 1024.0), report.ChangedTextures);
+			}
+
+			if (options.OverdrawResolution.X > 0 && options.OverdrawResolution.Y > 0)
+			{
+				UE_LOG(LogTemp, Display, TEXT("%-24s shaded %.2f MPixels, %.2f MPixels with all conditional layers (%.2fx overdraw)"),
+					*report.Location, report.ShadedPixels / 1000000.0, report.WorstCaseShadedPixels / 1000000.0, report.Overdraw);
+			}
+		}
+		else
+		{
+			UE_LOG(LogTemp, Error, TEXT("%-24s failed: %s"), *report.Location, *report.Error);
+			++failed;
+		}
+	}
+
+	UE_LOG(LogTemp, Display, TEXT("Generated %d of %d locations with %d worker(s) in %.2fs, report written to %s"), reports.Num() - failed, reports.Num(), workers, totalSeconds, *options.ReportFile);
+
+	return failed == 0 ? 0 : 1;
+
+#else
+	return 1;
+#endif // WITH_EDITOR
+}
@@ -0,0 +1,48 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Commandlets/Commandlet.h"
+#include "GenerateLocationsCommandlet.generated.h"
+
+/* Regenerates the maps of all articy locations without opening the editor, e.g. after every articy export.
+*
+*  UnrealEditor-Cmd ManiacManfred.uproject -run=GenerateLocations -nullrhi -unattended [options]
+*
+*  -Locations=Loc_Cell+Loc_Cellar   only generate these locations (technical names), default is every location of the database
+*  -Workers=4                       split the locations across this many worker processes
+*  -Reconcile                       keep unchanged actors instead of recreating everything (see FLocationGeneratorSettings)
+*  -MapPath=/Game/Maps              where the maps live, every map is named like the technical name of its location
+*  -PixelsToUnits=2                 overrides the value of the generator actor in the map
+*  -SimplifyColliders=1.0           simplifies zone colliders with this tolerance in Unreal units
+*  -DecomposeColliders              splits concave zone colliders into convex shapes
+*  -PackAtlas=2048                  packs the location images into atlases of at most this size in pixels
+*  -AtlasPadding=2                  pixels around every image inside an atlas
+*  -TightSprites                    fits the sprites of location images tightly around their visible pixels
+*  -SpriteAlphaThreshold=0.1        pixels with less alpha count as transparent for -TightSprites
+*  -ClassifyAlpha                   draws opaque and binary alpha images with opaque and masked materials, only the others stay translucent
+*  -MaskedAlphaTolerance=0.01       share of partially transparent pixels an image may have and still count as masked for -ClassifyAlpha
+*  -BatchStaticImages               draws static location images with grouped sprite components instead of single actors
+*  -LightweightObjects              stores spots, links, paths and static texts on a single LocationData actor instead of one actor each
+*  -TextureBudget=1920x1080         sizes the textures of location images for these screen resolutions (joined with +) and saves them
+*  -MaxCameraZoom=1.5               how far the camera zooms into a location, for -TextureBudget
+*  -StreamTextures                  streams the textures of the location images in while the actors are spawned
+*  -Overdraw=1920x1080              estimates the overdraw of the location images at this resolution and writes a heat map to Saved/Locations
+*  -MaxOverdraw=3.0                 fails every location whose images shade more pixels per screen pixel, with all conditional layers shown
+*  -BakePath=/Game/Locations        also bakes every location into a cooked layout asset <BakePath>/<Location>_Layout for runtime instantiation
+*  -WriteBinaryLayout               also writes every location as binary layout to Saved/Locations
+*  -NoSave                          generate but don't save the maps
+*  -Report=<file>                   where the json report is written, default is Saved/Logs/GenerateLocations.json
+*/
+UCLASS()
+class MANIACMANFRED_API UGenerateLocationsCommandlet : public UCommandlet
+{
+	GENERATED_BODY()
+
+public:
+
+	UGenerateLocationsCommandlet();
+
+	virtual int32 Main(const FString& Params) override;
+};
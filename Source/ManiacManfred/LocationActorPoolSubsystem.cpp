@@ -0,0 +1,253 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#include "LocationActorPoolSubsystem.h"
+#include "ArticyReference.h"
+#include "Algo/Sort.h"
+#include "Engine/World.h"
+#include "PaperSpriteActor.h"
+#include "PaperSpriteComponent.h"
+
+/* The components an actor of the pool gets from the object-component map, everything except its render component and its ArticyReference */
+static bool IsPooledComponent(const APaperSpriteActor& Actor, const UActorComponent* Component)
+{
+	return Component && Component != Actor.GetRenderComponent() && !Component->IsA<UArticyReference>();
+}
+
+/* Sets the variables a Blueprint added to a component back to the defaults of its class, native state is reset by unregistering it */
+static void ResetBlueprintVariables(UActorComponent* Component)
+{
+	const UObject* defaults = Component->GetClass()->GetDefaultObject();
+	for (TFieldIterator<FProperty> it(Component->GetClass()); it; ++it)
+	{
+		// the frame of the event graph and the subobjects belong to this component, they must not be shared with the defaults
+		const UClass* ownerClass = it->GetOwnerClass();
+		if (!ownerClass || ownerClass->HasAnyClassFlags(CLASS_Native) || it->GetFName() == TEXT("UberGraphFrame") || it->HasAnyPropertyFlags(CPF_InstancedReference))
+			continue;
+
+		it->CopyCompleteValue_InContainer(Component, defaults);
+	}
+}
+
+APaperSpriteActor* ULocationActorPoolSubsystem::AcquireActor(TArrayView<const TSubclassOf<UActorComponent>> ComponentClasses, AActor* Owner, const FTransform& Transform)
+{
+	++Stats.Acquired;
+
+	const FKind kind = GetKind(ComponentClasses);
+	if (TArray<TWeakObjectPtr<APaperSpriteActor>>* pooledActors = PooledActors.Find(kind))
+	{
+		while (pooledActors->Num() > 0)
+		{
+			APaperSpriteActor* actor = pooledActors->Pop(EAllowShrinking::No).Get();
+			--Stats.Pooled;
+
+			// pooled actors may still be destroyed by someone else, e.g. when streaming out their level
+			if (!IsValid(actor))
+				continue;
+
+			// or lose or get components while they wait, then ActivateActor would leave them with the wrong ones
+			if (GetKind(*actor) != kind)
+			{
+				++Stats.Discarded;
+				actor->Destroy();
+				continue;
+			}
+
+			UPaperSpriteComponent* renderComponent = actor->GetRenderComponent();
+			renderComponent->SetCollisionEnabled(GetDefault<APaperSpriteActor>()->GetRenderComponent()->GetCollisionEnabled());
+			actor->SetOwner(Owner);
+			actor->SetActorTransform(Transform);
+			actor->SetActorEnableCollision(true);
+			actor->SetActorHiddenInGame(false);
+
+			// the actor, its render component and every component it still holds didn't have to be created
+			int32 reusedObjects = 2;
+			for (UActorComponent* component : actor->GetInstanceComponents())
+				reusedObjects += component && component != renderComponent ? 1 : 0;
+
+			++Stats.Hits;
+			Stats.ObjectsNotCreated += reusedObjects;
+			return actor;
+		}
+	}
+
+	FActorSpawnParameters spawnParameters;
+	spawnParameters.Owner = Owner;
+	spawnParameters.SpawnCollisionHandlingOverride = ESpawnActorCollisionHandlingMethod::AlwaysSpawn;
+	return GetWorld()->SpawnActor<APaperSpriteActor>(APaperSpriteActor::StaticClass(), Transform, spawnParameters);
+}
+
+void ULocationActorPoolSubsystem::ActivateActor(APaperSpriteActor* Actor, UArticyObject* Reference, TArrayView<const TSubclassOf<UActorComponent>> ComponentClasses)
+{
+	// the reference has to be set before the other components begin play, they usually read it
+	UArticyReference* articyReference = Actor->FindComponentByClass<UArticyReference>();
+	if (!articyReference)
+	{
+		articyReference = NewObject<UArticyReference>(Actor);
+		Actor->AddInstanceComponent(articyReference);
+	}
+
+	articyReference->SetReference(Reference);
+	if (!articyReference->IsRegistered())
+		articyReference->RegisterComponent();
+
+	// a pooled actor has one unregistered component for every class, a new one has none
+	TArray<UActorComponent*> unusedComponents;
+	for (UActorComponent* component : Actor->GetInstanceComponents())
+	{
+		if (IsPooledComponent(*Actor, component) && !component->IsRegistered())
+			unusedComponents.Add(component);
+	}
+
+	for (const TSubclassOf<UActorComponent>& componentClass : ComponentClasses)
+	{
+		if (!componentClass)
+			continue;
+
+		const int32 unused = unusedComponents.IndexOfByPredicate([&componentClass](const UActorComponent* Component) { return Component->GetClass() == componentClass.Get(); });
+		UActorComponent* component = nullptr;
+		if (unused != INDEX_NONE)
+		{
+			component = unusedComponents[unused];
+			unusedComponents.RemoveAtSwap(unused);
+		}
+		else
+		{
+			component = NewObject<UActorComponent>(Actor, componentClass.Get());
+			Actor->AddInstanceComponent(component);
+		}
+
+		// registering begins play again, because releasing the actor ended it
+		component->RegisterComponent();
+	}
+}
+
+void ULocationActorPoolSubsystem::ReleaseActor(APaperSpriteActor* Actor)
+{
+	if (!IsValid(Actor))
+		return;
+
+	++Stats.Released;
+
+	TArray<TWeakObjectPtr<APaperSpriteActor>>& pooledActors = PooledActors.FindOrAdd(GetKind(*Actor));
+	if (Stats.Pooled >= MaxPooledActors || pooledActors.Num() >= MaxPooledActorsPerKind)
+	{
+		++Stats.Discarded;
+		Actor->Destroy();
+		return;
+	}
+
+	// the ArticyReference ends its play as well, it is registered again once it points to the next articy object
+	UPaperSpriteComponent* renderComponent = Actor->GetRenderComponent();
+	for (UActorComponent* component : Actor->GetInstanceComponents())
+	{
+		if (!component || component == renderComponent)
+			continue;
+
+		if (component->HasBegunPlay())
+			component->EndPlay(EEndPlayReason::RemovedFromWorld);
+		if (component->IsRegistered())
+			component->UnregisterComponent();
+
+		if (IsPooledComponent(*Actor, component))
+			ResetBlueprintVariables(component);
+	}
+
+	// a copied background sprite is collected together with the other garbage of the location
+	renderComponent->SetSprite(nullptr);
+	renderComponent->SetTranslucentSortPriority(0);
+	renderComponent->SetCollisionEnabled(ECollisionEnabled::NoCollision);
+
+	Actor->SetActorHiddenInGame(true);
+	Actor->SetActorEnableCollision(false);
+	Actor->SetOwner(nullptr);
+
+	pooledActors.Add(Actor);
+	++Stats.Pooled;
+	Stats.PeakPooled = FMath::Max(Stats.PeakPooled, Stats.Pooled);
+}
+
+void ULocationActorPoolSubsystem::SetHighWaterMarks(int32 InMaxPooledActors, int32 InMaxPooledActorsPerKind)
+{
+	MaxPooledActors = FMath::Max(InMaxPooledActors, 0);
+	MaxPooledActorsPerKind = FMath::Max(InMaxPooledActorsPerKind, 0);
+	TrimPool();
+}
+
+void ULocationActorPoolSubsystem::EmptyPool()
+{
+	for (TPair<FKind, TArray<TWeakObjectPtr<APaperSpriteActor>>>& pooledActors : PooledActors)
+	{
+		for (const TWeakObjectPtr<APaperSpriteActor>& actor : pooledActors.Value)
+		{
+			if (actor.IsValid())
+				actor->Destroy();
+		}
+	}
+
+	PooledActors.Reset();
+	Stats.Pooled = 0;
+}
+
+void ULocationActorPoolSubsystem::LogStats() const
+{
+	UE_LOG(LogTemp, Log, TEXT("Location actor pool: %d of %d actors reused (%.0f%%), %d objects not created, %d actors pooled (peak %d), %d of %d released actors discarded at the high-water marks."),
+		Stats.Hits, Stats.Acquired, 100.0f * Stats.GetHitRate(), Stats.ObjectsNotCreated, Stats.Pooled, Stats.PeakPooled, Stats.Discarded, Stats.Released);
+}
+
+void ULocationActorPoolSubsystem::Deinitialize()
+{
+	// the pooled actors go away together with the world
+	PooledActors.Reset();
+	Stats.Pooled = 0;
+
+	Super::Deinitialize();
+}
+
+ULocationActorPoolSubsystem::FKind ULocationActorPoolSubsystem::GetKind(TArrayView<const TSubclassOf<UActorComponent>> ComponentClasses)
+{
+	FKind kind;
+	for (const TSubclassOf<UActorComponent>& componentClass : ComponentClasses)
+	{
+		if (componentClass)
+			kind.Classes.Add(componentClass.Get());
+	}
+
+	Algo::Sort(kind.Classes);
+	return kind;
+}
+
+ULocationActorPoolSubsystem::FKind ULocationActorPoolSubsystem::GetKind(const APaperSpriteActor& Actor)
+{
+	FKind kind;
+	for (const UActorComponent* component : Actor.GetInstanceComponents())
+	{
+		if (IsPooledComponent(Actor, component))
+			kind.Classes.Add(component->GetClass());
+	}
+
+	Algo::Sort(kind.Classes);
+	return kind;
+}
+
+void ULocationActorPoolSubsystem::TrimPool()
+{
+	// the actors released first go first
+	for (TPair<FKind, TArray<TWeakObjectPtr<APaperSpriteActor>>>& pooledActors : PooledActors)
+	{
+		TArray<TWeakObjectPtr<APaperSpriteActor>>& actors = pooledActors.Value;
+		const int32 maxActors = FMath::Min(MaxPooledActorsPerKind, FMath::Max(MaxPooledActors - (Stats.Pooled - actors.Num()), 0));
+		const int32 excess = actors.Num() - maxActors;
+		if (excess <= 0)
+			continue;
+
+		for (int32 i = 0; i < excess; ++i)
+		{
+			if (actors[i].IsValid())
+				actors[i]->Destroy();
+		}
+
+		actors.RemoveAt(0, excess);
+		Stats.Pooled -= excess;
+		Stats.Discarded += excess;
+	}
+}
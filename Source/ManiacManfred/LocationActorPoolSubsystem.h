@@ -0,0 +1,123 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Subsystems/WorldSubsystem.h"
+#include "LocationActorPoolSubsystem.generated.h"
+
+class APaperSpriteActor;
+class UArticyObject;
+
+/* What the actor pool saved so far */
+USTRUCT(BlueprintType)
+struct MANIACMANFRED_API FLocationActorPoolStats
+{
+	GENERATED_BODY()
+
+public:
+
+	/* Actors handed out, Hits of them came from the pool */
+	UPROPERTY(VisibleAnywhere, BlueprintReadOnly, Category = "Location Actor Pool")
+	int32 Acquired = 0;
+
+	UPROPERTY(VisibleAnywhere, BlueprintReadOnly, Category = "Location Actor Pool")
+	int32 Hits = 0;
+
+	/* Actors given back, Discarded of them were destroyed because the pool was at its high-water mark */
+	UPROPERTY(VisibleAnywhere, BlueprintReadOnly, Category = "Location Actor Pool")
+	int32 Released = 0;
+
+	UPROPERTY(VisibleAnywhere, BlueprintReadOnly, Category = "Location Actor Pool")
+	int32 Discarded = 0;
+
+	/* Actors waiting in the pool right now, and the most there ever were */
+	UPROPERTY(VisibleAnywhere, BlueprintReadOnly, Category = "Location Actor Pool")
+	int32 Pooled = 0;
+
+	UPROPERTY(VisibleAnywhere, BlueprintReadOnly, Category = "Location Actor Pool")
+	int32 PeakPooled = 0;
+
+	/* Actors and components that were reused instead of being created, and collected by the garbage collector later on */
+	UPROPERTY(VisibleAnywhere, BlueprintReadOnly, Category = "Location Actor Pool")
+	int32 ObjectsNotCreated = 0;
+
+	float GetHitRate() const { return Acquired > 0 ? (float)Hits / Acquired : 0.0f; }
+};
+
+/* Keeps the sprite actors of locations that were left, so the next location can reuse them instead of spawning new ones.
+*  Released actors are hidden, lose their sprite and owner, and their components are unregistered, ending their play.
+*  An actor is only reused for an object that needs exactly the same component classes, the components are registered again after
+*  the ArticyReference points to the new articy object, so they begin play with the new object just like freshly spawned ones.
+*  The Blueprint variables of reused components are reset to their defaults.
+*  Actors can't leave their world, so the pool belongs to the world the ULocationInstantiationSubsystem spawns locations into. Opening another map,
+*  like the generated Loc_* maps, starts with an empty pool.
+*/
+UCLASS()
+class MANIACMANFRED_API ULocationActorPoolSubsystem : public UWorldSubsystem
+{
+	GENERATED_BODY()
+
+public:
+
+	/* Returns a visible sprite actor at the transform, from the pool if there is one with the same component classes.
+	*  The sprite is empty and neither the ArticyReference nor the components are registered yet, see ActivateActor.
+	*/
+	APaperSpriteActor* AcquireActor(TArrayView<const TSubclassOf<UActorComponent>> ComponentClasses, AActor* Owner, const FTransform& Transform);
+
+	/* Points the ArticyReference of an acquired actor to its articy object and registers its components, creating the ones it doesn't have yet */
+	void ActivateActor(APaperSpriteActor* Actor, UArticyObject* Reference, TArrayView<const TSubclassOf<UActorComponent>> ComponentClasses);
+
+	/* Gives an actor back to the pool, it is destroyed instead if the pool is at one of its high-water marks */
+	void ReleaseActor(APaperSpriteActor* Actor);
+
+	/* The most actors kept in total and per set of component classes, 0 turns pooling off. Destroys the pooled actors above the new marks. */
+	UFUNCTION(BlueprintCallable, Category = "Location Actor Pool")
+	void SetHighWaterMarks(int32 InMaxPooledActors, int32 InMaxPooledActorsPerKind);
+
+	/* Destroys all pooled actors, e.g. before a level without locations */
+	UFUNCTION(BlueprintCallable, Category = "Location Actor Pool")
+	void EmptyPool();
+
+	UFUNCTION(BlueprintCallable, Category = "Location Actor Pool")
+	FLocationActorPoolStats GetStats() const { return Stats; }
+
+	/* Share of acquired actors that came from the pool */
+	UFUNCTION(BlueprintCallable, Category = "Location Actor Pool")
+	float GetHitRate() const { return Stats.GetHitRate(); }
+
+	void LogStats() const;
+
+	virtual void Deinitialize() override;
+
+private:
+
+	/* The component classes an actor has, sorted so their order doesn't matter. A class that is added twice is in here twice. */
+	struct FKind
+	{
+		TArray<const UClass*, TInlineAllocator<4>> Classes;
+
+		bool operator==(const FKind& Other) const { return Classes == Other.Classes; }
+
+		friend uint32 GetTypeHash(const FKind& Kind)
+		{
+			uint32 hash = 0;
+			for (const UClass* componentClass : Kind.Classes)
+				hash = HashCombine(hash, GetTypeHash(componentClass));
+			return hash;
+		}
+	};
+
+	static FKind GetKind(TArrayView<const TSubclassOf<UActorComponent>> ComponentClasses);
+	static FKind GetKind(const APaperSpriteActor& Actor);
+
+	void TrimPool();
+
+	/* The pooled actors by their kind, the most recently released ones last */
+	TMap<FKind, TArray<TWeakObjectPtr<APaperSpriteActor>>> PooledActors;
+
+	int32 MaxPooledActors = 1024;
+	int32 MaxPooledActorsPerKind = 512;
+
+	FLocationActorPoolStats Stats;
+};
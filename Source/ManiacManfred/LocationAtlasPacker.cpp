@@ -0,0 +1,135 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#include "LocationAtlasPacker.h"
+
+FLocationAtlasPacker::FLocationAtlasPacker(int32 InSize)
+	: Size(InSize)
+{
+	Skyline.Add({ 0, 0, Size });
+}
+
+int32 FLocationAtlasPacker::GetRestingHeight(int32 Segment, int32 Width) const
+{
+	if (Skyline[Segment].X + Width > Size)
+		return INDEX_NONE;
+
+	// the rect rests on the highest segment below it
+	int32 y = 0;
+	int32 remainingWidth = Width;
+	for (int32 i = Segment; remainingWidth > 0; ++i)
+	{
+		y = FMath::Max(y, Skyline[i].Y);
+		remainingWidth -= Skyline[i].Width;
+	}
+	return y;
+}
+
+bool FLocationAtlasPacker::Insert(const FIntPoint& RectSize, FIntPoint& OutPosition)
+{
+	int32 bestSegment = INDEX_NONE;
+	int32 bestTop = MAX_int32;
+	int32 bestWidth = MAX_int32;
+
+	for (int32 i = 0; i < Skyline.Num(); ++i)
+	{
+		const int32 y = GetRestingHeight(i, RectSize.X);
+		if (y == INDEX_NONE || y + RectSize.Y > Size)
+			continue;
+
+		// bottom left: as low as possible, the narrower segment wins ties so wide gaps stay free for wide images
+		const int32 top = y + RectSize.Y;
+		if (top < bestTop || (top == bestTop && Skyline[i].Width < bestWidth))
+		{
+			bestSegment = i;
+			bestTop = top;
+			bestWidth = Skyline[i].Width;
+			OutPosition = FIntPoint(Skyline[i].X, y);
+		}
+	}
+
+	if (bestSegment == INDEX_NONE)
+		return false;
+
+	// the new segment covers the rect, the segments below it get cut or removed
+	Skyline.Insert({ OutPosition.X, bestTop, RectSize.X }, bestSegment);
+	const int32 rectRight = OutPosition.X + RectSize.X;
+	for (int32 i = bestSegment + 1; i < Skyline.Num();)
+	{
+		FSegment& segment = Skyline[i];
+		if (segment.X >= rectRight)
+			break;
+
+		const int32 segmentRight = segment.X + segment.Width;
+		if (segmentRight <= rectRight)
+		{
+			Skyline.RemoveAt(i);
+			continue;
+		}
+
+		segment.Width = segmentRight - rectRight;
+		segment.X = rectRight;
+		break;
+	}
+
+	// neighbours at the same height become one segment
+	for (int32 i = 0; i + 1 < Skyline.Num();)
+	{
+		if (Skyline[i].Y == Skyline[i + 1].Y)
+		{
+			Skyline[i].Width += Skyline[i + 1].Width;
+			Skyline.RemoveAt(i + 1);
+		}
+		else
+			++i;
+	}
+
+	UsedSize.X = FMath::Max(UsedSize.X, rectRight);
+	UsedSize.Y = FMath::Max(UsedSize.Y, bestTop);
+	return true;
+}
+
+void FLocationAtlasPacker::Pack(TArrayView<const FIntPoint> Sizes, int32 MaxAtlasSize, int32 Padding, TArray<FLocationAtlasPlacement>& OutPlacements, TArray<FIntPoint>& OutAtlasSizes)
+{
+	OutPlacements.Reset();
+	OutPlacements.SetNum(Sizes.Num());
+	OutAtlasSizes.Reset();
+
+	TArray<int32> order;
+	order.Reserve(Sizes.Num());
+	for (int32 i = 0; i < Sizes.Num(); ++i)
+		order.Add(i);
+	order.Sort([&Sizes](int32 A, int32 B)
+	{
+		return Sizes[A].Y != Sizes[B].Y ? Sizes[A].Y > Sizes[B].Y : Sizes[A].X > Sizes[B].X;
+	});
+
+	TArray<FLocationAtlasPacker> atlases;
+	for (int32 image : order)
+	{
+		const FIntPoint paddedSize = Sizes[image] + FIntPoint(2 * Padding, 2 * Padding);
+		if (paddedSize.X > MaxAtlasSize || paddedSize.Y > MaxAtlasSize)
+			continue;
+
+		FIntPoint position;
+		int32 atlas = 0;
+		for (; atlas < atlases.Num(); ++atlas)
+		{
+			if (atlases[atlas].Insert(paddedSize, position))
+				break;
+		}
+
+		// nothing fits into the existing atlases anymore, an empty one always has room for it
+		if (atlas == atlases.Num())
+			atlases.Add_GetRef(FLocationAtlasPacker(MaxAtlasSize)).Insert(paddedSize, position);
+
+		OutPlacements[image].Atlas = atlas;
+		OutPlacements[image].Position = position + FIntPoint(Padding, Padding);
+	}
+
+	for (const FLocationAtlasPacker& atlas : atlases)
+	{
+		OutAtlasSizes.Add(FIntPoint(
+			FMath::Min((int32)FMath::RoundUpToPowerOfTwo(atlas.UsedSize.X), MaxAtlasSize),
+			FMath::Min((int32)FMath::RoundUpToPowerOfTwo(atlas.UsedSize.Y), MaxAtlasSize)));
+	}
+}
@@ -0,0 +1,45 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+
+/* Where an image ended up when packing, Atlas is INDEX_NONE if it doesn't fit into an atlas at all */
+struct FLocationAtlasPlacement
+{
+	int32 Atlas = INDEX_NONE;
+	/* Position of the image itself inside the atlas, the padding lies around it */
+	FIntPoint Position = FIntPoint::ZeroValue;
+};
+
+/* Packs rectangles into as few atlases as possible (skyline, bottom left).
+*  Images are packed from the tallest to the smallest, every atlas is shrunk to the smallest power of two that still holds its images afterwards.
+*/
+struct MANIACMANFRED_API FLocationAtlasPacker
+{
+public:
+
+	static void Pack(TArrayView<const FIntPoint> Sizes, int32 MaxAtlasSize, int32 Padding, TArray<FLocationAtlasPlacement>& OutPlacements, TArray<FIntPoint>& OutAtlasSizes);
+
+private:
+
+	explicit FLocationAtlasPacker(int32 InSize);
+
+	/* Finds the lowest position for a rect and occupies it, returns false if the rect doesn't fit anymore */
+	bool Insert(const FIntPoint& Size, FIntPoint& OutPosition);
+
+	/* The y a rect of the given width would rest at if placed at a skyline segment, or INDEX_NONE if it sticks out */
+	int32 GetRestingHeight(int32 Segment, int32 Width) const;
+
+	/* The top edge of everything packed so far, one segment per step, every segment reaches to the next one */
+	struct FSegment
+	{
+		int32 X;
+		int32 Y;
+		int32 Width;
+	};
+
+	int32 Size;
+	TArray<FSegment> Skyline;
+	FIntPoint UsedSize = FIntPoint::ZeroValue;
+};
@@ -0,0 +1,370 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#include "LocationBinaryLayout.h"
+#include "LocationLayout.h"
+#include "Async/MappedFileHandle.h"
+#include "HAL/FileManager.h"
+#include "HAL/IConsoleManager.h"
+#include "HAL/PlatformFileManager.h"
+#include "Misc/FileHelper.h"
+#include "Misc/Paths.h"
+
+#pragma region Writer
+
+/* Appends a section to the data, 8 byte aligned, and returns its offset */
+template<typename T>
+static uint32 AppendSection(TArray<uint8>& Data, const TArray<T>& Section)
+{
+	Data.SetNumZeroed(Align(Data.Num(), 8));
+	const uint32 offset = Data.Num();
+	Data.Append(reinterpret_cast<const uint8*>(Section.GetData()), Section.Num() * sizeof(T));
+	return offset;
+}
+
+static FLocationBinaryRange AppendLabel(TArray<UTF8CHAR>& Labels, const FString& Label)
+{
+	FTCHARToUTF8 utf8(*Label);
+	FLocationBinaryRange range = { (uint32)Labels.Num(), (uint32)utf8.Length() };
+	Labels.Append(reinterpret_cast<const UTF8CHAR*>(utf8.Get()), utf8.Length());
+	return range;
+}
+
+void FLocationBinaryLayoutWriter::Write(const FLocationLayout& Layout, TArrayView<const FLocationBinaryObjectInput> Objects, FName LocationName, float PixelsToUnits, const FVector4f& OverallBounds, uint32 Signature, TArray<uint8>& OutData)
+{
+	check(Objects.Num() == Layout.Num());
+
+	const int32 num = Layout.Num();
+	TArray<FLocationBinaryObject> objects;
+	TArray<uint32> children;
+	TArray<FVector2f> vertices;
+	TArray<FLocationBinaryRange> shapes;
+	TArray<FVector2f> colliderVertices;
+	TArray<UTF8CHAR> labels;
+
+	objects.SetNumZeroed(num);
+	children.Reserve(num);
+
+	// the children of every object one after another, starting with the children of the location itself
+	TArray<TArray<uint32>> childLists;
+	childLists.SetNum(num + 1);
+	for (int32 i = 0; i < num; ++i)
+		childLists[Layout.ParentIndices[i] + 1].Add(i);
+
+	FLocationBinaryHeader header;
+	FMemory::Memzero(header);
+	header.RootChildren = { 0, (uint32)childLists[0].Num() };
+	children.Append(childLists[0]);
+
+	for (int32 i = 0; i < num; ++i)
+	{
+		const FLocationBinaryObjectInput& input = Objects[i];
+		FLocationBinaryObject& object = objects[i];
+
+		object.IdLow = Layout.Ids[i].Low;
+		object.IdHigh = Layout.Ids[i].High;
+		object.ImageAssetLow = Layout.ImageAssets[i].Low;
+		object.ImageAssetHigh = Layout.ImageAssets[i].High;
+		object.Parent = Layout.ParentIndices[i];
+
+		object.Children = { (uint32)children.Num(), (uint32)childLists[i + 1].Num() };
+		children.Append(childLists[i + 1]);
+
+		object.Vertices = { (uint32)vertices.Num(), (uint32)Layout.VertexCounts[i] };
+		for (const FVector2D& vertex : Layout.GetVertices(i))
+			vertices.Add(FVector2f(vertex));
+
+		object.ColliderShapes = { (uint32)shapes.Num(), (uint32)input.ColliderShapes.Num() };
+		for (const TArray<FVector2D>& shape : input.ColliderShapes)
+		{
+			shapes.Add({ (uint32)colliderVertices.Num(), (uint32)shape.Num() });
+			for (const FVector2D& vertex : shape)
+				colliderVertices.Add(FVector2f(vertex));
+		}
+
+		object.Label = AppendLabel(labels, input.Label.ToString());
+		object.Location[0] = input.Location.X;
+		object.Location[1] = input.Location.Y;
+		object.Location[2] = input.Location.Z;
+		object.ZIndex = Layout.ZIndices[i];
+		object.LayoutFlags = (uint16)Layout.Flags[i];
+		object.ShapeType = (uint8)Layout.ShapeTypes[i];
+
+		ELocationBinaryObjectFlags flags = ELocationBinaryObjectFlags::None;
+		if (input.bZone)
+			flags |= ELocationBinaryObjectFlags::Zone;
+		if (input.bBatched)
+			flags |= ELocationBinaryObjectFlags::Batched;
+		object.GeneratorFlags = (uint8)flags;
+	}
+
+	header.LocationName = AppendLabel(labels, LocationName.ToString());
+
+	OutData.Reset();
+	OutData.SetNumZeroed(sizeof(FLocationBinaryHeader));
+
+	header.Magic = LocationBinaryLayout::Magic;
+	header.Version = LocationBinaryLayout::Version;
+	header.HeaderSize = sizeof(FLocationBinaryHeader);
+	header.Signature = Signature;
+	header.PixelsToUnits = PixelsToUnits;
+	header.OverallBounds[0] = OverallBounds.X;
+	header.OverallBounds[1] = OverallBounds.Y;
+	header.OverallBounds[2] = OverallBounds.Z;
+	header.OverallBounds[3] = OverallBounds.W;
+
+	header.ObjectsOffset = AppendSection(OutData, objects);
+	header.ObjectCount = objects.Num();
+	header.ChildrenOffset = AppendSection(OutData, children);
+	header.ChildCount = children.Num();
+	header.VerticesOffset = AppendSection(OutData, vertices);
+	header.VertexCount = vertices.Num();
+	header.ShapesOffset = AppendSection(OutData, shapes);
+	header.ShapeCount = shapes.Num();
+	header.ColliderVerticesOffset = AppendSection(OutData, colliderVertices);
+	header.ColliderVertexCount = colliderVertices.Num();
+	header.LabelsOffset = AppendSection(OutData, labels);
+	header.LabelBytes = labels.Num();
+
+	header.FileSize = OutData.Num();
+	header.Checksum = FCrc::MemCrc32(OutData.GetData() + sizeof(FLocationBinaryHeader), OutData.Num() - sizeof(FLocationBinaryHeader));
+	FMemory::Memcpy(OutData.GetData(), &header, sizeof(FLocationBinaryHeader));
+}
+
+bool FLocationBinaryLayoutWriter::WriteToFile(const FString& Filename, TArrayView<const uint8> Data)
+{
+	return FFileHelper::SaveArrayToFile(Data, *Filename);
+}
+
+FString FLocationBinaryLayoutWriter::GetDefaultFilename(FName LocationName)
+{
+	return FPaths::ProjectSavedDir() / TEXT("Locations") / (LocationName.ToString() + LocationBinaryLayout::Extension);
+}
+
+#pragma endregion
+
+#pragma region Reader
+
+/* True if Count elements, starting at element First of a section with SectionCount elements, stay inside the section */
+static bool IsRangeInside(uint64 First, uint64 Count, uint64 SectionCount)
+{
+	return First <= SectionCount && Count <= SectionCount - First;
+}
+
+bool FLocationBinaryLayoutView::Validate(FString& OutError) const
+{
+	if (Data.Num() < (int32)sizeof(FLocationBinaryHeader) || !IsAligned(Data.GetData(), 4))
+	{
+		OutError = TEXT("The data is too small or not aligned.");
+		return false;
+	}
+
+	const FLocationBinaryHeader& header = GetHeader();
+	if (header.Magic != LocationBinaryLayout::Magic)
+	{
+		OutError = TEXT("This is no location layout.");
+		return false;
+	}
+	if (header.Version != LocationBinaryLayout::Version || header.HeaderSize != sizeof(FLocationBinaryHeader))
+	{
+		OutError = FString::Printf(TEXT("Version %d is not supported, expected version %d."), header.Version, LocationBinaryLayout::Version);
+		return false;
+	}
+	if (header.FileSize > (uint32)Data.Num())
+	{
+		OutError = FString::Printf(TEXT("The data is truncated, %d of %u bytes."), Data.Num(), header.FileSize);
+		return false;
+	}
+
+	// every section has to lie behind the header, inside the file and aligned for its elements
+	auto isSectionValid = [&header](uint32 Offset, uint64 Count, uint64 Stride)
+	{
+		return Offset >= sizeof(FLocationBinaryHeader) && Offset % 4 == 0 && Offset <= header.FileSize && Count * Stride <= header.FileSize - Offset;
+	};
+	if (!isSectionValid(header.ObjectsOffset, header.ObjectCount, sizeof(FLocationBinaryObject))
+		|| !isSectionValid(header.ChildrenOffset, header.ChildCount, sizeof(uint32))
+		|| !isSectionValid(header.VerticesOffset, header.VertexCount, sizeof(FVector2f))
+		|| !isSectionValid(header.ShapesOffset, header.ShapeCount, sizeof(FLocationBinaryRange))
+		|| !isSectionValid(header.ColliderVerticesOffset, header.ColliderVertexCount, sizeof(FVector2f))
+		|| !isSectionValid(header.LabelsOffset, header.LabelBytes, 1))
+	{
+		OutError = TEXT("A section lies outside of the data.");
+		return false;
+	}
+
+	const uint32 checksum = FCrc::MemCrc32(Data.GetData() + sizeof(FLocationBinaryHeader), header.FileSize - sizeof(FLocationBinaryHeader));
+	if (checksum != header.Checksum)
+	{
+		OutError = TEXT("The checksum doesn't match, the data is corrupt.");
+		return false;
+	}
+
+	if (!IsRangeInside(header.RootChildren.First, header.RootChildren.Count, header.ChildCount) || !IsRangeInside(header.LocationName.First, header.LocationName.Count, header.LabelBytes))
+	{
+		OutError = TEXT("The root children or the location name lie outside of their sections.");
+		return false;
+	}
+
+	const TArrayView<const uint32> children = GetSection<uint32>(header.ChildrenOffset, header.ChildCount);
+	for (uint32 child : children)
+	{
+		if (child >= header.ObjectCount)
+		{
+			OutError = FString::Printf(TEXT("Child index %u is out of range."), child);
+			return false;
+		}
+	}
+
+	for (uint32 child : GetRootChildren())
+	{
+		if (GetObjects()[child].Parent != INDEX_NONE)
+		{
+			OutError = FString::Printf(TEXT("Object %u is listed as child of the location, but it has a parent."), child);
+			return false;
+		}
+	}
+
+	const TArrayView<const FLocationBinaryRange> shapes = GetSection<FLocationBinaryRange>(header.ShapesOffset, header.ShapeCount);
+	for (const FLocationBinaryRange& shape : shapes)
+	{
+		if (!IsRangeInside(shape.First, shape.Count, header.ColliderVertexCount))
+		{
+			OutError = TEXT("A collider shape lies outside of the collider vertices.");
+			return false;
+		}
+	}
+
+	const TArrayView<const FLocationBinaryObject> objects = GetObjects();
+	for (int32 i = 0; i < objects.Num(); ++i)
+	{
+		const FLocationBinaryObject& object = objects[i];
+
+		// parents always come before their children, which also rules out cycles
+		if (object.Parent < -1 || object.Parent >= i)
+		{
+			OutError = FString::Printf(TEXT("Object %d has the invalid parent %d."), i, object.Parent);
+			return false;
+		}
+
+		if (!IsRangeInside(object.Children.First, object.Children.Count, header.ChildCount)
+			|| !IsRangeInside(object.Vertices.First, object.Vertices.Count, header.VertexCount)
+			|| !IsRangeInside(object.ColliderShapes.First, object.ColliderShapes.Count, header.ShapeCount)
+			|| !IsRangeInside(object.Label.First, object.Label.Count, header.LabelBytes))
+		{
+			OutError = FString::Printf(TEXT("A range of object %d lies outside of its section."), i);
+			return false;
+		}
+
+		for (uint32 child : GetChildren(i))
+		{
+			if (objects[child].Parent != i)
+			{
+				OutError = FString::Printf(TEXT("Object %d lists %u as child, but it has another parent."), i, child);
+				return false;
+			}
+		}
+	}
+
+	return true;
+}
+
+FArticyId FLocationBinaryLayoutView::GetId(int32 Object) const
+{
+	FArticyId id;
+	id.Low = GetObjects()[Object].IdLow;
+	id.High = GetObjects()[Object].IdHigh;
+	return id;
+}
+
+FArticyId FLocationBinaryLayoutView::GetImageAsset(int32 Object) const
+{
+	FArticyId id;
+	id.Low = GetObjects()[Object].ImageAssetLow;
+	id.High = GetObjects()[Object].ImageAssetHigh;
+	return id;
+}
+
+int32 FLocationBinaryLayoutView::FindObject(const FArticyId& Id) const
+{
+	return GetObjects().IndexOfByPredicate([&Id](const FLocationBinaryObject& Object) { return Object.IdLow == Id.Low && Object.IdHigh == Id.High; });
+}
+
+FString FLocationBinaryLayoutView::GetString(const FLocationBinaryRange& Range) const
+{
+	const UTF8CHAR* label = reinterpret_cast<const UTF8CHAR*>(Data.GetData() + GetHeader().LabelsOffset) + Range.First;
+	return FString(FUTF8ToTCHAR(reinterpret_cast<const ANSICHAR*>(label), Range.Count));
+}
+
+#pragma endregion
+
+#pragma region File
+
+FLocationBinaryLayoutFile::FLocationBinaryLayoutFile() = default;
+
+FLocationBinaryLayoutFile::~FLocationBinaryLayoutFile()
+{
+	Close();
+}
+
+bool FLocationBinaryLayoutFile::Open(const FString& Filename)
+{
+	Close();
+
+	// mapping only pages in what is actually read, e.g. the header and the objects of a single query
+	MappedHandle.Reset(FPlatformFileManager::Get().GetPlatformFile().OpenMapped(*Filename));
+	if (MappedHandle.IsValid() && MappedHandle->GetFileSize() > 0)
+		MappedRegion.Reset(MappedHandle->MapRegion(0, MappedHandle->GetFileSize()));
+
+	if (MappedRegion.IsValid())
+	{
+		View = TArrayView<const uint8>(MappedRegion->GetMappedPtr(), (int32)MappedRegion->GetMappedSize());
+		return true;
+	}
+
+	MappedHandle.Reset();
+	if (!FFileHelper::LoadFileToArray(LoadedData, *Filename, FILEREAD_Silent))
+		return false;
+
+	View = LoadedData;
+	return View.Num() > 0;
+}
+
+void FLocationBinaryLayoutFile::Close()
+{
+	View = TArrayView<const uint8>();
+	MappedRegion.Reset();
+	MappedHandle.Reset();
+	LoadedData.Empty();
+}
+
+#pragma endregion
+
+static FAutoConsoleCommand ValidateLocationLayoutCommand(
+	TEXT("ManiacManfred.ValidateLocationLayout"),
+	TEXT("Validates the binary layout of a location and prints a summary. Argument: the technical name of the location or the path of a layout file."),
+	FConsoleCommandWithArgsDelegate::CreateLambda([](const TArray<FString>& Args)
+	{
+		if (Args.Num() == 0)
+			return;
+
+		const FString filename = FPaths::FileExists(Args[0]) ? Args[0] : FLocationBinaryLayoutWriter::GetDefaultFilename(FName(*Args[0]));
+
+		FLocationBinaryLayoutFile file;
+		if (!file.Open(filename))
+		{
+			UE_LOG(LogTemp, Error, TEXT("Could not open the location layout %s."), *filename);
+			return;
+		}
+
+		FString error;
+		const FLocationBinaryLayoutView view = file.GetView();
+		if (!view.Validate(error))
+		{
+			UE_LOG(LogTemp, Error, TEXT("The location layout %s is invalid: %s"), *filename, *error);
+			return;
+		}
+
+		const FLocationBinaryHeader& header = view.GetHeader();
+		UE_LOG(LogTemp, Log, TEXT("Location layout %s (%s, %s): %u objects, %u vertices, %u collider shapes with %u vertices, signature %08x."),
+			*view.GetLocationName(), *filename, file.IsMapped() ? TEXT("mapped") : TEXT("loaded"),
+			header.ObjectCount, header.VertexCount, header.ShapeCount, header.ColliderVertexCount, header.Signature);
+	}));
@@ -0,0 +1,203 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "ArticyBaseInclude.h"
+
+struct FLocationLayout;
+class IMappedFileHandle;
+class IMappedFileRegion;
+
+/* A generated location as a single flat, little endian file, which can be memory mapped and read in place.
+*  There are no pointers inside, every array is stored once as a section of the file and referenced by offset and count:
+*
+*  [FLocationBinaryHeader][objects][children][vertices][collider shapes][collider vertices][labels]
+*
+*  Every section starts 8 byte aligned. The children section holds the child indices of all objects one after another,
+*  starting with the direct children of the location. Collider shapes are ranges into the collider vertices.
+*  Labels are UTF-8 without terminator. Increase Version whenever one of the structs changes.
+*/
+namespace LocationBinaryLayout
+{
+	static constexpr uint32 Magic = 0x4C4C4D4D; // "MMLL"
+	static constexpr uint16 Version = 1;
+	static constexpr const TCHAR* Extension = TEXT(".mmlayout");
+}
+
+/* A range inside one of the sections */
+struct FLocationBinaryRange
+{
+	uint32 First;
+	uint32 Count;
+};
+
+struct FLocationBinaryHeader
+{
+	uint32 Magic;
+	uint16 Version;
+	uint16 HeaderSize;
+	/* Size of the whole file and the CRC32 of everything behind the header */
+	uint32 FileSize;
+	uint32 Checksum;
+
+	/* Hash over the generation signatures of all objects, changes whenever anything the actors are generated from changes */
+	uint32 Signature;
+	float PixelsToUnits;
+	/* Bounds of the location in Unreal units (x, y, w, h like FRect) */
+	float OverallBounds[4];
+
+	/* Byte offsets of the sections and their element counts */
+	uint32 ObjectsOffset;
+	uint32 ObjectCount;
+	uint32 ChildrenOffset;
+	uint32 ChildCount;
+	uint32 VerticesOffset;
+	uint32 VertexCount;
+	uint32 ShapesOffset;
+	uint32 ShapeCount;
+	uint32 ColliderVerticesOffset;
+	uint32 ColliderVertexCount;
+	uint32 LabelsOffset;
+	uint32 LabelBytes;
+
+	/* The direct children of the location inside the children section, and the technical name of the location inside the labels */
+	FLocationBinaryRange RootChildren;
+	FLocationBinaryRange LocationName;
+};
+
+/* Flags of FLocationBinaryObject::GeneratorFlags */
+enum class ELocationBinaryObjectFlags : uint8
+{
+	None = 0,
+	Zone = 1 << 0,
+	Batched = 1 << 1,
+};
+ENUM_CLASS_FLAGS(ELocationBinaryObjectFlags);
+
+struct FLocationBinaryObject
+{
+	uint32 IdLow;
+	uint32 IdHigh;
+	uint32 ImageAssetLow;
+	uint32 ImageAssetHigh;
+	/* Index of the parent object, -1 for direct children of the location */
+	int32 Parent;
+	FLocationBinaryRange Children;
+	/* The vertices as they are stored in articy, in articy coordinates */
+	FLocationBinaryRange Vertices;
+	/* The (simplified or decomposed) collider shapes of a zone, in Unreal units */
+	FLocationBinaryRange ColliderShapes;
+	/* Byte range of the label */
+	FLocationBinaryRange Label;
+	/* Where the generator puts the actor, Y is the sort priority */
+	float Location[3];
+	float ZIndex;
+	/* ELocationLayoutFlags */
+	uint16 LayoutFlags;
+	/* EManiacManfredShapeType */
+	uint8 ShapeType;
+	/* ELocationBinaryObjectFlags */
+	uint8 GeneratorFlags;
+};
+
+static_assert(sizeof(FLocationBinaryRange) == 8, "The binary layout structs must not contain padding");
+static_assert(sizeof(FLocationBinaryHeader) == 104, "The binary layout structs must not contain padding");
+static_assert(sizeof(FLocationBinaryObject) == 72, "The binary layout structs must not contain padding");
+
+/* What the writer needs to know about a generated object, besides what the layout already stores */
+struct FLocationBinaryObjectInput
+{
+	FName Label;
+	FVector Location = FVector::ZeroVector;
+	bool bZone = false;
+	bool bBatched = false;
+	/* Empty for objects without collider, zones without processed colliders pass their scaled polygon as single shape */
+	TArray<TArray<FVector2D>> ColliderShapes;
+};
+
+struct MANIACMANFRED_API FLocationBinaryLayoutWriter
+{
+public:
+
+	/* Serializes a layout and the generated objects (one per layout object, in the same order) */
+	static void Write(const FLocationLayout& Layout, TArrayView<const FLocationBinaryObjectInput> Objects, FName LocationName, float PixelsToUnits, const FVector4f& OverallBounds, uint32 Signature, TArray<uint8>& OutData);
+
+	static bool WriteToFile(const FString& Filename, TArrayView<const uint8> Data);
+
+	/* Where the generator writes the binary layout of a location */
+	static FString GetDefaultFilename(FName LocationName);
+};
+
+/* Reads a binary layout in place, nothing is copied or deserialized. Call Validate before reading data you didn't write yourself. */
+struct MANIACMANFRED_API FLocationBinaryLayoutView
+{
+public:
+
+	FLocationBinaryLayoutView() = default;
+	explicit FLocationBinaryLayoutView(TArrayView<const uint8> InData) : Data(InData) {}
+
+	/* Checks the header, the checksum and that every offset, range and index stays inside the data */
+	bool Validate(FString& OutError) const;
+
+	const FLocationBinaryHeader& GetHeader() const { return *reinterpret_cast<const FLocationBinaryHeader*>(Data.GetData()); }
+
+	TArrayView<const FLocationBinaryObject> GetObjects() const { return GetSection<FLocationBinaryObject>(GetHeader().ObjectsOffset, GetHeader().ObjectCount); }
+	TArrayView<const uint32> GetRootChildren() const { return GetRange<uint32>(GetHeader().ChildrenOffset, GetHeader().RootChildren); }
+	TArrayView<const uint32> GetChildren(int32 Object) const { return GetRange<uint32>(GetHeader().ChildrenOffset, GetObjects()[Object].Children); }
+	TArrayView<const FVector2f> GetVertices(int32 Object) const { return GetRange<FVector2f>(GetHeader().VerticesOffset, GetObjects()[Object].Vertices); }
+	TArrayView<const FLocationBinaryRange> GetColliderShapes(int32 Object) const { return GetRange<FLocationBinaryRange>(GetHeader().ShapesOffset, GetObjects()[Object].ColliderShapes); }
+	TArrayView<const FVector2f> GetColliderVertices(const FLocationBinaryRange& Shape) const { return GetRange<FVector2f>(GetHeader().ColliderVerticesOffset, Shape); }
+
+	FString GetLabel(int32 Object) const { return GetString(GetObjects()[Object].Label); }
+	FString GetLocationName() const { return GetString(GetHeader().LocationName); }
+
+	FArticyId GetId(int32 Object) const;
+	FArticyId GetImageAsset(int32 Object) const;
+
+	/* Returns the index of the object with the given id or INDEX_NONE, this is a linear search */
+	int32 FindObject(const FArticyId& Id) const;
+
+private:
+
+	template<typename T>
+	TArrayView<const T> GetSection(uint32 Offset, uint32 Count) const
+	{
+		return TArrayView<const T>(reinterpret_cast<const T*>(Data.GetData() + Offset), Count);
+	}
+
+	template<typename T>
+	TArrayView<const T> GetRange(uint32 SectionOffset, const FLocationBinaryRange& Range) const
+	{
+		return TArrayView<const T>(reinterpret_cast<const T*>(Data.GetData() + SectionOffset) + Range.First, Range.Count);
+	}
+
+	FString GetString(const FLocationBinaryRange& Range) const;
+
+	TArrayView<const uint8> Data;
+};
+
+/* A binary layout file that is memory mapped if the platform supports it and read into memory otherwise */
+class MANIACMANFRED_API FLocationBinaryLayoutFile
+{
+public:
+
+	FLocationBinaryLayoutFile();
+	~FLocationBinaryLayoutFile();
+
+	bool Open(const FString& Filename);
+	void Close();
+
+	bool IsOpen() const { return View.Num() > 0; }
+	bool IsMapped() const { return MappedRegion.IsValid(); }
+
+	/* The view stays valid until the file is closed */
+	FLocationBinaryLayoutView GetView() const { return FLocationBinaryLayoutView(View); }
+
+private:
+
+	TUniquePtr<IMappedFileHandle> MappedHandle;
+	TUniquePtr<IMappedFileRegion> MappedRegion;
+	TArray<uint8> LoadedData;
+	TArrayView<const uint8> View;
+};
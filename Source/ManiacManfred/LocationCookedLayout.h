@@ -0,0 +1,93 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Engine/DataAsset.h"
+#include "ArticyBaseInclude.h"
+#include "LocationCookedLayout.generated.h"
+
+class UPaperSprite;
+class ULocationSpriteCache;
+
+/* Everything needed to spawn the actor of a single articy object without the LocationGenerator */
+USTRUCT(BlueprintType)
+struct MANIACMANFRED_API FLocationCookedObject
+{
+	GENERATED_BODY()
+
+public:
+
+	/* The articy object the actor represents, stored in its ArticyReference */
+	UPROPERTY(VisibleAnywhere, Category = "Cooked Layout")
+	FArticyId Id;
+
+	UPROPERTY(VisibleAnywhere, Category = "Cooked Layout")
+	FName Label;
+
+	/* Index of the parent object, INDEX_NONE for direct children of the location */
+	UPROPERTY(VisibleAnywhere, Category = "Cooked Layout")
+	int32 Parent = INDEX_NONE;
+
+	UPROPERTY(VisibleAnywhere, Category = "Cooked Layout")
+	FVector Location = FVector::ZeroVector;
+
+	UPROPERTY(VisibleAnywhere, Category = "Cooked Layout")
+	float SortPriority = 0;
+
+	/* The image of a location image or the collider of a zone, none for objects that are neither */
+	UPROPERTY(VisibleAnywhere, Category = "Cooked Layout")
+	TObjectPtr<UPaperSprite> Sprite = nullptr;
+
+	UPROPERTY(VisibleAnywhere, Category = "Cooked Layout")
+	TArray<TSubclassOf<UActorComponent>> Components;
+
+	/* The object is a location image, a zone only has an invisible sprite carrying its collider */
+	UPROPERTY(VisibleAnywhere, Category = "Cooked Layout")
+	bool bImage = false;
+
+	/* The background image of the location, every instance gets its own copy of its sprite like when generating */
+	UPROPERTY(VisibleAnywhere, Category = "Cooked Layout")
+	bool bBackgroundLayer = false;
+
+	/* Images that were drawn by a grouped sprite component when generating, see FLocationGeneratorSettings::bBatchStaticImages */
+	UPROPERTY(VisibleAnywhere, Category = "Cooked Layout")
+	bool bBatched = false;
+
+	UPROPERTY(VisibleAnywhere, Category = "Cooked Layout")
+	bool bCollisionEnabled = true;
+};
+
+/* A location baked by the LocationGenerator into a single small asset, which the ULocationInstantiationSubsystem can spawn into any world at runtime.
+*  The objects are stored in generation order, so parents come before their children and later objects are drawn on top of earlier ones.
+*  The sprites of the images live in the sprite cache inside this asset, unless the generator settings name a shared one.
+*/
+UCLASS(BlueprintType)
+class MANIACMANFRED_API ULocationCookedLayout : public UDataAsset
+{
+	GENERATED_BODY()
+
+public:
+
+	/* The technical name of the articy location */
+	UPROPERTY(VisibleAnywhere, BlueprintReadOnly, Category = "Cooked Layout")
+	FName LocationName;
+
+	UPROPERTY(VisibleAnywhere, Category = "Cooked Layout")
+	float PixelsToUnits = 1;
+
+	/* Hash over the signatures of all objects, changes whenever anything the actors are generated from changes */
+	UPROPERTY(VisibleAnywhere, Category = "Cooked Layout")
+	uint32 Signature = 0;
+
+	UPROPERTY(VisibleAnywhere, Category = "Cooked Layout")
+	TArray<FLocationCookedObject> Objects;
+
+	/* Index of the background layer in Objects, INDEX_NONE if the location has none */
+	UPROPERTY(VisibleAnywhere, BlueprintReadOnly, Category = "Cooked Layout")
+	int32 BackgroundLayer = INDEX_NONE;
+
+	/* The cache the sprites of the images were created in when the generator settings didn't name a shared one */
+	UPROPERTY(VisibleAnywhere, Category = "Cooked Layout")
+	TObjectPtr<ULocationSpriteCache> SpriteCache = nullptr;
+};
@@ -0,0 +1,69 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#include "LocationDataComponent.h"
+#include "GameFramework/Actor.h"
+
+bool ULocationDataComponent::FindEntry(const FArticyId& Id, FLocationDataEntry& OutEntry) const
+{
+	// the index isn't saved with the level, a component that was loaded only has its entries
+	if (IndexById.Num() != Entries.Num())
+		RebuildIndex();
+
+	const int32* index = IndexById.Find(Id);
+	if (!index)
+		return false;
+
+	OutEntry = Entries[*index];
+	return true;
+}
+
+TArray<FLocationDataEntry> ULocationDataComponent::GetEntriesOfType(EManiacManfredShapeType ShapeType) const
+{
+	return Entries.FilterByPredicate([ShapeType](const FLocationDataEntry& Entry) { return Entry.ShapeType == ShapeType; });
+}
+
+int32 ULocationDataComponent::FindNearestEntry(FVector WorldLocation, EManiacManfredShapeType ShapeType) const
+{
+	int32 nearest = INDEX_NONE;
+	double nearestDistance = TNumericLimits<double>::Max();
+
+	for (int32 i = 0; i < Entries.Num(); ++i)
+	{
+		const FLocationDataEntry& entry = Entries[i];
+		if (entry.ShapeType != ShapeType)
+			continue;
+
+		// the location lies in the X/Z plane, Y only holds the sort priority
+		const double distance = FVector2D::DistSquared(FVector2D(entry.Location.X, entry.Location.Z), FVector2D(WorldLocation.X, WorldLocation.Z));
+		if (distance < nearestDistance)
+		{
+			nearest = i;
+			nearestDistance = distance;
+		}
+	}
+
+	return nearest;
+}
+
+ULocationDataComponent* ULocationDataComponent::FindGenerated(AActor* GeneratingActor)
+{
+	if (!GeneratingActor)
+		return nullptr;
+
+	for (AActor* child : GeneratingActor->Children)
+	{
+		if (ULocationDataComponent* component = child ? child->FindComponentByClass<ULocationDataComponent>() : nullptr)
+			return component;
+	}
+
+	return nullptr;
+}
+
+void ULocationDataComponent::RebuildIndex() const
+{
+	IndexById.Reset();
+	IndexById.Reserve(Entries.Num());
+
+	for (int32 i = 0; i < Entries.Num(); ++i)
+		IndexById.Add(Entries[i].Id, i);
+}
@@ -0,0 +1,79 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Components/ActorComponent.h"
+#include "ArticyBaseInclude.h"
+#include "ArticyGenerated/ManiacManfredArticyTypes.h"
+#include "LocationDataComponent.generated.h"
+
+/* A location object that has nothing to draw or click, e.g. a spot, a link or a path */
+USTRUCT(BlueprintType)
+struct MANIACMANFRED_API FLocationDataEntry
+{
+	GENERATED_BODY()
+
+public:
+
+	UPROPERTY(VisibleAnywhere, BlueprintReadOnly, Category = "Location Data")
+	FArticyId Id;
+
+	UPROPERTY(VisibleAnywhere, BlueprintReadOnly, Category = "Location Data")
+	FName Label;
+
+	/* Spot, Link or Path */
+	UPROPERTY(VisibleAnywhere, BlueprintReadOnly, Category = "Location Data")
+	EManiacManfredShapeType ShapeType = EManiacManfredShapeType::Invalid;
+
+	/* Where the actor of the object would have been placed */
+	UPROPERTY(VisibleAnywhere, BlueprintReadOnly, Category = "Location Data")
+	FVector Location = FVector::ZeroVector;
+
+	/* The vertices of links and paths as they were drawn in articy, in articy coordinates with the y axis pointing down */
+	UPROPERTY(VisibleAnywhere, BlueprintReadOnly, Category = "Location Data")
+	TArray<FVector2D> Vertices;
+
+	/* Index of the closest parent entry, INDEX_NONE if the parent isn't an entry of this component */
+	UPROPERTY(VisibleAnywhere, BlueprintReadOnly, Category = "Location Data")
+	int32 Parent = INDEX_NONE;
+
+	UPROPERTY(VisibleAnywhere, BlueprintReadOnly, Category = "Location Data")
+	bool bVisible = true;
+};
+
+/* Holds the location objects the LocationGenerator doesn't spawn actors for, see FLocationGeneratorSettings::bLightweightObjects.
+*  The entries are stored in generation order, like the objects of a FLocationLayout.
+*/
+UCLASS(ClassGroup = "Location Generator", meta = (BlueprintSpawnableComponent))
+class MANIACMANFRED_API ULocationDataComponent : public UActorComponent
+{
+	GENERATED_BODY()
+
+public:
+
+	UPROPERTY(VisibleAnywhere, BlueprintReadOnly, Category = "Location Data")
+	TArray<FLocationDataEntry> Entries;
+
+	/* Returns false if the articy object has no entry */
+	UFUNCTION(BlueprintCallable, Category = "Location Data")
+	bool FindEntry(const FArticyId& Id, FLocationDataEntry& OutEntry) const;
+
+	UFUNCTION(BlueprintCallable, Category = "Location Data")
+	TArray<FLocationDataEntry> GetEntriesOfType(EManiacManfredShapeType ShapeType) const;
+
+	/* Returns the index of the entry of the given type that lies closest to a world location (Y is ignored), INDEX_NONE if there is none */
+	UFUNCTION(BlueprintCallable, Category = "Location Data")
+	int32 FindNearestEntry(FVector WorldLocation, EManiacManfredShapeType ShapeType) const;
+
+	/* The data component the LocationGenerator created below a generating actor, null if all objects got actors */
+	UFUNCTION(BlueprintCallable, Category = "Location Data")
+	static ULocationDataComponent* FindGenerated(AActor* GeneratingActor);
+
+	/* Has to be called after changing Entries from code */
+	void RebuildIndex() const;
+
+private:
+
+	mutable TMap<FArticyId, int32> IndexById;
+};
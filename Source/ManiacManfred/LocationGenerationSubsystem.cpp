@@ -0,0 +1,171 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#include "LocationGenerationSubsystem.h"
+#include "Framework/Application/SlateApplication.h"
+#include "Framework/Notifications/NotificationManager.h"
+#include "Widgets/Notifications/SNotificationList.h"
+
+int32 ULocationGenerationSubsystem::GenerateLocation(UManiacManfredLocation* Location, float PixelsToUnits, const TMap<TSubclassOf<class UArticyBaseObject>, TSubclassOf<class UActorComponent>>& ObjectComponentMap,
+	const FLocationGeneratorSettings& Settings, AActor* WorldContext, float TimeBudgetMilliseconds, int32 MaxObjectsPerTick)
+{
+#if WITH_EDITOR
+
+	if (!Location || !WorldContext)
+		return INDEX_NONE;
+
+	// both generations would collect the actors of the other one as previously generated ones
+	for (int32 i = Generations.Num() - 1; i >= 0; --i)
+	{
+		if (Generations[i].WorldContext == WorldContext)
+			CancelGeneration(Generations[i].Handle);
+	}
+
+	FGeneration& generation = Generations.AddDefaulted_GetRef();
+	generation.Handle = NextHandle++;
+	generation.Job = MakeUnique<FLocationGenerationJob>(Location, PixelsToUnits, ObjectComponentMap, Settings, WorldContext);
+	generation.WorldContext = WorldContext;
+	generation.TimeBudgetSeconds = FMath::Max(TimeBudgetMilliseconds, 0.1f) / 1000.0;
+	generation.MaxObjectsPerTick = FMath::Max(MaxObjectsPerTick, 1);
+
+	ShowProgress(generation);
+	return generation.Handle;
+
+#else
+	return INDEX_NONE;
+#endif // WITH_EDITOR
+}
+
+bool ULocationGenerationSubsystem::CancelGeneration(int32 Handle)
+{
+	const int32 index = Generations.IndexOfByPredicate([Handle](const FGeneration& Generation) { return Generation.Handle == Handle; });
+	if (index == INDEX_NONE)
+		return false;
+
+	FGeneration generation = MoveTemp(Generations[index]);
+	Generations.RemoveAt(index);
+
+	generation.Job->Cancel();
+	CloseProgress(generation);
+
+	// only after removing it, the delegate might start or cancel generations itself
+	OnLocationGenerated.Broadcast(Handle, true, nullptr);
+	return true;
+}
+
+bool ULocationGenerationSubsystem::IsGenerating(int32 Handle) const
+{
+	return Generations.ContainsByPredicate([Handle](const FGeneration& Generation) { return Generation.Handle == Handle; });
+}
+
+void ULocationGenerationSubsystem::Tick(float DeltaTime)
+{
+	Super::Tick(DeltaTime);
+
+	if (Generations.Num() == 0)
+		return;
+
+	// locations are generated one after another, so the first one is complete as early as possible
+	FGeneration& generation = Generations[0];
+	if (!generation.WorldContext.IsValid())
+	{
+		UE_LOG(LogTemp, Warning, TEXT("The actor generating location %s was removed, cancelling it."), *generation.Job->GetLocationName().ToString());
+		CancelGeneration(generation.Handle);
+		return;
+	}
+
+	if (!generation.Job->Tick(FPlatformTime::Seconds() + generation.TimeBudgetSeconds, generation.MaxObjectsPerTick))
+	{
+		ShowProgress(generation);
+		return;
+	}
+
+	FGeneration completed = MoveTemp(generation);
+	Generations.RemoveAt(0);
+	CloseProgress(completed);
+
+	// only after removing it, the delegate might start or cancel generations itself
+	OnLocationGenerated.Broadcast(completed.Handle, false, completed.Job->GetBackgroundLayer());
+}
+
+TStatId ULocationGenerationSubsystem::GetStatId() const
+{
+	RETURN_QUICK_DECLARE_CYCLE_STAT(ULocationGenerationSubsystem, STATGROUP_Tickables);
+}
+
+void ULocationGenerationSubsystem::Deinitialize()
+{
+	// the level is unloaded together with the actors spawned so far, there is nothing to roll back
+	for (FGeneration& generation : Generations)
+		CloseProgress(generation);
+	Generations.Reset();
+
+	Super::Deinitialize();
+}
+
+void ULocationGenerationSubsystem::AddReferencedObjects(UObject* InThis, FReferenceCollector& Collector)
+{
+	for (FGeneration& generation : CastChecked<ULocationGenerationSubsystem>(InThis)->Generations)
+		generation.Job->AddReferencedObjects(Collector);
+
+	Super::AddReferencedObjects(InThis, Collector);
+}
+
+void ULocationGenerationSubsystem::ShowProgress(FGeneration& Generation)
+{
+#if WITH_EDITOR
+
+	// commandlets and the game have no notifications to show
+	if (!FSlateApplication::IsInitialized())
+		return;
+
+	const FLocationGenerationJob& job = *Generation.Job;
+	const FText text = FText::FromString(FString::Printf(TEXT("Generating %s: %d of %d objects"), *job.GetLocationName().ToString(), job.GetSpawnedObjects(), job.GetTotalObjects()));
+
+	if (Generation.Notification.IsValid())
+	{
+		Generation.Notification->SetText(text);
+		return;
+	}
+
+	// a scoped slow task only lasts as long as a single call, the notification stays up while the generation is spread over the ticks
+	const int32 handle = Generation.Handle;
+	FNotificationInfo info(text);
+	info.bFireAndForget = false;
+	info.bUseThrobber = true;
+	info.ExpireDuration = 2.0f;
+	info.ButtonDetails.Add(FNotificationButtonInfo(FText::FromString(TEXT("Cancel")), FText::FromString(TEXT("Stops the generation and restores the previously generated actors")),
+		FSimpleDelegate::CreateWeakLambda(this, [this, handle]() { CancelGeneration(handle); }), SNotificationItem::CS_Pending));
+
+	Generation.Notification = FSlateNotificationManager::Get().AddNotification(info);
+	if (Generation.Notification.IsValid())
+		Generation.Notification->SetCompletionState(SNotificationItem::CS_Pending);
+
+#endif // WITH_EDITOR
+}
+
+void ULocationGenerationSubsystem::CloseProgress(FGeneration& Generation)
+{
+#if WITH_EDITOR
+
+	if (!Generation.Notification.IsValid())
+		return;
+
+	const FLocationGenerationJob& job = *Generation.Job;
+	const FString locationName = job.GetLocationName().ToString();
+
+	if (job.IsComplete())
+	{
+		Generation.Notification->SetText(FText::FromString(FString::Printf(TEXT("Generated %s: %d objects"), *locationName, job.GetTotalObjects())));
+		Generation.Notification->SetCompletionState(SNotificationItem::CS_Success);
+	}
+	else
+	{
+		Generation.Notification->SetText(FText::FromString(FString::Printf(TEXT("Cancelled generating %s, the previous actors were kept"), *locationName)));
+		Generation.Notification->SetCompletionState(SNotificationItem::CS_Fail);
+	}
+
+	Generation.Notification->ExpireAndFadeout();
+	Generation.Notification.Reset();
+
+#endif // WITH_EDITOR
+}
@@ -0,0 +1,66 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Subsystems/WorldSubsystem.h"
+#include "LocationGenerator.h"
+#include "LocationGenerationSubsystem.generated.h"
+
+class SNotificationItem;
+
+DECLARE_DYNAMIC_MULTICAST_DELEGATE_ThreeParams(FOnLocationGenerated, int32, Handle, bool, bCancelled, UManiacManfredLocationImage*, BackgroundLayer);
+
+/* Generates locations in the editor without freezing it, the actors are spawned over several ticks, never spending more than the time budget per tick.
+*  While a location is generated, a notification shows the progress and allows to cancel it. A cancelled generation is rolled back to the actors that existed before.
+*/
+UCLASS()
+class MANIACMANFRED_API ULocationGenerationSubsystem : public UTickableWorldSubsystem
+{
+	GENERATED_BODY()
+
+public:
+
+	/* Starts generating a location, the same as ULocationGenerator::GenerateLocationWithSettings does at once.
+	*  The returned handle identifies it in OnLocationGenerated and CancelGeneration. A generation still running for the same WorldContext is cancelled.
+	*/
+	UFUNCTION(BlueprintCallable, Category = "Location Generator")
+	int32 GenerateLocation(UManiacManfredLocation* Location, float PixelsToUnits, const TMap<TSubclassOf<class UArticyBaseObject>, TSubclassOf<class UActorComponent>>& ObjectComponentMap,
+		const FLocationGeneratorSettings& Settings, AActor* WorldContext, float TimeBudgetMilliseconds = 8.0f, int32 MaxObjectsPerTick = 64);
+
+	/* Stops generating a location and restores the previously generated actors, returns false if the location was already completed */
+	UFUNCTION(BlueprintCallable, Category = "Location Generator")
+	bool CancelGeneration(int32 Handle);
+
+	UFUNCTION(BlueprintCallable, Category = "Location Generator")
+	bool IsGenerating(int32 Handle) const;
+
+	/* Called once a location is complete or was cancelled, BackgroundLayer is the background image of a completed location if it has one */
+	UPROPERTY(BlueprintAssignable, Category = "Location Generator")
+	FOnLocationGenerated OnLocationGenerated;
+
+	virtual void Tick(float DeltaTime) override;
+	virtual TStatId GetStatId() const override;
+	virtual bool IsTickableInEditor() const override { return true; }
+	virtual void Deinitialize() override;
+
+	static void AddReferencedObjects(UObject* InThis, FReferenceCollector& Collector);
+
+private:
+
+	struct FGeneration
+	{
+		int32 Handle = 0;
+		TUniquePtr<FLocationGenerationJob> Job;
+		TWeakObjectPtr<AActor> WorldContext;
+		double TimeBudgetSeconds = 0;
+		int32 MaxObjectsPerTick = 0;
+		TSharedPtr<SNotificationItem> Notification;
+	};
+
+	void ShowProgress(FGeneration& Generation);
+	void CloseProgress(FGeneration& Generation);
+
+	TArray<FGeneration> Generations;
+	int32 NextHandle = 1;
+};
@@ -3,310 +3,2291 @@
 #include "LocationGenerator.h"
 #include "Engine/World.h"
 #include "ArticyReference.h"
+#include "LocationBinaryLayout.h"
+#include "LocationCookedLayout.h"
+#include "LocationDataComponent.h"
+#include "LocationLayout.h"
+#include "LocationOverdraw.h"
+#include "LocationSpriteCache.h"
+#include "LocationTextureBudget.h"
+#include "LocationZoneBehaviour.h"
 #include "Paper2DClasses.h"
+#include "Async/ParallelFor.h"
+#include "Components/TextRenderComponent.h"
+#include "HAL/MemoryBase.h"
+#include "Materials/MaterialInterface.h"
 #include "UObject/UObjectGlobals.h"
+#include "UObject/UObjectArray.h"
 
 /* This class will take care of populating a Unreal level with elements from an articy location.
 *  The goal of this class is to very quickly and easily fill your scene from an articy location and it should give you an idea how you can use the plugin
 *  for editor scripts.
-* 
-*  Note: This is a quick and dirty LocationGenerator and is used specifically for the Maniac Manfred Adventure Demo project, while it might work for your projects, you might have to 
+*
+*  Note: This is a quick and dirty LocationGenerator and is used specifically for the Maniac Manfred Adventure Demo project, while it might work for your projects, you might have to
 *  modify a lot of it to make it work for you.
+*
+*  The generation runs in two phases: first we flatten the articy location once into a FLocationLayout and compute everything that is pure data
+*  (bounds, collider polygons, transforms) for all objects in parallel, then we spawn and set up the actors on the game thread using these precomputed values.
 */
 
+DEFINE_STAT(STAT_LocationGenerator_Clear);
+DEFINE_STAT(STAT_LocationGenerator_Layout);
+DEFINE_STAT(STAT_LocationGenerator_Bounds);
+DEFINE_STAT(STAT_LocationGenerator_Spawn);
+DEFINE_STAT(STAT_LocationGenerator_Sprite);
+DEFINE_STAT(STAT_LocationGenerator_Collider);
+DEFINE_STAT(STAT_LocationGenerator_Transform);
+
+DECLARE_CYCLE_STAT(TEXT("Generate"), STAT_LocationGenerator_Generate, STATGROUP_LocationGenerator);
+DECLARE_DWORD_COUNTER_STAT(TEXT("Actors spawned"), STAT_LocationGenerator_ActorsSpawned, STATGROUP_LocationGenerator);
+DECLARE_DWORD_COUNTER_STAT(TEXT("Components added"), STAT_LocationGenerator_ComponentsAdded, STATGROUP_LocationGenerator);
+DECLARE_DWORD_COUNTER_STAT(TEXT("Vertices processed"), STAT_LocationGenerator_VerticesProcessed, STATGROUP_LocationGenerator);
+DECLARE_DWORD_COUNTER_STAT(TEXT("Textures loaded"), STAT_LocationGenerator_TexturesLoaded, STATGROUP_LocationGenerator);
+DECLARE_DWORD_COUNTER_STAT(TEXT("Sprites created"), STAT_LocationGenerator_SpritesCreated, STATGROUP_LocationGenerator);
+
+/* How a node ends up in the level, see FLocationGeneratorSettings::bLightweightObjects */
+enum class ELocationNodeRepresentation : uint8
+{
+	/* its own sprite actor, for images, zones and everything that gets components from the object-component map */
+	Actor,
+	/* an entry of the location data component, for spots, links and paths */
+	Data,
+	/* a text render component of the location data actor */
+	Text,
+};
+
+/* The results of the data phase for a single object of the location layout */
+struct FLocationPlanNode
+{
+	/* Resolved on the game thread before the parallel phase, null if the articy object doesn't exist anymore */
+	const UClass* Class = nullptr;
+	FName Label;
+	UManiacManfredLocationImage* LocationImage = nullptr;
+	UManiacManfredLocationText* LocationText = nullptr;
+
+	/* Spots, links and paths have nothing to draw or click */
+	bool bDataObject = false;
+	ELocationNodeRepresentation Representation = ELocationNodeRepresentation::Actor;
+
+	/* How the sprite of a location image shows its image, and the size of the whole image in pixels */
+	FLocationSpriteOptions SpriteOptions;
+	FIntPoint ImageSize = FIntPoint::ZeroValue;
+
+	/* Images with at most this share of partially transparent pixels are drawn opaque or masked, negative if the image keeps the default sprite material */
+	float MaskedAlphaTolerance = -1.0f;
+
+	TArray<TSubclassOf<UActorComponent>> Components;
+	bool bHasZoneScript = false;
+
+	/* The bounds used for positioning and the bounds this object adds to the overall location bounds */
+	FRect Bounds = FRect();
+	FRect OverallBoundsContribution = FRect();
+	FVector ActorLocation = FVector::ZeroVector;
+	uint32 Signature = 0;
+
+	/* The simplified and/or convex decomposed collider of a zone, empty if the collider uses the scaled polygon as it is */
+	TArray<TArray<FVector2D>> ColliderShapes;
+
+	/* Drawn by a grouped sprite component instead of its own actor, see FLocationGeneratorSettings::bBatchStaticImages */
+	bool bBatched = false;
+};
+
+/* The components of the object-component map resolved per articy class, so every object needs a single lookup instead of an IsA per map entry */
+struct FLocationComponentTable
+{
+	struct FEntry
+	{
+		TArray<TSubclassOf<UActorComponent>> Components;
+		/* One of the components implements ILocationZoneBehaviour */
+		bool bZoneBehaviour = false;
+	};
+
+	/* Resolves the classes of all objects of the layout, afterwards the table is only read, also from several threads */
+	void Build(const FLocationLayout& Layout, const TMap<TSubclassOf<class UArticyBaseObject>, TSubclassOf<class UActorComponent>>& ObjectComponentMap);
+
+	const FEntry& Find(const UClass* Class) const
+	{
+		const FEntry* entry = Entries.Find(Class);
+		return entry ? *entry : Empty;
+	}
+
+	TMap<const UClass*, FEntry> Entries;
+	FEntry Empty;
+};
+
+/* The flattened location and everything we precomputed for it, every node has the same index as its object in the layout */
+struct FLocationGenerationPlan
+{
+	FLocationLayout Layout;
+	TArray<FLocationPlanNode> Nodes;
+	/* Scaled collider polygons of all objects, using the same ranges as the vertices of the layout */
+	TArray<FVector2D> ColliderPoints;
+	FRect OverallBounds = FRect();
+	FLocationComponentTable ComponentTable;
+
+	TArrayView<const FVector2D> GetColliderPoints(int32 Index) const
+	{
+		return TArrayView<const FVector2D>(ColliderPoints.GetData() + Layout.VertexStarts[Index], Layout.VertexCounts[Index]);
+	}
+};
+
+/* What UpdateKeptActor may change on an actor we keep when reconciling */
+struct FKeptActorState
+{
+	TWeakObjectPtr<APaperSpriteActor> Actor;
+#if WITH_EDITOR
+	FString Label;
+#endif // WITH_EDITOR
+	FVector Location = FVector::ZeroVector;
+	int32 SortPriority = 0;
+};
+
+/* Everything the generation needs to know, so we don't have to pass it along as single parameters */
+struct FLocationGenerationContext
+{
+	FLocationGenerationContext(const TMap<TSubclassOf<class UArticyBaseObject>, TSubclassOf<class UActorComponent>>& InObjectComponentMap, UManiacManfredLocationImage*& InBackgroundLayer,
+		const FLocationGeneratorSettings& InSettings, float InPixelsToUnits, AActor* InWorldContext)
+		: ObjectComponentMap(InObjectComponentMap)
+		, BackgroundLayer(InBackgroundLayer)
+		, Settings(InSettings)
+		, PixelsToUnits(InPixelsToUnits)
+		, WorldContext(InWorldContext)
+		, StartTime(FPlatformTime::Seconds())
+	{
+		// baking a location doesn't need a world, only the generation of actors does
+		if (WorldContext)
+		{
+			World = GEngine->GetWorldFromContextObject(WorldContext, EGetWorldErrorMode::Assert);
+			Database = UArticyDatabase::Get(WorldContext);
+			SpriteCache = Settings.SpriteCache ? Settings.SpriteCache.Get() : ULocationSpriteCache::GetOrCreateForActor(WorldContext);
+		}
+		else
+		{
+			Database = UArticyDatabase::GetMutableOriginal();
+			SpriteCache = Settings.SpriteCache.Get();
+		}
+
+		if (Settings.bClassifyImageAlpha)
+		{
+			OpaqueMaterial = Settings.OpaqueSpriteMaterial ? Settings.OpaqueSpriteMaterial.Get() : LoadObject<UMaterialInterface>(nullptr, TEXT("/Paper2D/OpaqueUnlitSpriteMaterial.OpaqueUnlitSpriteMaterial"));
+			MaskedMaterial = Settings.MaskedSpriteMaterial ? Settings.MaskedSpriteMaterial.Get() : LoadObject<UMaterialInterface>(nullptr, TEXT("/Paper2D/MaskedUnlitSpriteMaterial.MaskedUnlitSpriteMaterial"));
+		}
+	}
+
+	const TMap<TSubclassOf<class UArticyBaseObject>, TSubclassOf<class UActorComponent>>& ObjectComponentMap;
+	UManiacManfredLocationImage*& BackgroundLayer;
+
+	FLocationGeneratorSettings Settings;
+	float PixelsToUnits = 1;
+	AActor* WorldContext = nullptr;
+	UWorld* World = nullptr;
+	UArticyDatabase* Database = nullptr;
+	ULocationSpriteCache* SpriteCache = nullptr;
+
+	/* Only used when classifying image alpha: the materials of opaque and masked images */
+	UMaterialInterface* OpaqueMaterial = nullptr;
+	UMaterialInterface* MaskedMaterial = nullptr;
+
+	/* Only used when reconciling: the previously generated actors by the articy object they represent and the ones we decided to keep */
+	TMap<FArticyId, TWeakObjectPtr<APaperSpriteActor>> ExistingActors;
+	TSet<AActor*> KeptActors;
+	int32 KeptCount = 0;
+	int32 CreatedCount = 0;
+	int32 UpdatedCount = 0;
+	int32 DeletedCount = 0;
+
+	/* The previously generated actors, they are only removed once the new ones are complete (when reconciling only the ones we didn't keep) */
+	TArray<TWeakObjectPtr<AActor>> PreviousActors;
+
+	/* The node spawned next and the actor of every node spawned so far (null for batched images), spawning may be spread over several ticks */
+	int32 NextNode = 0;
+	TArray<TWeakObjectPtr<APaperSpriteActor>> NodeActors;
+
+	/* Everything needed to roll back a cancelled generation: the actors we spawned, the previous owners of the kept actors we moved,
+	*  how the kept actors we updated in place looked before and the atlases the images were packed into
+	*/
+	TArray<TWeakObjectPtr<AActor>> CreatedActors;
+	TArray<TPair<TWeakObjectPtr<AActor>, TWeakObjectPtr<AActor>>> PreviousOwners;
+	TArray<FKeptActorState> PreviousStates;
+	FLocationAtlasSnapshot AtlasSnapshot;
+
+	/* What the generation did, for the summary after it and the stat group */
+	double StartTime = 0;
+	int32 SpawnedActorCount = 0;
+	int32 AddedComponentCount = 0;
+	int32 StartTextureLoads = 0;
+	int32 StartSpritesCreated = 0;
+
+	/* The actor holding the batched images and the component the next batched image is added to.
+	*  When reconciling the previous batch actor is kept as it is if none of its images changed, then no image is batched again.
+	*/
+	APaperGroupedSpriteActor* BatchActor = nullptr;
+	uint32 BatchSignature = 0;
+	bool bKeptBatchActor = false;
+	UPaperGroupedSpriteComponent* BatchComponent = nullptr;
+	/* Opaque and masked images write depth, so they don't need to be split into batches by what is drawn in between them */
+	UPaperGroupedSpriteComponent* DepthSortedBatchComponent = nullptr;
+	int32 BatchedImageCount = 0;
+	int32 BatchComponentCount = 0;
+
+	/* Only used for lightweight objects: the actor holding the data component and the text render components, and the data entry of every node.
+	*  Like the batch actor, the previous data actor is kept when reconciling if none of its objects changed.
+	*/
+	AActor* DataActor = nullptr;
+	uint32 DataSignature = 0;
+	bool bKeptDataActor = false;
+	ULocationDataComponent* DataComponent = nullptr;
+	TArray<int32> DataEntryIndices;
+	int32 TextComponentCount = 0;
+
+	/* Only used when streaming textures: actors whose sprite is set as soon as its texture arrived, with the index of their node */
+	TArray<TPair<TWeakObjectPtr<APaperSpriteActor>, int32>> PendingSprites;
+	int32 StreamedTextureCount = 0;
+	int32 DeferredSpriteCount = 0;
+};
+
+const TCHAR* FLocationGeneratorStats::GetPhaseName(ELocationGeneratorPhase Phase)
+{
+	switch (Phase)
+	{
+	case ELocationGeneratorPhase::Clear: return TEXT("Clear");
+	case ELocationGeneratorPhase::Layout: return TEXT("Layout");
+	case ELocationGeneratorPhase::Bounds: return TEXT("Bounds");
+	case ELocationGeneratorPhase::Spawn: return TEXT("Spawn");
+	case ELocationGeneratorPhase::Sprite: return TEXT("Sprite");
+	case ELocationGeneratorPhase::Collider: return TEXT("Collider");
+	case ELocationGeneratorPhase::Transform: return TEXT("Transform");
+	default: return TEXT("Unknown");
+	}
+}
+
+FLocationGeneratorPhaseScope::FLocationGeneratorPhaseScope(FLocationGeneratorStats* InStats, ELocationGeneratorPhase InPhase)
+	: Stats(InStats)
+	, Phase(InPhase)
+{
+	if (Stats)
+	{
+		StartObjectCount = GUObjectArray.GetObjectArrayNumMinusAvailable();
+		StartUsedMemory = FPlatformMemory::GetStats().UsedPhysical;
+		StartAllocations = GetAllocationCount();
+		StartTime = FPlatformTime::Seconds();
+	}
+}
+
+FLocationGeneratorPhaseScope::~FLocationGeneratorPhaseScope()
+{
+	if (Stats)
+	{
+		// the time is taken first, so reading the memory stats doesn't count towards the phase
+		const double endTime = FPlatformTime::Seconds();
+		const uint64 endAllocations = GetAllocationCount();
+		const FPlatformMemoryStats memoryStats = FPlatformMemory::GetStats();
+
+		FLocationGeneratorPhaseStats& phaseStats = (*Stats)[Phase];
+		phaseStats.Seconds += endTime - StartTime;
+		phaseStats.ObjectCountDelta += GUObjectArray.GetObjectArrayNumMinusAvailable() - StartObjectCount;
+		phaseStats.UsedMemoryDelta += (int64)memoryStats.UsedPhysical - (int64)StartUsedMemory;
+		phaseStats.PeakUsedMemory = FMath::Max<uint64>(phaseStats.PeakUsedMemory, memoryStats.PeakUsedPhysical);
+		phaseStats.Allocations += endAllocations - StartAllocations;
+		++phaseStats.Scopes;
+	}
+}
+
+uint64 FLocationGeneratorPhaseScope::GetAllocationCount()
+{
+#if !UE_BUILD_SHIPPING
+	// only counted by allocators that support it, e.g. the binned ones the editor uses
+	return (uint64)FMalloc::TotalMallocCalls + (uint64)FMalloc::TotalReallocCalls;
+#else
+	return 0;
+#endif
+}
+
+/* Generated actors carry a tag with a hash of everything they were generated from, so we can tell if they are outdated */
+static const FString SignatureTagPrefix = TEXT("LocationGenerator.");
 
 void GetAllChildrenRecursive(AActor* Actor, TArray<AActor*>* Children)
 {
-	auto children = Actor->Children;
-	for (int i = 0; i < children.Num(); ++i)
+	auto children = Actor->Children;
+	for (int i = 0; i < children.Num(); ++i)
+	{
+		auto child = children[i];
+		Children->Add(child);
+		GetAllChildrenRecursive(child, Children);
+	}
+}
+
+/* Determines the name for an actor depending on the articy object it should represent */
+FName GetNameForActor(const UArticyObject* ArticyObject)
+{
+	// display name > technical name
+	FName finalName = ArticyObject->GetTechnicalName();
+	auto displayName = Cast<IArticyObjectWithDisplayName>(ArticyObject);
+	if (displayName)
+		finalName = FName(*displayName->GetDisplayName().ToString());
+
+	// if the object is an target (e.g. an object link in an articy location),
+	// we use the name of the target
+	auto target = Cast<IArticyObjectWithTarget>(ArticyObject);
+	if (target)
+	{
+		auto targetObj = Cast<UArticyObject>(target->GetTarget());
+		if (targetObj)
+			return GetNameForActor(targetObj);
+	}
+
+	return finalName;
+}
+
+/* The part of its image a location image shows in image pixels, empty if it shows the whole image */
+FIntRect GetImageClipRect(const UManiacManfredLocationImage& Image)
+{
+	const FIntPoint imageSize(Image.CachedImageWidth, Image.CachedImageHeight);
+	const FArticyRect& clipRect = Image.ClipRect;
+	if (imageSize.X <= 0 || imageSize.Y <= 0 || clipRect.w <= 0 || clipRect.h <= 0)
+		return FIntRect();
+
+	// a clip rect that fits into the unit square is relative to the image size
+	const FVector2D scale = (clipRect.x + clipRect.w <= 1 && clipRect.y + clipRect.h <= 1) ? FVector2D(imageSize) : FVector2D(1, 1);
+	FIntRect rect(FMath::FloorToInt(clipRect.x * scale.X), FMath::FloorToInt(clipRect.y * scale.Y),
+		FMath::CeilToInt((clipRect.x + clipRect.w) * scale.X), FMath::CeilToInt((clipRect.y + clipRect.h) * scale.Y));
+
+	const FIntRect wholeImage(FIntPoint::ZeroValue, imageSize);
+	rect.Clip(wholeImage);
+	if (rect.Width() <= 0 || rect.Height() <= 0 || rect == wholeImage)
+		return FIntRect();
+
+	return rect;
+}
+
+/* Component Blueprints made before ILocationZoneBehaviour existed are still recognized by their name, with a warning to add the interface */
+static bool IsZoneBehaviour(UClass* ComponentClass)
+{
+	if (ComponentClass->ImplementsInterface(ULocationZoneBehaviour::StaticClass()))
+		return true;
+
+	if (!ComponentClass->GetName().Contains(TEXT("ClickableZone")))
+		return false;
+
+	UE_LOG(LogTemp, Warning, TEXT("%s is treated as zone behaviour because of its name, add the LocationZoneBehaviour interface to it."), *ComponentClass->GetPathName());
+	return true;
+}
+
+void FLocationComponentTable::Build(const FLocationLayout& Layout, const TMap<TSubclassOf<class UArticyBaseObject>, TSubclassOf<class UActorComponent>>& ObjectComponentMap)
+{
+	Entries.Reset();
+
+	// the map usually names only a few classes, which a location uses over and over
+	TMap<UClass*, bool> zoneBehaviours;
+
+	for (const TWeakObjectPtr<UArticyObject>& object : Layout.Objects)
+	{
+		const UClass* objectClass = object.IsValid() ? object->GetClass() : nullptr;
+		if (!objectClass || Entries.Contains(objectClass))
+			continue;
+
+		/* We created in Blueprint an object-component map, which uses the type of an articy object as key
+		*  and the component that should be attached to the actor representation of this articy object.
+		*  (e.g. articy objects of type ConditionalZone should have an ClickableZone component attached)
+		*/
+		FEntry& entry = Entries.Add(objectClass);
+		for (auto& Pair : ObjectComponentMap)
+		{
+			if (!Pair.Key || !Pair.Value || !objectClass->IsChildOf(Pair.Key))
+				continue;
+
+			entry.Components.Add(Pair.Value);
+
+			const bool* bZoneBehaviour = zoneBehaviours.Find(Pair.Value);
+			if (!bZoneBehaviour)
+				bZoneBehaviour = &zoneBehaviours.Add(Pair.Value, IsZoneBehaviour(Pair.Value));
+
+			entry.bZoneBehaviour |= *bZoneBehaviour;
+		}
+	}
+}
+
+/* The background texture gets swapped at runtime (see UManiacManfredUtility::ChangeSpriteFromTexture), which only works as long as its sprite shows the whole texture.
+*  So the background is never packed into an atlas, clipped, fitted tightly, given another material or batched, and every actor showing it gets its own sprite.
+*/
+static bool KeepsWholeTexture(const FLocationLayout& Layout, int32 Index)
+{
+	return Layout.HasFlags(Index, ELocationLayoutFlags::BackgroundLayer);
+}
+
+/* Reads everything the layout doesn't contain from the articy object: its class, label, type and image settings.
+*  Looking up display names and link targets goes through UObjects and the articy database, so this runs on the game thread before the parallel phase.
+*/
+void ResolvePlanNode(FLocationGenerationPlan& Plan, int32 Index, const FLocationGeneratorSettings& Settings)
+{
+	const FLocationLayout& layout = Plan.Layout;
+	FLocationPlanNode& node = Plan.Nodes[Index];
+	UArticyObject* object = layout.Objects[Index].Get();
+	if (!object)
+		return;
+
+	node.Class = object->GetClass();
+	node.Label = GetNameForActor(object);
+
+	if (layout.HasFlags(Index, ELocationLayoutFlags::LocationImage))
+		node.LocationImage = Cast<UManiacManfredLocationImage>(object);
+
+	node.LocationText = Cast<UManiacManfredLocationText>(object);
+	node.bDataObject = object->IsA<UManiacManfredSpot>() || object->IsA<UManiacManfredLink>() || object->IsA<UManiacManfredPath>();
+
+	if (node.LocationImage && !KeepsWholeTexture(layout, Index))
+	{
+		node.ImageSize = FIntPoint(node.LocationImage->CachedImageWidth, node.LocationImage->CachedImageHeight);
+		node.SpriteOptions.Region = GetImageClipRect(*node.LocationImage);
+		node.SpriteOptions.bTightGeometry = Settings.bTightSpriteGeometry;
+		node.SpriteOptions.AlphaThreshold = Settings.SpriteAlphaThreshold;
+		node.MaskedAlphaTolerance = Settings.bClassifyImageAlpha ? Settings.MaskedAlphaTolerance : -1.0f;
+	}
+}
+
+/* Computes the bounds and collider polygon of a resolved node. Only reads the layout, the component table and its own node, so it runs in parallel. */
+void ExtractPlanNode(FLocationGenerationPlan& Plan, int32 Index, float PixelsToUnits, const FLocationGeneratorSettings& Settings)
+{
+	const FLocationLayout& layout = Plan.Layout;
+	FLocationPlanNode& node = Plan.Nodes[Index];
+
+	// objects that don't exist anymore are skipped, like the component table does
+	if (!node.Class)
+		return;
+
+	// the components of the object-component map were resolved per class before the parallel phase
+	const FLocationComponentTable::FEntry& components = Plan.ComponentTable.Find(node.Class);
+	node.Components = components.Components;
+	node.bHasZoneScript = components.bZoneBehaviour;
+
+	/* We calculate the bounds for every object with vertices, even if we don't want to attach a collider to it.
+	*  So we make sure, that we don't run into issues when we adjust the transformations
+	*/
+	if (layout.HasFlags(Index, ELocationLayoutFlags::HasVertices))
+	{
+		TArrayView<const FVector2D> vertices = layout.GetVertices(Index);
+		TArrayView<FVector2D> colliderPoints(Plan.ColliderPoints.GetData() + layout.VertexStarts[Index], vertices.Num());
+		const FVector2D pixelScale(1 / PixelsToUnits, 1 / PixelsToUnits);
+
+		// we calculate the overall bounds of this polygon and ajdust the pixel scaling for the collider in the same pass
+		FBox2D rawBounds = LocationGeometry::TransformAndComputeBounds(vertices, pixelScale, FVector2D::ZeroVector, colliderPoints);
+		FRect bounds = FRect::FromBox(rawBounds);
+
+		// for the overall bounds we also flip the y axis, because articy and unreal have a different y axis.
+		// Scaling and flipping are affine, so we can get the bounds from the raw bounds without touching the vertices again
+		node.OverallBoundsContribution = FRect::FromBox(LocationGeometry::TransformBounds(rawBounds, FVector2D(pixelScale.X, -pixelScale.Y), FVector2D(0, bounds.GetYMax() / PixelsToUnits)));
+
+		// zones are positioned by their raw bounds, everything else by the bounds of the scaled polygon
+		node.Bounds = node.bHasZoneScript ? bounds : FRect::FromBox(LocationGeometry::TransformBounds(rawBounds, pixelScale, FVector2D::ZeroVector));
+
+		// artists draw zones with far more vertices than a hit area needs, and concave colliders are more expensive for Paper2D
+		if (node.bHasZoneScript && (Settings.bSimplifyColliders || Settings.bDecomposeColliders))
+		{
+			TArray<FVector2D> outline;
+			if (Settings.bSimplifyColliders)
+				LocationGeometry::SimplifyPolygon(colliderPoints, Settings.ColliderSimplifyTolerance, outline);
+			else
+				outline.Append(colliderPoints.GetData(), colliderPoints.Num());
+
+			// if the outline can't be decomposed (e.g. it intersects itself), we keep it as a single shape
+			if (!Settings.bDecomposeColliders || !LocationGeometry::DecomposeIntoConvexPolygons(outline, node.ColliderShapes))
+			{
+				node.ColliderShapes.Reset();
+				node.ColliderShapes.Add(MoveTemp(outline));
+			}
+		}
+	}
+}
+
+/* Hashes the inputs an actor can't be updated with in place: what it is, which components and sprite it has and the shape of its collider.
+*  Label, position and sort priority of a kept actor are updated in place instead (see UpdateKeptActor), so moving or inserting one object
+*  doesn't invalidate the actors of all others.
+*/
+uint32 GetGenerationSignature(const FLocationGenerationPlan& Plan, int32 Index, float PixelsToUnits)
+{
+	const FLocationLayout& layout = Plan.Layout;
+	const FLocationPlanNode& node = Plan.Nodes[Index];
+
+	uint32 hash = GetTypeHash(node.Class ? node.Class->GetFName() : NAME_None);
+	hash = HashCombine(hash, GetTypeHash(layout.ShapeTypes[Index]));
+
+	// the collider points are scaled by it
+	hash = HashCombine(hash, GetTypeHash(PixelsToUnits));
+
+	if (layout.HasFlags(Index, ELocationLayoutFlags::HasVertices))
+	{
+		TArrayView<const FVector2D> vertices = layout.GetVertices(Index);
+		hash = HashCombine(hash, FCrc::MemCrc32(vertices.GetData(), vertices.Num() * sizeof(FVector2D)));
+	}
+
+	if (layout.HasFlags(Index, ELocationLayoutFlags::LocationImage))
+	{
+		hash = HashCombine(hash, GetTypeHash(layout.ImageAssets[Index]));
+		hash = HashCombine(hash, GetTypeHash(layout.HasFlags(Index, ELocationLayoutFlags::BackgroundLayer)));
+		hash = HashCombine(hash, GetTypeHash(node.SpriteOptions.Region.Min));
+		hash = HashCombine(hash, GetTypeHash(node.SpriteOptions.Region.Max));
+		hash = HashCombine(hash, GetTypeHash(node.SpriteOptions.bTightGeometry ? node.SpriteOptions.AlphaThreshold : -1.0f));
+		hash = HashCombine(hash, GetTypeHash(node.MaskedAlphaTolerance));
+	}
+
+	// the attached behaviours depend on the object-component map
+	for (auto& component : node.Components)
+		hash = HashCombine(hash, GetTypeHash(component.Get()));
+
+	// the collider depends on the simplification settings
+	for (auto& shape : node.ColliderShapes)
+		hash = HashCombine(hash, FCrc::MemCrc32(shape.GetData(), shape.Num() * sizeof(FVector2D)));
+
+	return hash;
+}
+
+/* Hashes what GetGenerationSignature leaves out: where a node ends up and how it is sorted.
+*  Actors are moved in place, but batch instances and data entries can't be, so the actor holding them has to be rebuilt if any of them moved.
+*/
+uint32 GetPlacementSignature(const FLocationGenerationPlan& Plan, int32 Index)
+{
+	const FLocationLayout& layout = Plan.Layout;
+	const FLocationPlanNode& node = Plan.Nodes[Index];
+
+	uint32 hash = HashCombine(node.Signature, GetTypeHash(node.Label));
+	hash = HashCombine(hash, GetTypeHash(node.ActorLocation));
+	hash = HashCombine(hash, GetTypeHash(layout.Translations[Index]));
+	hash = HashCombine(hash, GetTypeHash(layout.Scales[Index]));
+	hash = HashCombine(hash, GetTypeHash(layout.Rotations[Index]));
+	hash = HashCombine(hash, GetTypeHash(layout.SortPriorities[Index]));
+	return HashCombine(hash, GetTypeHash(layout.Flags[Index]));
+}
+
+/* Hashes everything the batch actor is built from: the batched images in the order they are added and the separately drawn images that split them into batches */
+uint32 GetBatchSignature(const FLocationGenerationPlan& Plan)
+{
+	uint32 hash = 0;
+	for (int32 i = 0; i < Plan.Nodes.Num(); ++i)
+	{
+		const FLocationPlanNode& node = Plan.Nodes[i];
+		if (!node.Class || !node.LocationImage)
+			continue;
+
+		hash = HashCombine(hash, node.bBatched ? GetPlacementSignature(Plan, i) : GetTypeHash(i));
+	}
+	return hash;
+}
+
+/* Hashes everything the location data actor is built from: the lightweight objects with their placement, the content of the texts and how they are shown */
+uint32 GetDataSignature(const FLocationGenerationPlan& Plan, const FLocationGeneratorSettings& Settings)
+{
+	uint32 hash = GetTypeHash(Settings.bShowLightweightTexts);
+	for (int32 i = 0; i < Plan.Nodes.Num(); ++i)
+	{
+		const FLocationPlanNode& node = Plan.Nodes[i];
+		if (!node.Class || node.Representation == ELocationNodeRepresentation::Actor)
+			continue;
+
+		// the parent of an entry is the index of another entry, so the order of the entries counts as well
+		hash = HashCombine(hash, HashCombine(GetPlacementSignature(Plan, i), GetTypeHash(i)));
+		hash = HashCombine(hash, HashCombine(GetTypeHash(node.Representation), GetTypeHash(Plan.Layout.ParentIndices[i])));
+		if (node.Representation == ELocationNodeRepresentation::Text)
+		{
+			hash = HashCombine(hash, GetTypeHash(node.LocationText->Text.ToString()));
+			hash = HashCombine(hash, GetTypeHash(node.LocationText->Color.ToFColor(true)));
+			hash = HashCombine(hash, GetTypeHash(node.Bounds.h));
+		}
+	}
+	return hash;
+}
+
+/* The bounds of objects without vertices come from the size of their image */
+FRect GetImageBounds(const FVector2D& ImageSize, float PixelsToUnits)
+{
+	FRect bounds = FRect();
+	bounds.w = ImageSize.Y / PixelsToUnits;
+	bounds.h = ImageSize.X / PixelsToUnits;
+	return bounds;
+}
+
+/* Computes where the actor of a node ends up, given the bounds of the node */
+FVector GetPlannedActorLocation(const FLocationGenerationPlan& Plan, int32 Index, FRect Bounds, float PixelsToUnits)
+{
+	const FVector2D& translation = Plan.Layout.Translations[Index];
+	const float sortPriority = Plan.Layout.SortPriorities[Index];
+
+	if (Plan.Nodes[Index].bHasZoneScript)
+	{
+		return FVector(translation.X / PixelsToUnits, sortPriority,
+			Bounds.GetYMax() + (Plan.OverallBounds.h - Bounds.h - (translation.Y / PixelsToUnits)));
+	}
+
+	return FVector(translation.X / PixelsToUnits, sortPriority,
+		Plan.OverallBounds.h - Bounds.h - (translation.Y / PixelsToUnits));
+}
+
+#if WITH_EDITOR
+
+/* The source size of a sprite is only known in the editor, so are the actors positioned by it */
+FRect GetSpriteBounds(const UPaperSprite* Sprite, float PixelsToUnits)
+{
+	return Sprite ? GetImageBounds(Sprite->GetSourceSize(), PixelsToUnits) : FRect();
+}
+
+/* Where the actor of a node ends up, objects without vertices are positioned by the size of their sprite */
+FVector GetNodeLocation(const FLocationGenerationPlan& Plan, int32 Index, const UPaperSprite* Sprite, float PixelsToUnits)
+{
+	if (!Plan.Layout.HasFlags(Index, ELocationLayoutFlags::HasTransform))
+		return FVector::ZeroVector;
+
+	const FLocationPlanNode& node = Plan.Nodes[Index];
+	if (Plan.Layout.HasFlags(Index, ELocationLayoutFlags::HasVertices))
+		return node.ActorLocation;
+
+	// a clipped sprite only shows a part of the image, but its pivot stays at the corner of the whole image
+	if (Sprite && node.SpriteOptions.Region.Width() > 0)
+		return GetPlannedActorLocation(Plan, Index, GetImageBounds(FVector2D(node.ImageSize), PixelsToUnits), PixelsToUnits);
+
+	return GetPlannedActorLocation(Plan, Index, GetSpriteBounds(Sprite, PixelsToUnits), PixelsToUnits);
+}
+
+#endif // WITH_EDITOR
+
+/* Finds the objects that are never hidden at runtime, neither by themselves nor by any of their parents */
+void GetStaticInHierarchy(const FLocationLayout& Layout, TArray<bool>& OutStaticInHierarchy)
+{
+	OutStaticInHierarchy.SetNumUninitialized(Layout.Num());
+
+	// parents always come before their children
+	for (int32 i = 0; i < Layout.Num(); ++i)
+	{
+		const int32 parent = Layout.ParentIndices[i];
+		OutStaticInHierarchy[i] = (parent == INDEX_NONE || OutStaticInHierarchy[parent])
+			&& Layout.HasFlags(i, ELocationLayoutFlags::Visible) && !Layout.HasFlags(i, ELocationLayoutFlags::DisplayCondition);
+	}
+}
+
+/* Marks the location images that don't need an actor, because nothing ever clicks, hides or swaps them */
+void MarkBatchedImages(FLocationGenerationPlan& Plan)
+{
+	const FLocationLayout& layout = Plan.Layout;
+
+	// if any parent can be hidden at runtime, its children have to stay separate actors as well
+	TArray<bool> staticInHierarchy;
+	GetStaticInHierarchy(layout, staticInHierarchy);
+
+	for (int32 i = 0; i < layout.Num(); ++i)
+	{
+		FLocationPlanNode& node = Plan.Nodes[i];
+		node.bBatched = staticInHierarchy[i] && node.LocationImage && !node.bHasZoneScript && node.Components.Num() == 0
+			&& !KeepsWholeTexture(layout, i);
+	}
+}
+
+/* Decides which objects get no sprite actor of their own, see FLocationGeneratorSettings::bLightweightObjects.
+*  Objects with components from the object-component map always keep their actor, the components need one.
+*/
+void MarkLightweightObjects(FLocationGenerationPlan& Plan)
+{
+	const FLocationLayout& layout = Plan.Layout;
+
+	// texts are hidden together with the actors of their parents, a text render component of another actor wouldn't be
+	TArray<bool> staticInHierarchy;
+	GetStaticInHierarchy(layout, staticInHierarchy);
+
+	for (int32 i = 0; i < layout.Num(); ++i)
+	{
+		FLocationPlanNode& node = Plan.Nodes[i];
+		if (node.LocationImage || node.bHasZoneScript || node.Components.Num() > 0)
+			continue;
+
+		if (node.bDataObject)
+			node.Representation = ELocationNodeRepresentation::Data;
+		else if (node.LocationText && staticInHierarchy[i])
+			node.Representation = ELocationNodeRepresentation::Text;
+	}
+}
+
+/* Pure data phase: precomputes bounds, collider polygons, transforms and signatures for all objects of the already built layout */
+void BuildGenerationPlan(float PixelsToUnits, const TMap<TSubclassOf<class UArticyBaseObject>, TSubclassOf<class UActorComponent>>& ObjectComponentMap, const FLocationGeneratorSettings& Settings, FLocationGenerationPlan& Plan)
+{
+	Plan.Nodes.SetNum(Plan.Layout.Num());
+	Plan.ColliderPoints.SetNumUninitialized(Plan.Layout.Vertices.Num());
+	Plan.ComponentTable.Build(Plan.Layout, ObjectComponentMap);
+
+	for (int32 i = 0; i < Plan.Nodes.Num(); ++i)
+		ResolvePlanNode(Plan, i, Settings);
+
+	ParallelFor(Plan.Nodes.Num(), [&Plan, PixelsToUnits, &Settings](int32 Index)
+	{
+		ExtractPlanNode(Plan, Index, PixelsToUnits, Settings);
+	});
+
+	// here we calculate the bounds of the 2D elements we are going to create,
+	// the only elements that could actually change the bounds are direct children with vertices(Zones, images etc)
+	for (int32 i = 0; i < Plan.Nodes.Num(); ++i)
+	{
+		if (Plan.Layout.ParentIndices[i] == INDEX_NONE && Plan.Layout.HasFlags(i, ELocationLayoutFlags::HasVertices))
+			Plan.OverallBounds = FRect::Union(Plan.OverallBounds, Plan.Nodes[i].OverallBoundsContribution);
+	}
+
+	ParallelFor(Plan.Nodes.Num(), [&Plan, PixelsToUnits](int32 Index)
+	{
+		FLocationPlanNode& node = Plan.Nodes[Index];
+		if (Plan.Layout.HasFlags(Index, ELocationLayoutFlags::HasTransform | ELocationLayoutFlags::HasVertices))
+			node.ActorLocation = GetPlannedActorLocation(Plan, Index, node.Bounds, PixelsToUnits);
+		node.Signature = GetGenerationSignature(Plan, Index, PixelsToUnits);
+	});
+
+	if (Settings.bBatchStaticImages)
+		MarkBatchedImages(Plan);
+
+	if (Settings.bLightweightObjects)
+		MarkLightweightObjects(Plan);
+}
+
+/* Logs how many collider vertices the simplification removed, per zone and for the whole location */
+void LogColliderReduction(const FLocationGenerationPlan& Plan, FName LocationName)
+{
+	int32 zoneCount = 0;
+	int32 verticesBefore = 0;
+	int32 verticesAfter = 0;
+	int32 shapeCount = 0;
+
+	for (int32 i = 0; i < Plan.Nodes.Num(); ++i)
+	{
+		const FLocationPlanNode& node = Plan.Nodes[i];
+		if (node.ColliderShapes.Num() == 0)
+			continue;
+
+		int32 zoneVertices = 0;
+		for (auto& shape : node.ColliderShapes)
+			zoneVertices += shape.Num();
+
+		UE_LOG(LogTemp, Verbose, TEXT("Collider of %s: %d vertices reduced to %d in %d convex shapes."), *node.Label.ToString(), Plan.Layout.VertexCounts[i], zoneVertices, node.ColliderShapes.Num());
+
+		++zoneCount;
+		verticesBefore += Plan.Layout.VertexCounts[i];
+		verticesAfter += zoneVertices;
+		shapeCount += node.ColliderShapes.Num();
+	}
+
+	if (zoneCount > 0)
+	{
+		UE_LOG(LogTemp, Log, TEXT("Colliders of %s: %d zones, %d vertices reduced to %d (%.0f%%) in %d shapes."),
+			*LocationName.ToString(), zoneCount, verticesBefore, verticesAfter, 100.0f * verticesAfter / FMath::Max(verticesBefore, 1), shapeCount);
+	}
+}
+
+/* The sprite options of a node together with the material that fits the alpha of its image, see FLocationGeneratorSettings::bClassifyImageAlpha */
+FLocationSpriteOptions GetNodeSpriteOptions(const FLocationGenerationPlan& Plan, int32 Index, UArticyAsset* ImageAsset, FLocationGenerationContext& Context)
+{
+	const FLocationPlanNode& node = Plan.Nodes[Index];
+	FLocationSpriteOptions options = node.SpriteOptions;
+	if (node.MaskedAlphaTolerance < 0 || !ImageAsset)
+		return options;
+
+	switch (Context.SpriteCache->ClassifyAlpha(ImageAsset, node.MaskedAlphaTolerance))
+	{
+	case ELocationImageAlpha::Opaque:
+		options.Material = Context.OpaqueMaterial;
+		break;
+	case ELocationImageAlpha::Masked:
+		options.Material = Context.MaskedMaterial;
+		break;
+	default:
+		break;
+	}
+
+	return options;
+}
+
+/* The shared sprite of a location image, as it is drawn in the location */
+UPaperSprite* GetNodeSprite(const FLocationGenerationPlan& Plan, int32 Index, FLocationGenerationContext& Context)
+{
+	UArticyAsset* imageAsset = Cast<UArticyAsset>(Context.Database->GetObject(Plan.Nodes[Index].LocationImage->ImageAsset));
+	return Context.SpriteCache->GetOrCreateSprite(imageAsset, GetNodeSpriteOptions(Plan, Index, imageAsset, Context));
+}
+
+/* Packs the images of the location into atlases, or lets them use their own textures again if packing is turned off */
+void UpdateSpriteAtlases(const FLocationGenerationPlan& Plan, FName LocationName, FLocationGenerationContext& Context)
+{
+	const FLocationGeneratorSettings& settings = Context.Settings;
+	if (!settings.bPackSpriteAtlas && !Context.SpriteCache->HasAtlases())
+		return;
+
+	TArray<UArticyAsset*> imageAssets;
+	TSet<UArticyAsset*> backgroundAssets;
+	for (int32 i = 0; i < Plan.Nodes.Num(); ++i)
+	{
+		const FLocationPlanNode& node = Plan.Nodes[i];
+		UArticyAsset* imageAsset = node.LocationImage ? Cast<UArticyAsset>(Context.Database->GetObject(node.LocationImage->ImageAsset)) : nullptr;
+		if (!imageAsset)
+			continue;
+
+		if (KeepsWholeTexture(Plan.Layout, i))
+			backgroundAssets.Add(imageAsset);
+		else
+			imageAssets.Add(imageAsset);
+	}
+
+	imageAssets.RemoveAll([&backgroundAssets](UArticyAsset* Asset) { return backgroundAssets.Contains(Asset); });
+
+	// a cancelled generation puts the images back into the atlases they were in
+	TArray<UArticyAsset*> changedAssets = imageAssets;
+	changedAssets.Append(backgroundAssets.Array());
+	Context.SpriteCache->SaveAtlases(changedAssets, Context.AtlasSnapshot);
+
+	Context.SpriteCache->ReleaseFromAtlases(backgroundAssets.Array());
+
+	if (!settings.bPackSpriteAtlas)
+	{
+		Context.SpriteCache->ReleaseFromAtlases(imageAssets);
+		return;
+	}
+
+	FLocationAtlasReport report;
+	Context.SpriteCache->PackAtlases(imageAssets, settings.MaxAtlasSize, settings.AtlasPadding, report);
+
+	for (int32 atlas = 0; atlas < report.AtlasSizes.Num(); ++atlas)
+		UE_LOG(LogTemp, Verbose, TEXT("Atlas %d of %s: %dx%d."), atlas, *LocationName.ToString(), report.AtlasSizes[atlas].X, report.AtlasSizes[atlas].Y);
+
+	UE_LOG(LogTemp, Log, TEXT("Atlases of %s%s: %d images packed into %d atlases (%.1f MPixels, %.0f%% occupied), %d images keep their own texture."),
+		*LocationName.ToString(), report.bReusedAtlases ? TEXT(" (unchanged)") : TEXT(""), report.PackedImages, report.AtlasSizes.Num(),
+		report.GetAtlasPixels() / 1000000.0f, 100.0f * report.GetOccupancy(), report.UnpackedImages);
+}
+
+#if WITH_EDITOR
+
+/* Writes the generated location as binary layout, next to the map it doesn't need any UObjects to be read */
+void WriteBinaryLayout(const FLocationGenerationPlan& Plan, FName LocationName, FLocationGenerationContext& Context)
+{
+	const FLocationLayout& layout = Plan.Layout;
+	TArray<FLocationBinaryObjectInput> objects;
+	objects.SetNum(Plan.Nodes.Num());
+	uint32 signature = 0;
+
+	for (int32 i = 0; i < Plan.Nodes.Num(); ++i)
+	{
+		const FLocationPlanNode& node = Plan.Nodes[i];
+		FLocationBinaryObjectInput& object = objects[i];
+		object.Label = node.Label;
+		object.bBatched = node.bBatched;
+		object.bZone = node.bHasZoneScript && layout.HasFlags(i, ELocationLayoutFlags::HasVertices);
+
+		if (object.bZone)
+		{
+			if (node.ColliderShapes.Num() > 0)
+				object.ColliderShapes = node.ColliderShapes;
+			else
+				object.ColliderShapes.Add(TArray<FVector2D>(Plan.GetColliderPoints(i)));
+		}
+
+		// images without vertices are positioned by their sprite, which the cache already holds at this point
+		const UPaperSprite* sprite = nullptr;
+		if (node.LocationImage && !layout.HasFlags(i, ELocationLayoutFlags::HasVertices))
+			sprite = GetNodeSprite(Plan, i, Context);
+		object.Location = GetNodeLocation(Plan, i, sprite, Context.PixelsToUnits);
+
+		// the node signatures leave out everything an actor can be updated with in place, but the layout stores the positions as well
+		signature = HashCombine(signature, HashCombine(node.Signature, GetTypeHash(object.Location)));
+	}
+
+	const FRect& bounds = Plan.OverallBounds;
+	TArray<uint8> data;
+	FLocationBinaryLayoutWriter::Write(layout, objects, LocationName, Context.PixelsToUnits, FVector4f(bounds.x, bounds.y, bounds.w, bounds.h), signature, data);
+
+	const FString filename = FLocationBinaryLayoutWriter::GetDefaultFilename(LocationName);
+	if (FLocationBinaryLayoutWriter::WriteToFile(filename, data))
+		UE_LOG(LogTemp, Log, TEXT("Wrote binary layout of %s: %d objects, %d bytes (%s)."), *LocationName.ToString(), objects.Num(), data.Num(), *filename);
+	else
+		UE_LOG(LogTemp, Warning, TEXT("Could not write the binary layout of %s to %s."), *LocationName.ToString(), *filename);
+}
+
+#endif // WITH_EDITOR
+
+uint32 GetActorSignature(const AActor* Actor)
+{
+	for (const FName& tag : Actor->Tags)
+	{
+		FString tagString = tag.ToString();
+		if (tagString.StartsWith(SignatureTagPrefix))
+			return FParse::HexNumber(*tagString.RightChop(SignatureTagPrefix.Len()));
+	}
+
+	return 0;
+}
+
+void SetActorSignature(AActor* Actor, uint32 Signature)
+{
+	Actor->Tags.RemoveAll([](const FName& Tag) { return Tag.ToString().StartsWith(SignatureTagPrefix); });
+	Actor->Tags.Add(FName(*FString::Printf(TEXT("%s%08X"), *SignatureTagPrefix, Signature)));
+}
+
+/* Destroys a generated actor together with the sprite that was created for it. Shared sprites from the sprite cache are kept. */
+void DestroyGeneratedActor(AActor* Actor)
+{
+	if (auto paperSpriteActor = Cast<APaperSpriteActor>(Actor))
+	{
+		auto sprite = paperSpriteActor->GetRenderComponent()->GetSprite();
+		if (sprite && sprite->GetOuter() == Actor)
+		{
+			sprite->ConditionalBeginDestroy();
+			sprite = NULL;
+		}
+	}
+	Actor->Destroy();
+}
+
+/* A zone gets the sprite carrying its collider instead of its image */
+bool ShowsImageSprite(const FLocationGenerationPlan& Plan, int32 Index)
+{
+	const FLocationPlanNode& node = Plan.Nodes[Index];
+	return node.LocationImage && !(node.bHasZoneScript && Plan.Layout.HasFlags(Index, ELocationLayoutFlags::HasVertices));
+}
+
+/* The sort priority the render component of a node's actor gets. Images only keep theirs if their sprite is drawn translucent. */
+bool GetActorSortPriority(const FLocationGenerationPlan& Plan, int32 Index, const UPaperSprite* Sprite, int32& OutSortPriority)
+{
+	if (ShowsImageSprite(Plan, Index) && !ULocationSpriteCache::NeedsSortPriority(Sprite))
+		return false;
+
+	OutSortPriority = Plan.Layout.SortPriorities[Index];
+	return true;
+}
+
+#if WITH_EDITOR
+
+/* Gives an actor we keep when reconciling the label, position and sort priority of its node, only touching what actually changed.
+*  Returns true if anything changed, the previous state is remembered so a cancelled generation can restore it.
+*/
+bool UpdateKeptActor(APaperSpriteActor* Actor, const FLocationGenerationPlan& Plan, int32 Index, FLocationGenerationContext& Context)
+{
+	UPaperSpriteComponent* renderComponent = Actor->GetRenderComponent();
+	const FString label = Plan.Nodes[Index].Label.ToString();
+
+	const bool bLabelChanged = Actor->GetActorLabel() != label;
+
+	const bool bHasTransform = Plan.Layout.HasFlags(Index, ELocationLayoutFlags::HasTransform);
+	const FVector location = bHasTransform ? GetNodeLocation(Plan, Index, renderComponent->GetSprite(), Context.PixelsToUnits) : Actor->GetActorLocation();
+	const bool bLocationChanged = !location.Equals(Actor->GetActorLocation());
+
+	int32 sortPriority = renderComponent->TranslucencySortPriority;
+	const bool bSortPriorityChanged = GetActorSortPriority(Plan, Index, renderComponent->GetSprite(), sortPriority) && sortPriority != renderComponent->TranslucencySortPriority;
+
+	if (!bLabelChanged && !bLocationChanged && !bSortPriorityChanged)
+		return false;
+
+	Context.PreviousStates.Add({ Actor, Actor->GetActorLabel(), Actor->GetActorLocation(), renderComponent->TranslucencySortPriority });
+	Actor->Modify();
+
+	if (bLabelChanged)
+		Actor->SetActorLabel(label);
+
+	if (bLocationChanged)
+		Actor->SetActorLocation(location, false);
+
+	if (bSortPriorityChanged)
+	{
+		renderComponent->Modify();
+		renderComponent->SetTranslucentSortPriority(sortPriority);
+	}
+
+	return true;
+}
+
+#endif // WITH_EDITOR
+
+/* Starts streaming the textures of all images we are going to create a sprite for, actors we keep when reconciling already have theirs */
+void RequestImageTextures(const FLocationGenerationPlan& Plan, FName LocationName, FLocationGenerationContext& Context)
+{
+	TArray<UArticyAsset*> imageAssets;
+	for (int32 i = 0; i < Plan.Nodes.Num(); ++i)
+	{
+		if (!ShowsImageSprite(Plan, i))
+			continue;
+
+		APaperSpriteActor* existingActor = Context.ExistingActors.FindRef(Plan.Layout.Ids[i]).Get();
+		if (existingActor && GetActorSignature(existingActor) == Plan.Nodes[i].Signature)
+			continue;
+
+		if (Plan.Nodes[i].bBatched && Context.bKeptBatchActor)
+			continue;
+
+		if (UArticyAsset* imageAsset = Cast<UArticyAsset>(Context.Database->GetObject(Plan.Nodes[i].LocationImage->ImageAsset)))
+			imageAssets.AddUnique(imageAsset);
+	}
+
+	Context.StreamedTextureCount = Context.SpriteCache->RequestTextures(imageAssets);
+	UE_LOG(LogTemp, Verbose, TEXT("Streaming %d of %d textures of %s."), Context.StreamedTextureCount, imageAssets.Num(), *LocationName.ToString());
+}
+
+/* Finds the image assets that location images of other locations show as well, their textures have to fit those locations too */
+static TSet<FArticyId> FindSharedImageAssets(const TSet<FArticyId>& ImageAssets, FName LocationName, UArticyDatabase& Database)
+{
+	TSet<FArticyId> sharedAssets;
+	for (auto object : Database.GetObjectsOfClass(UManiacManfredLocationImage::StaticClass()))
+	{
+		auto locationImage = Cast<UManiacManfredLocationImage>(object);
+		if (!locationImage || !ImageAssets.Contains(locationImage->ImageAsset) || sharedAssets.Contains(locationImage->ImageAsset))
+			continue;
+
+		const UArticyObject* location = locationImage->GetParent();
+		while (location && !location->IsA<UManiacManfredLocation>())
+			location = location->GetParent();
+
+		if (location && location->GetTechnicalName() != LocationName)
+			sharedAssets.Add(locationImage->ImageAsset);
+	}
+	return sharedAssets;
+}
+
+/* Sizes the textures of the location images to the biggest size they are drawn with, see FLocationTextureBudget */
+void OptimizeTextureBudget(const FLocationGenerationPlan& Plan, FName LocationName, FLocationGenerationContext& Context)
+{
+	const FLocationGeneratorSettings& settings = Context.Settings;
+	const FLocationLayout& layout = Plan.Layout;
+
+	// the camera shows the whole location, so the screen pixels per articy unit follow from the resolution and the location size
+	const FVector2D locationSize(Plan.OverallBounds.w * Context.PixelsToUnits, Plan.OverallBounds.h * Context.PixelsToUnits);
+	if (locationSize.X <= 0 || locationSize.Y <= 0 || settings.TargetResolutions.Num() == 0)
+		return;
+
+	double maxScale = 0;
+	double minScale = TNumericLimits<double>::Max();
+	for (const FIntPoint& resolution : settings.TargetResolutions)
+	{
+		const double scale = FMath::Min(resolution.X / locationSize.X, resolution.Y / locationSize.Y);
+		maxScale = FMath::Max(maxScale, scale * FMath::Max(settings.MaxCameraZoom, 1.0f));
+		minScale = FMath::Min(minScale, scale);
+	}
+
+	// only this location is generated, so textures other locations show too keep their settings
+	TSet<FArticyId> imageAssets;
+	for (int32 i = 0; i < Plan.Nodes.Num(); ++i)
+	{
+		if (ShowsImageSprite(Plan, i))
+			imageAssets.Add(Plan.Nodes[i].LocationImage->ImageAsset);
+	}
+	const TSet<FArticyId> sharedAssets = FindSharedImageAssets(imageAssets, LocationName, *Context.Database);
+
+	// several images may show the same texture, the texture has to be good enough for all of them
+	FLocationTextureBudgetReport report;
+	TArray<UTexture2D*> textures;
+	TMap<UTexture2D*, int32> entryIndices;
+
+	for (int32 i = 0; i < Plan.Nodes.Num(); ++i)
+	{
+		if (!ShowsImageSprite(Plan, i))
+			continue;
+
+		const FLocationPlanNode& node = Plan.Nodes[i];
+		UArticyAsset* imageAsset = Cast<UArticyAsset>(Context.Database->GetObject(node.LocationImage->ImageAsset));
+		if (!imageAsset)
+			continue;
+
+		if (Context.SpriteCache->IsPacked(imageAsset))
+		{
+			++report.PackedImages;
+			continue;
+		}
+
+		UTexture2D* texture = Context.SpriteCache->GetOrLoadTexture(imageAsset);
+		if (!texture)
+			continue;
+
+		// images with vertices are stretched onto them, the others are drawn with the size of their image
+		FVector2D displaySize;
+		if (layout.HasFlags(i, ELocationLayoutFlags::HasVertices))
+			displaySize = layout.VertexBounds[i].GetSize();
+		else if (node.LocationImage->CachedImageWidth > 0 && node.LocationImage->CachedImageHeight > 0)
+			displaySize = FVector2D(node.LocationImage->CachedImageWidth, node.LocationImage->CachedImageHeight) * layout.Scales[i].GetAbs();
+		else
+			displaySize = FVector2D(texture->GetImportedSize()) * layout.Scales[i].GetAbs();
+
+		int32& entryIndex = entryIndices.FindOrAdd(texture, INDEX_NONE);
+		if (entryIndex == INDEX_NONE)
+		{
+			entryIndex = report.Entries.Num();
+			textures.Add(texture);
+
+			FLocationTextureBudgetEntry& entry = report.Entries.AddDefaulted_GetRef();
+			entry.Texture = texture->GetPathName();
+			entry.SourceSize = texture->GetImportedSize();
+			entry.MinScreenSize = FVector2D(TNumericLimits<double>::Max());
+		}
+
+		FLocationTextureBudgetEntry& entry = report.Entries[entryIndex];
+		entry.bShared |= sharedAssets.Contains(node.LocationImage->ImageAsset);
+		entry.MaxScreenSize = FVector2D::Max(entry.MaxScreenSize, displaySize * maxScale);
+		entry.MinScreenSize = FVector2D::Min(entry.MinScreenSize, displaySize * minScale);
+	}
+
+	for (int32 i = 0; i < report.Entries.Num(); ++i)
+	{
+		FLocationTextureBudgetEntry& entry = report.Entries[i];
+		entry.BytesBefore = FLocationTextureBudget::EstimateMemory(textures[i]);
+		entry.Decision = FLocationTextureBudget::Decide(entry.SourceSize, entry.MaxScreenSize, entry.MinScreenSize, FLocationTextureBudget::HasAlpha(textures[i]));
+		entry.bChanged = !entry.bShared && FLocationTextureBudget::Apply(textures[i], entry.Decision);
+		entry.BytesAfter = FLocationTextureBudget::EstimateMemory(textures[i]);
+
+		UE_LOG(LogTemp, Verbose, TEXT("Texture %s of %s: %dx%d, drawn up to %.0fx%.0f, max size %d, %s, %s%s: %.2f MB -> %.2f MB."),
+			*entry.Texture, *LocationName.ToString(), entry.SourceSize.X, entry.SourceSize.Y, entry.MaxScreenSize.X, entry.MaxScreenSize.Y, entry.Decision.MaxTextureSize,
+			entry.Decision.bHasAlpha ? TEXT("alpha") : TEXT("opaque"), entry.Decision.bGenerateMips ? TEXT("mips") : TEXT("no mips"),
+			entry.bShared ? TEXT(", shared with other locations, left alone") : TEXT(""), entry.BytesBefore / (1024.0 * 1024.0), entry.BytesAfter / (1024.0 * 1024.0));
+	}
+
+	UE_LOG(LogTemp, Log, TEXT("Texture budget of %s: %d textures, %.2f MB before, %.2f MB after, %d textures changed, %d shared with other locations and %d images drawn from atlases left alone."),
+		*LocationName.ToString(), report.Entries.Num(), report.GetBytesBefore() / (1024.0 * 1024.0), report.GetBytesAfter() / (1024.0 * 1024.0),
+		report.GetChangedTextures(), report.GetSharedTextures(), report.PackedImages);
+
+	if (settings.TextureBudgetReport)
+	{
+		settings.TextureBudgetReport->Entries.Append(report.Entries);
+		settings.TextureBudgetReport->PackedImages += report.PackedImages;
+	}
+}
+
+#if WITH_EDITOR
+
+/* Logs how many texture pixels the sprites of the location images cover, compared to drawing every image as its whole rectangle */
+void LogSpriteCoverage(const FLocationGenerationPlan& Plan, FName LocationName, FLocationGenerationContext& Context)
+{
+	double wholeArea = 0;
+	double renderedArea = 0;
+	int32 clippedImages = 0;
+	TMap<UPaperSprite*, double> spriteAreas;
+
+	for (int32 i = 0; i < Plan.Nodes.Num(); ++i)
+	{
+		if (!ShowsImageSprite(Plan, i))
+			continue;
+
+		const FLocationPlanNode& node = Plan.Nodes[i];
+		UPaperSprite* sprite = GetNodeSprite(Plan, i, Context);
+		if (!sprite)
+			continue;
+
+		const bool bClipped = node.SpriteOptions.Region.Width() > 0;
+		const FVector2D wholeSize = bClipped ? FVector2D(node.ImageSize) : sprite->GetSourceSize();
+		wholeArea += wholeSize.X * wholeSize.Y;
+
+		// images are drawn as often as they appear, but every sprite only has to be triangulated once
+		double* area = spriteAreas.Find(sprite);
+		if (!area)
+			area = &spriteAreas.Add(sprite, ULocationSpriteCache::GetRenderedArea(sprite));
+
+		renderedArea += *area;
+		clippedImages += bClipped ? 1 : 0;
+	}
+
+	if (wholeArea <= 0)
+		return;
+
+	UE_LOG(LogTemp, Log, TEXT("Sprite coverage of %s: %.2f MPixels drawn instead of %.2f MPixels, %.0f%% saved (%d clipped images, tight geometry %s)."),
+		*LocationName.ToString(), renderedArea / 1000000.0, wholeArea / 1000000.0, 100.0 * (1.0 - renderedArea / wholeArea), clippedImages,
+		Context.Settings.bTightSpriteGeometry ? TEXT("on") : TEXT("off"));
+}
+
+#endif // WITH_EDITOR
+
+/* Logs how many location images are drawn opaque, masked or translucent, see FLocationGeneratorSettings::bClassifyImageAlpha */
+void LogImageAlpha(const FLocationGenerationPlan& Plan, FName LocationName, FLocationGenerationContext& Context)
+{
+	int32 opaqueImages = 0;
+	int32 maskedImages = 0;
+	int32 translucentImages = 0;
+
+	for (int32 i = 0; i < Plan.Nodes.Num(); ++i)
+	{
+		const FLocationPlanNode& node = Plan.Nodes[i];
+		if (!ShowsImageSprite(Plan, i) || node.MaskedAlphaTolerance < 0)
+			continue;
+
+		UArticyAsset* imageAsset = Cast<UArticyAsset>(Context.Database->GetObject(node.LocationImage->ImageAsset));
+		if (!imageAsset)
+			continue;
+
+		switch (Context.SpriteCache->ClassifyAlpha(imageAsset, node.MaskedAlphaTolerance))
+		{
+		case ELocationImageAlpha::Opaque: ++opaqueImages; break;
+		case ELocationImageAlpha::Masked: ++maskedImages; break;
+		default: ++translucentImages; break;
+		}
+	}
+
+	UE_LOG(LogTemp, Log, TEXT("Image alpha of %s: %d opaque, %d masked and %d translucent images, only the translucent ones keep their sort priority."),
+		*LocationName.ToString(), opaqueImages, maskedImages, translucentImages);
+}
+
+#if WITH_EDITOR
+
+/* Estimates how many pixels the location images shade per frame and writes the overdraw as heat map, see FLocationOverdraw */
+void AnalyzeOverdraw(const FLocationGenerationPlan& Plan, FName LocationName, FLocationGenerationContext& Context)
+{
+	const FLocationLayout& layout = Plan.Layout;
+	TArray<FLocationOverdrawLayer> layers;
+	FBox2D viewRect(ForceInit);
+
+	for (int32 i = 0; i < Plan.Nodes.Num(); ++i)
+	{
+		// the camera shows the same area the overall bounds span
+		if (layout.ParentIndices[i] == INDEX_NONE && layout.HasFlags(i, ELocationLayoutFlags::HasVertices))
+			viewRect += layout.VertexBounds[i];
+
+		if (!ShowsImageSprite(Plan, i))
+			continue;
+
+		const FLocationPlanNode& node = Plan.Nodes[i];
+		UPaperSprite* sprite = GetNodeSprite(Plan, i, Context);
+		if (!sprite)
+			continue;
+
+		// the same size the texture budget assumes: stretched onto the vertices, otherwise the image scaled by its transform
+		FVector2D imageSize = node.ImageSize.X > 0 && node.ImageSize.Y > 0 ? FVector2D(node.ImageSize) : sprite->GetSourceSize();
+		FBox2D rect;
+		if (layout.HasFlags(i, ELocationLayoutFlags::HasVertices))
+			rect = layout.VertexBounds[i];
+		else
+			rect = FBox2D(layout.Translations[i], layout.Translations[i] + imageSize * layout.Scales[i].GetAbs());
+
+		// a clipped sprite only draws its region of the image
+		const FIntRect& region = node.SpriteOptions.Region;
+		if (region.Width() > 0 && region.Height() > 0 && imageSize.X > 0 && imageSize.Y > 0)
+		{
+			const FVector2D pixelSize = rect.GetSize() / imageSize;
+			rect = FBox2D(rect.Min + FVector2D(region.Min) * pixelSize, rect.Min + FVector2D(region.Max) * pixelSize);
+		}
+
+		FLocationOverdrawLayer& layer = layers.AddDefaulted_GetRef();
+		layer.Label = node.Label;
+		layer.Rect = rect;
+		layer.Order = layout.SortPriorities[i];
+
+		const FVector2D spriteSize = sprite->GetSourceSize();
+		const double renderedArea = ULocationSpriteCache::GetRenderedArea(sprite);
+		if (renderedArea > 0 && spriteSize.X > 0 && spriteSize.Y > 0)
+			layer.Coverage = FMath::Clamp(renderedArea / (spriteSize.X * spriteSize.Y), 0.0, 1.0);
+
+		// a faded image blends with what lies behind it, even if its texture and material are opaque
+		const UMaterialInterface* material = sprite->GetDefaultMaterial();
+		layer.bOccludes = material && material->GetBlendMode() == BLEND_Opaque && node.LocationImage->ImageOpacity >= 1.0f && layer.Coverage >= 0.999f;
+
+		for (int32 parent = i; parent != INDEX_NONE && !layer.bConditional; parent = layout.ParentIndices[parent])
+			layer.bConditional = !layout.HasFlags(parent, ELocationLayoutFlags::Visible) || layout.HasFlags(parent, ELocationLayoutFlags::DisplayCondition);
+	}
+
+	for (const FLocationOverdrawLayer& layer : layers)
+		viewRect += layer.Rect;
+
+	FLocationOverdrawResult result;
+	FLocationOverdraw::Analyze(layers, viewRect, Context.Settings.OverdrawResolution, result);
+
+	const FString filename = FLocationOverdraw::GetDefaultHeatMapFilename(LocationName);
+	const bool bExported = FLocationOverdraw::ExportHeatMap(result, 8.0f, filename);
+
+	// the most expensive layers first, there are none if the location has no size
+	TArray<int32> layerOrder;
+	for (int32 i = 0; i < result.LayerShadedPixels.Num(); ++i)
+		layerOrder.Add(i);
+	layerOrder.Sort([&result](int32 A, int32 B) { return result.LayerShadedPixels[A] > result.LayerShadedPixels[B]; });
+
+	for (int32 i : layerOrder)
+	{
+		UE_LOG(LogTemp, Verbose, TEXT("Layer %s of %s: %.2f MPixels shaded%s%s."), *layers[i].Label.ToString(), *LocationName.ToString(), result.LayerShadedPixels[i] / 1000000.0,
+			layers[i].bOccludes ? TEXT(", occludes") : TEXT(""), layers[i].bConditional ? TEXT(", conditional") : TEXT(""));
+	}
+
+	UE_LOG(LogTemp, Log, TEXT("Overdraw of %s at %dx%d: %.2f MPixels shaded per frame (%.2fx), %.2f MPixels (%.2fx) with all conditional layers shown, up to %.1f layers on a pixel, heat map %s."),
+		*LocationName.ToString(), result.Resolution.X, result.Resolution.Y, result.ShadedPixels / 1000000.0, result.GetAverageOverdraw(false),
+		result.WorstCaseShadedPixels / 1000000.0, result.GetAverageOverdraw(true), result.MaxOverdraw, bExported ? *filename : TEXT("not written"));
+
+	if (Context.Settings.OverdrawResult)
+		*Context.Settings.OverdrawResult = MoveTemp(result);
+}
+
+#endif // WITH_EDITOR
+
+/* Starts the creation process, triggered a Blueprint Node.
+*  Deletes previously generated objects, calculates the bounds of the level and starts the object creation of the level.
+*/
+void ULocationGenerator::GenerateLocation(UManiacManfredLocation* Location, float PixelsToUnits, const TMap<TSubclassOf<class UArticyBaseObject>, TSubclassOf<class UActorComponent>>& ObjectComponentMap, AActor* WorldContext, /*OUT*/ UManiacManfredLocationImage*& BackgroundLayer)
+{
+	GenerateLocationWithSettings(Location, PixelsToUnits, ObjectComponentMap, FLocationGeneratorSettings(), WorldContext, BackgroundLayer);
+}
+
+void ULocationGenerator::GenerateLocationWithSettings(UManiacManfredLocation* Location, float PixelsToUnits, const TMap<TSubclassOf<class UArticyBaseObject>, TSubclassOf<class UActorComponent>>& ObjectComponentMap, const FLocationGeneratorSettings& Settings, AActor* WorldContext, /*OUT*/ UManiacManfredLocationImage*& BackgroundLayer)
+{
+#if WITH_EDITOR
+
+	FLocationGenerationContext context(ObjectComponentMap, BackgroundLayer, Settings, PixelsToUnits, WorldContext);
+
+	// first we flatten the articy location, everything afterwards only works on this layout
+	FLocationGenerationPlan plan;
+	{
+		LOCATION_GENERATOR_PHASE_SCOPE(Settings.Stats, Layout);
+		plan.Layout.Build(Location);
+	}
+
+	GeneratePlannedLocation(plan, Location->GetTechnicalName(), context);
+
+#endif // WITH_EDITOR
+}
+
+void ULocationGenerator::GenerateLocationFromLayout(FLocationLayout&& Layout, FName LocationName, float PixelsToUnits, const TMap<TSubclassOf<class UArticyBaseObject>, TSubclassOf<class UActorComponent>>& ObjectComponentMap, const FLocationGeneratorSettings& Settings, AActor* WorldContext, /*OUT*/ UManiacManfredLocationImage*& BackgroundLayer)
+{
+#if WITH_EDITOR
+
+	FLocationGenerationContext context(ObjectComponentMap, BackgroundLayer, Settings, PixelsToUnits, WorldContext);
+
+	FLocationGenerationPlan plan;
+	plan.Layout = MoveTemp(Layout);
+
+	GeneratePlannedLocation(plan, LocationName, context);
+
+#endif // WITH_EDITOR
+}
+
+void ULocationGenerator::BakeLocation(UManiacManfredLocation* Location, float PixelsToUnits, const TMap<TSubclassOf<class UArticyBaseObject>, TSubclassOf<class UActorComponent>>& ObjectComponentMap, const FLocationGeneratorSettings& Settings, ULocationCookedLayout* CookedLayout)
+{
+#if WITH_EDITOR
+
+	if (!Location || !CookedLayout)
+		return;
+
+	UManiacManfredLocationImage* backgroundLayer = nullptr;
+	FLocationGenerationContext context(ObjectComponentMap, backgroundLayer, Settings, PixelsToUnits, nullptr);
+	if (!context.SpriteCache)
+	{
+		if (!CookedLayout->SpriteCache)
+			CookedLayout->SpriteCache = ULocationSpriteCache::GetOrCreateInside(CookedLayout);
+
+		context.SpriteCache = CookedLayout->SpriteCache;
+	}
+
+	FLocationGeneratorStats* stats = Settings.Stats;
+	const FName locationName = Location->GetTechnicalName();
+
+	// the same data phase as for generating, only the results end up in the asset instead of the level
+	FLocationGenerationPlan plan;
+	{
+		LOCATION_GENERATOR_PHASE_SCOPE(stats, Layout);
+		plan.Layout.Build(Location);
+	}
+	{
+		LOCATION_GENERATOR_PHASE_SCOPE(stats, Bounds);
+		BuildGenerationPlan(PixelsToUnits, ObjectComponentMap, Settings, plan);
+	}
+	{
+		LOCATION_GENERATOR_PHASE_SCOPE(stats, Sprite);
+
+		// baking has no actors to build in the meantime, but the textures still load in parallel and every sprite only waits for its own
+		if (Settings.bStreamTexturesAsync)
+			RequestImageTextures(plan, locationName, context);
+
+		UpdateSpriteAtlases(plan, locationName, context);
+
+		if (Settings.bOptimizeTextureBudget)
+			OptimizeTextureBudget(plan, locationName, context);
+	}
+
+	CookedLayout->Modify();
+
+	// the collider sprites of the previous bake aren't needed anymore
+	for (const FLocationCookedObject& object : CookedLayout->Objects)
+	{
+		if (object.Sprite && object.Sprite->GetOuter() == CookedLayout)
+			object.Sprite->Rename(nullptr, GetTransientPackage(), REN_DontCreateRedirectors);
+	}
+
+	const FLocationLayout& layout = plan.Layout;
+	CookedLayout->LocationName = locationName;
+	CookedLayout->PixelsToUnits = PixelsToUnits;
+	CookedLayout->Signature = 0;
+	CookedLayout->BackgroundLayer = INDEX_NONE;
+	CookedLayout->Objects.Reset(plan.Nodes.Num());
+
+	for (int32 i = 0; i < plan.Nodes.Num(); ++i)
+	{
+		const FLocationPlanNode& node = plan.Nodes[i];
+		FLocationCookedObject& object = CookedLayout->Objects.AddDefaulted_GetRef();
+		object.Id = layout.Ids[i];
+		object.Label = node.Label;
+		object.Parent = layout.ParentIndices[i];
+		object.SortPriority = layout.SortPriorities[i];
+		object.Components = node.Components;
+		object.bBatched = node.bBatched;
+		object.bImage = node.LocationImage != nullptr;
+		object.bBackgroundLayer = layout.HasFlags(i, ELocationLayoutFlags::BackgroundLayer);
+
+		if (object.bBackgroundLayer)
+			CookedLayout->BackgroundLayer = i;
+
+		// the same sprite and collider CreateChildActor would give the actor
+		if (node.LocationImage)
+		{
+			LOCATION_GENERATOR_PHASE_SCOPE(stats, Sprite);
+			object.Sprite = GetNodeSprite(plan, i, context);
+		}
+
+		if (layout.HasFlags(i, ELocationLayoutFlags::HasVertices))
+		{
+			if (node.bHasZoneScript)
+			{
+				LOCATION_GENERATOR_PHASE_SCOPE(stats, Collider);
+				object.Sprite = CreateColliderSprite(CookedLayout, plan, i);
+			}
+			else
+			{
+				object.bCollisionEnabled = false;
+			}
+		}
+
+		{
+			LOCATION_GENERATOR_PHASE_SCOPE(stats, Transform);
+			object.Location = GetNodeLocation(plan, i, object.Sprite, PixelsToUnits);
+		}
+
+		CookedLayout->Signature = HashCombine(CookedLayout->Signature, HashCombine(node.Signature, GetTypeHash(object.Location)));
+	}
+
+	context.SpriteCache->ReleaseTextureRequests();
+	CookedLayout->MarkPackageDirty();
+
+	if (Settings.bClassifyImageAlpha)
+		LogImageAlpha(plan, locationName, context);
+
+	UE_LOG(LogTemp, Log, TEXT("Baked location %s: %d objects."), *locationName.ToString(), CookedLayout->Objects.Num());
+
+#endif // WITH_EDITOR
+}
+
+FLocationGenerationJob::FLocationGenerationJob(UManiacManfredLocation* Location, float PixelsToUnits, const TMap<TSubclassOf<class UArticyBaseObject>, TSubclassOf<class UActorComponent>>& InObjectComponentMap, const FLocationGeneratorSettings& Settings, AActor* WorldContext)
+	: ObjectComponentMap(InObjectComponentMap)
+	, LocationName(Location->GetTechnicalName())
+	, Plan(MakeUnique<FLocationGenerationPlan>())
+{
+#if WITH_EDITOR
+
+	Context = MakeUnique<FLocationGenerationContext>(ObjectComponentMap, BackgroundLayer, Settings, PixelsToUnits, WorldContext);
+
+	// the layout is flattened right away, it must not see the articy objects change while the actors are spawned
+	LOCATION_GENERATOR_PHASE_SCOPE(Settings.Stats, Layout);
+	Plan->Layout.Build(Location);
+
+#endif // WITH_EDITOR
+}
+
+FLocationGenerationJob::~FLocationGenerationJob()
+{
+}
+
+bool FLocationGenerationJob::Tick(double Deadline, int32 MaxObjects)
+{
+#if WITH_EDITOR
+
+	if (bComplete || bCancelled)
+		return bComplete;
+
+	TRACE_CPUPROFILER_EVENT_SCOPE(FLocationGenerationJob::Tick);
+
+	if (!bStarted)
+	{
+		ULocationGenerator::BeginPlannedLocation(*Plan, LocationName, *Context);
+		bStarted = true;
+
+		// the data phase can take a whole tick on its own, the spawning starts with the next one then
+		if (FPlatformTime::Seconds() >= Deadline)
+			return false;
+	}
+
+	if (!ULocationGenerator::SpawnPlannedActors(*Plan, *Context, Deadline, MaxObjects))
+		return false;
+
+	// streamed textures keep arriving between the ticks, the location is complete once every image shows its sprite
+	if (Context->PendingSprites.Num() > 0)
+	{
+		LOCATION_GENERATOR_PHASE_SCOPE(Context->Settings.Stats, Sprite);
+		ULocationGenerator::FinishPendingSprites(*Plan, *Context, false);
+		if (Context->PendingSprites.Num() > 0)
+			return false;
+	}
+
+	ULocationGenerator::FinishPlannedLocation(*Plan, LocationName, *Context);
+	bComplete = true;
+
+#endif // WITH_EDITOR
+
+	return true;
+}
+
+void FLocationGenerationJob::Cancel()
+{
+#if WITH_EDITOR
+
+	if (bComplete || bCancelled)
+		return;
+
+	ULocationGenerator::RollbackPlannedLocation(*Context);
+	bCancelled = true;
+
+	UE_LOG(LogTemp, Log, TEXT("Cancelled generating location %s after %d of %d objects, the previous actors were kept."), *LocationName.ToString(), GetSpawnedObjects(), GetTotalObjects());
+
+#endif // WITH_EDITOR
+}
+
+void FLocationGenerationJob::AddReferencedObjects(FReferenceCollector& Collector)
+{
+	if (!Context)
+		return;
+
+	// the sprite cache may live inside the generating actor, which can be deleted while we are still spawning
+	Collector.AddReferencedObject(Context->SpriteCache);
+	Collector.AddReferencedObject(Context->OpaqueMaterial);
+	Collector.AddReferencedObject(Context->MaskedMaterial);
+}
+
+int32 FLocationGenerationJob::GetSpawnedObjects() const
+{
+	return Context ? Context->NextNode : 0;
+}
+
+int32 FLocationGenerationJob::GetTotalObjects() const
+{
+	return Plan->Layout.Num();
+}
+
+void ULocationGenerator::GeneratePlannedLocation(FLocationGenerationPlan& Plan, FName LocationName, FLocationGenerationContext& Context)
+{
+#if WITH_EDITOR
+
+	TRACE_CPUPROFILER_EVENT_SCOPE(ULocationGenerator::GeneratePlannedLocation);
+
+	BeginPlannedLocation(Plan, LocationName, Context);
+
+	// without a deadline all elements inside the location are created in one go
+	SpawnPlannedActors(Plan, Context, TNumericLimits<double>::Max(), MAX_int32);
+
+	FinishPlannedLocation(Plan, LocationName, Context);
+
+#endif // WITH_EDITOR
+}
+
+/* Everything before the actors are spawned: the data phase, collecting the previously generated actors and packing the atlases */
+void ULocationGenerator::BeginPlannedLocation(FLocationGenerationPlan& Plan, FName LocationName, FLocationGenerationContext& Context)
+{
+#if WITH_EDITOR
+
+	TRACE_CPUPROFILER_EVENT_SCOPE(ULocationGenerator::BeginPlannedLocation);
+	SCOPE_CYCLE_COUNTER(STAT_LocationGenerator_Generate);
+
+	FLocationGeneratorStats* stats = Context.Settings.Stats;
+	Context.StartTextureLoads = Context.SpriteCache->GetTextureLoads();
+	Context.StartSpritesCreated = Context.SpriteCache->GetSpritesCreated();
+
+	// the pure data phase, which doesn't touch the level at all
+	{
+		LOCATION_GENERATOR_PHASE_SCOPE(stats, Bounds);
+		BuildGenerationPlan(Context.PixelsToUnits, Context.ObjectComponentMap, Context.Settings, Plan);
+	}
+
+	if (Context.Settings.bSimplifyColliders || Context.Settings.bDecomposeColliders)
+		LogColliderReduction(Plan, LocationName);
+
+	{
+		LOCATION_GENERATOR_PHASE_SCOPE(stats, Clear);
+
+		// the current generated location stays until the new one is complete, so a cancelled generation leaves it as it was
+		TArray<AActor*> actorChildren;
+		GetAllChildrenRecursive(Context.WorldContext, &actorChildren);
+		Context.PreviousActors.Append(actorChildren);
+
+		Context.BatchSignature = GetBatchSignature(Plan);
+		Context.DataSignature = GetDataSignature(Plan, Context.Settings);
+
+		if (Context.Settings.bReconcileExistingActors)
+		{
+			// Remember the current generated location, so we can match it against the articy objects
+			for (auto child : actorChildren)
+			{
+				auto paperSpriteActor = Cast<APaperSpriteActor>(child);
+				auto articyReference = child->FindComponentByClass<UArticyReference>();
+				if (paperSpriteActor && articyReference && !Context.ExistingActors.Contains(articyReference->Reference.GetId()))
+					Context.ExistingActors.Add(articyReference->Reference.GetId(), paperSpriteActor);
+
+				// the batch has no articy object of its own, it matches if all of its images are batched like last time
+				auto batchActor = Cast<APaperGroupedSpriteActor>(child);
+				if (batchActor && !Context.bKeptBatchActor && GetActorSignature(batchActor) == Context.BatchSignature)
+				{
+					Context.BatchActor = batchActor;
+					Context.bKeptBatchActor = true;
+					Context.KeptActors.Add(batchActor);
+					++Context.KeptCount;
+				}
+
+				auto dataComponent = child->FindComponentByClass<ULocationDataComponent>();
+				if (dataComponent && !Context.bKeptDataActor && GetActorSignature(child) == Context.DataSignature)
+				{
+					Context.DataActor = child;
+					Context.bKeptDataActor = true;
+					Context.KeptActors.Add(child);
+					++Context.KeptCount;
+				}
+			}
+		}
+	}
+
+	// the textures load in the background while we build the atlases and spawn the actors, so we only wait for the slowest instead of all of them
+	if (Context.Settings.bStreamTexturesAsync)
+	{
+		LOCATION_GENERATOR_PHASE_SCOPE(stats, Sprite);
+		RequestImageTextures(Plan, LocationName, Context);
+	}
+
+	// location images share atlas textures, if wanted, which have to exist before their sprites are set up
+	{
+		LOCATION_GENERATOR_PHASE_SCOPE(stats, Sprite);
+		UpdateSpriteAtlases(Plan, LocationName, Context);
+	}
+
+#endif // WITH_EDITOR
+}
+
+/* Everything after all actors were spawned: the remaining sprites, the texture budget, the analysis passes and removing the previously generated actors */
+void ULocationGenerator::FinishPlannedLocation(FLocationGenerationPlan& Plan, FName LocationName, FLocationGenerationContext& Context)
+{
+#if WITH_EDITOR
+
+	TRACE_CPUPROFILER_EVENT_SCOPE(ULocationGenerator::FinishPlannedLocation);
+	SCOPE_CYCLE_COUNTER(STAT_LocationGenerator_Generate);
+
+	FLocationGeneratorStats* stats = Context.Settings.Stats;
+
+	if (Context.Settings.bStreamTexturesAsync)
 	{
-		auto child = children[i];
-		Children->Add(child);
-		GetAllChildrenRecursive(child, Children);
+		LOCATION_GENERATOR_PHASE_SCOPE(stats, Sprite);
+		FinishPendingSprites(Plan, Context, true);
+		Context.SpriteCache->ReleaseTextureRequests();
+
+		UE_LOG(LogTemp, Log, TEXT("Streamed %d textures of %s, %d sprites were set after their actors were spawned."), Context.StreamedTextureCount, *LocationName.ToString(), Context.DeferredSpriteCount);
+	}
+
+	{
+		LOCATION_GENERATOR_PHASE_SCOPE(stats, Sprite);
+		LogSpriteCoverage(Plan, LocationName, Context);
+
+		if (Context.Settings.bClassifyImageAlpha)
+			LogImageAlpha(Plan, LocationName, Context);
+	}
+
+	// the textures images are drawn from directly are sized to how big they appear on screen, only once the location is complete
+	if (Context.Settings.bOptimizeTextureBudget)
+	{
+		LOCATION_GENERATOR_PHASE_SCOPE(stats, Sprite);
+		OptimizeTextureBudget(Plan, LocationName, Context);
+	}
+
+	if (Context.Settings.bAnalyzeOverdraw)
+		AnalyzeOverdraw(Plan, LocationName, Context);
+
+	if (Context.BatchedImageCount > 0)
+		UE_LOG(LogTemp, Log, TEXT("Batched %d static images of %s into %d grouped sprite components."), Context.BatchedImageCount, *LocationName.ToString(), Context.BatchComponentCount);
+
+	if (Context.DataComponent)
+	{
+		Context.DataComponent->RebuildIndex();
+		UE_LOG(LogTemp, Log, TEXT("Stored %d spots, links and paths of %s as data entries and %d texts as text render components, without actors of their own."),
+			Context.DataComponent->Entries.Num(), *LocationName.ToString(), Context.TextComponentCount);
+	}
+
+	if (Context.Settings.bWriteBinaryLayout)
+		WriteBinaryLayout(Plan, LocationName, Context);
+
+	{
+		LOCATION_GENERATOR_PHASE_SCOPE(stats, Clear);
+
+		// when reconciling, everything we didn't match to an articy object anymore was deleted or replaced in articy
+		for (const TWeakObjectPtr<AActor>& child : Context.PreviousActors)
+		{
+			if (child.IsValid() && !Context.KeptActors.Contains(child.Get()))
+			{
+				DestroyGeneratedActor(child.Get());
+				++Context.DeletedCount;
+			}
+		}
 	}
+
+	if (Context.Settings.bReconcileExistingActors)
+		UE_LOG(LogTemp, Log, TEXT("Reconciled location %s: %d actors kept (%d of them updated in place), %d created, %d deleted."),
+			*LocationName.ToString(), Context.KeptCount, Context.UpdatedCount, Context.CreatedCount, Context.DeletedCount);
+
+	const int32 texturesLoaded = Context.SpriteCache->GetTextureLoads() - Context.StartTextureLoads;
+	const int32 spritesCreated = Context.SpriteCache->GetSpritesCreated() - Context.StartSpritesCreated;
+	INC_DWORD_STAT_BY(STAT_LocationGenerator_ActorsSpawned, Context.SpawnedActorCount);
+	INC_DWORD_STAT_BY(STAT_LocationGenerator_ComponentsAdded, Context.AddedComponentCount);
+	INC_DWORD_STAT_BY(STAT_LocationGenerator_VerticesProcessed, Plan.Layout.Vertices.Num());
+	INC_DWORD_STAT_BY(STAT_LocationGenerator_TexturesLoaded, texturesLoaded);
+	INC_DWORD_STAT_BY(STAT_LocationGenerator_SpritesCreated, spritesCreated);
+
+	UE_LOG(LogTemp, Log, TEXT("Generated location %s in %.1f ms: %d objects, %d actors spawned, %d components added, %d vertices processed, %d textures loaded, %d sprites created."),
+		*LocationName.ToString(), (FPlatformTime::Seconds() - Context.StartTime) * 1000.0, Plan.Nodes.Num(), Context.SpawnedActorCount, Context.AddedComponentCount,
+		Plan.Layout.Vertices.Num(), texturesLoaded, spritesCreated);
+
+#endif // WITH_EDITOR
 }
 
-/* Determines the name for an actor depending on the articy object it should represent */
-FName GetNameForActor(const UArticyObject* ArticyObject)
+/* Undoes a generation that didn't finish: destroys the actors it spawned and gives the kept actors back their previous parents, labels, positions and sort priorities.
+*  The images go back into the atlases they were in, the texture settings were never touched because the texture budget only runs for a finished location.
+*  The previously generated actors were never touched otherwise, the sprite cache keeps the textures and sprites it already loaded.
+*/
+void ULocationGenerator::RollbackPlannedLocation(FLocationGenerationContext& Context)
 {
-	// display name > technical name 
-	FName finalName = ArticyObject->GetTechnicalName();
-	auto displayName = Cast<IArticyObjectWithDisplayName>(ArticyObject);
-	if (displayName)
-		finalName = FName(*displayName->GetDisplayName().ToString());
+#if WITH_EDITOR
 
-	// if the object is an target (e.g. an object link in an articy location),
-	// we use the name of the target
-	auto target = Cast<IArticyObjectWithTarget>(ArticyObject);
-	if (target)
+	for (const TPair<TWeakObjectPtr<AActor>, TWeakObjectPtr<AActor>>& previousOwner : Context.PreviousOwners)
 	{
-		auto targetObj = Cast<UArticyObject>(target->GetTarget());
-		if (targetObj)
-			return GetNameForActor(targetObj);
+		if (AActor* actor = previousOwner.Key.Get())
+			actor->SetOwner(previousOwner.Value.Get());
 	}
 
-	return finalName;
+	for (const FKeptActorState& previousState : Context.PreviousStates)
+	{
+		if (APaperSpriteActor* actor = previousState.Actor.Get())
+		{
+			actor->SetActorLabel(previousState.Label);
+			actor->SetActorLocation(previousState.Location, false);
+			actor->GetRenderComponent()->SetTranslucentSortPriority(previousState.SortPriority);
+		}
+	}
+
+	// children before their parents, the same order in which they would have been cleared
+	for (int32 i = Context.CreatedActors.Num() - 1; i >= 0; --i)
+	{
+		if (AActor* actor = Context.CreatedActors[i].Get())
+			DestroyGeneratedActor(actor);
+	}
+
+	Context.CreatedActors.Reset();
+	Context.PreviousOwners.Reset();
+	Context.PreviousStates.Reset();
+	Context.PendingSprites.Reset();
+	Context.SpriteCache->ReleaseTextureRequests();
+	Context.SpriteCache->RestoreAtlases(Context.AtlasSnapshot);
+	Context.AtlasSnapshot = FLocationAtlasSnapshot();
+	Context.BackgroundLayer = nullptr;
+	Context.BatchActor = nullptr;
+	Context.bKeptBatchActor = false;
+	Context.DataActor = nullptr;
+	Context.DataComponent = nullptr;
+	Context.bKeptDataActor = false;
+
+#endif // WITH_EDITOR
 }
 
-/* Starts the creation process, triggered a Blueprint Node.
-*  Deletes previously generated objects, calculates the bounds of the level and starts the recursive object creation of the level.
+/* Spawn phase: creates (or keeps) the actors of the planned nodes in order, so parents always exist before their children.
+*  Continues with the node where the last call stopped and stops after MaxNodes or once the deadline passed, but always spawns at least one node.
+*  Returns true once every node was spawned.
 */
-void ULocationGenerator::GenerateLocation(UManiacManfredLocation* Location, float PixelsToUnits, const TMap<TSubclassOf<class UArticyBaseObject>, TSubclassOf<class UActorComponent>> ObjectComponentMap, AActor* WorldContext, /*OUT*/ UManiacManfredLocationImage*& BackgroundLayer)
+bool ULocationGenerator::SpawnPlannedActors(const FLocationGenerationPlan& Plan, FLocationGenerationContext& Context, double Deadline, int32 MaxNodes)
 {
 #if WITH_EDITOR
 
-	// Clear current generated location
-	TArray<AActor*> actorChildren;
-	GetAllChildrenRecursive(WorldContext, &actorChildren);
-	for (auto child : actorChildren)
+	SCOPE_CYCLE_COUNTER(STAT_LocationGenerator_Generate);
+
+	const FLocationLayout& layout = Plan.Layout;
+	Context.NodeActors.SetNum(Plan.Nodes.Num());
+	int32 spawnedNodes = 0;
+
+	while (Context.NextNode < Plan.Nodes.Num())
 	{
-		if (auto paperSpriteActor = Cast<APaperSpriteActor>(child))
+		if (spawnedNodes > 0 && (spawnedNodes >= MaxNodes || FPlatformTime::Seconds() >= Deadline))
+			return false;
+
+		const int32 i = Context.NextNode++;
+		++spawnedNodes;
+
+		const FLocationPlanNode& node = Plan.Nodes[i];
+
+		// the articy object was deleted after the layout was built, there is nothing left to represent
+		if (!node.Class)
+			continue;
+
+		if (node.bBatched)
+		{
+			AddBatchedImage(Plan, i, Context);
+			continue;
+		}
+
+		if (node.Representation != ELocationNodeRepresentation::Actor)
+		{
+			AddLightweightObject(Plan, i, Context);
+			continue;
+		}
+
+		// a separately drawn image between batched ones starts a new batch, otherwise it couldn't be drawn in between them
+		if (node.LocationImage)
+			Context.BatchComponent = nullptr;
+
+		// batched images have no actor, so their children belong to the closest parent that has one
+		AActor* parent = Context.WorldContext;
+		for (int32 parentIndex = layout.ParentIndices[i]; parentIndex != INDEX_NONE; parentIndex = layout.ParentIndices[parentIndex])
 		{
-			if (auto sprite = paperSpriteActor->GetRenderComponent()->GetSprite())
+			if (APaperSpriteActor* parentActor = Context.NodeActors[parentIndex].Get())
 			{
-				sprite->ConditionalBeginDestroy();
-				sprite = NULL;
+				parent = parentActor;
+				break;
 			}
 		}
-		child->Destroy();
-	}
 
-	// here we calculate the bounds of the 2D elements we are going to create
-	FRect overallBounds = FRect();
-	auto db = UArticyDatabase::Get(WorldContext);
-	TArray<TWeakObjectPtr<UArticyObject>> children = Location->GetChildren();
-	for (auto child : children)
-	{
-		// the only elements that could actually change the bounds are objects with vertices(Zones, images etc)
-		auto objWithVertices = Cast<IArticyObjectWithVertices>(child);
-		if (objWithVertices)
+		APaperSpriteActor* childActor = nullptr;
+
+		if (Context.Settings.bReconcileExistingActors)
 		{
-			TArray<FVector2D> vertices = objWithVertices->GetVertices();
-			FRect childBounds = FRect::GetBounds(&vertices);
-			TArray<FVector2D> correctedPoints;
+			// reuse the actor we generated last time, as long as nothing it was generated from has changed
+			APaperSpriteActor* existingActor = Context.ExistingActors.FindRef(layout.Ids[i]).Get();
+			if (existingActor && GetActorSignature(existingActor) == node.Signature)
+			{
+				childActor = existingActor;
+				++Context.KeptCount;
+				if (childActor->GetOwner() != parent)
+				{
+					Context.PreviousOwners.Add({ childActor, childActor->GetOwner() });
+					childActor->Modify();
+					childActor->SetOwner(parent);
+				}
+
+				// we still need to know the background layer, even if we don't touch its actor
+				if (layout.HasFlags(i, ELocationLayoutFlags::BackgroundLayer))
+					Context.BackgroundLayer = node.LocationImage;
 
-			// articy and unreal have a different y axis, so we have to take care of that and also incorporating the pixels to units conversion
-			for (int i = 0; i < vertices.Num(); ++i)
+				// moving or inserting other objects changes where this one is drawn, which doesn't need a new actor
+				if (UpdateKeptActor(childActor, Plan, i, Context))
+					++Context.UpdatedCount;
+			}
+			else
 			{
-				FVector2D vec = vertices[i];
-				FVector2D v(vec.X / PixelsToUnits, (childBounds.GetYMax() - vec.Y) / PixelsToUnits);
-				correctedPoints.Add(v);
+				childActor = CreateChildActor(parent, Plan, i, Context);
+				++Context.CreatedCount;
 			}
-			childBounds = FRect::GetBounds(&correctedPoints);
-			overallBounds = FRect::Union(overallBounds, childBounds);
+
+			Context.KeptActors.Add(childActor);
+		}
+		else
+		{
+			childActor = CreateChildActor(parent, Plan, i, Context);
 		}
-	}
 
-	// and now we can create all the elements inside the location
-	auto location = Cast<UArticyObject>(Location);
-	float zIndex = 0;
-	GenerateChildren(WorldContext, location, PixelsToUnits, ObjectComponentMap, overallBounds, &zIndex, WorldContext, BackgroundLayer);
+		Context.NodeActors[i] = childActor;
 
+		// give the streamed textures a chance to arrive and show the ones that did
+		if (Context.PendingSprites.Num() > 0)
+		{
+			LOCATION_GENERATOR_PHASE_SCOPE(Context.Settings.Stats, Sprite);
+			ProcessAsyncLoading(true, false, 0.001);
+			FinishPendingSprites(Plan, Context, false);
+		}
+	}
 
 #endif // WITH_EDITOR
+
+	return true;
 }
 
-/* This method is called for every articy object in the location, starting with the location itself*/
-void ULocationGenerator::GenerateChildren(AActor* Parent, UArticyObject* Child, float PixelsToUnits, const TMap<TSubclassOf<class UArticyBaseObject>, TSubclassOf<class UActorComponent>> ObjectComponentMap, FRect OverallBounds, float* YIndex, AActor* WorldContext, /*OUT*/ UManiacManfredLocationImage*& BackgroundLayer)
+/* Spawns and sets up the actor representing a single articy object of the location */
+APaperSpriteActor* ULocationGenerator::CreateChildActor(AActor* Parent, const FLocationGenerationPlan& Plan, int32 NodeIndex, FLocationGenerationContext& Context)
 {
 #if WITH_EDITOR
 
-	auto articyDatabase = UArticyDatabase::Get(WorldContext);
-	TArray<TWeakObjectPtr<UArticyObject>> children = Child->GetChildren();
-
-	// The children are usually unsorted, but in this case we have to worry about proper ordering regarding depth sorting
-	children.Sort([](const TWeakObjectPtr<UArticyObject>& ObjA, const TWeakObjectPtr<UArticyObject>& ObjB)
-	{
-		auto objWithZIndexA = Cast<IArticyObjectWithZIndex>(ObjA.Get());
-		auto objWithZIndexB = Cast<IArticyObjectWithZIndex>(ObjB.Get());
-		if (!objWithZIndexA || !objWithZIndexB)
-			return false;
-		return objWithZIndexA->GetZIndex() < objWithZIndexB->GetZIndex();
-	});
-
-	for (auto child : children)
-	{
-		APaperSpriteActor* createdChildActor;
-		UWorld* World = GEngine->GetWorldFromContextObject(WorldContext, EGetWorldErrorMode::Assert);
+	APaperSpriteActor* createdChildActor;
+	const float PixelsToUnits = Context.PixelsToUnits;
+	const FLocationLayout& layout = Plan.Layout;
+	const FLocationPlanNode& node = Plan.Nodes[NodeIndex];
+	const bool bIsBackgroundLayer = layout.HasFlags(NodeIndex, ELocationLayoutFlags::BackgroundLayer);
 
-		FRect bounds = FRect();
-		bool bBoundsSet = false;
-		bool bHasZoneScript = false;
+	FLocationGeneratorStats* stats = Context.Settings.Stats;
 
 #pragma region Create new Actor for our location child
 
+	{
+		LOCATION_GENERATOR_PHASE_SCOPE(stats, Spawn);
+
 		// to keep it simple we instantiate every actor as a paper sprite actor, because in most cases we need them anyway
 		FTransform transform(FQuat::Identity, FVector::OneVector, FVector::OneVector);
-		createdChildActor = World->SpawnActorDeferred<APaperSpriteActor>(APaperSpriteActor::StaticClass(), transform, Parent);
-		createdChildActor->SetActorLabel(GetNameForActor(child.Get()).ToString());
+		createdChildActor = Context.World->SpawnActorDeferred<APaperSpriteActor>(APaperSpriteActor::StaticClass(), transform, Parent);
+		createdChildActor->SetActorLabel(node.Label.ToString());
 		createdChildActor->SetFolderPath(TEXT("GeneratedObjects"));
 		createdChildActor->SetActorScale3D(FVector::OneVector);
 		createdChildActor->OnConstruction(createdChildActor->GetTransform());
 		createdChildActor->FinishSpawning(createdChildActor->GetTransform());
 		createdChildActor->GetRenderComponent()->SetMobility(EComponentMobility::Stationary);
-		createdChildActor->GetRenderComponent()->SetTranslucentSortPriority(*YIndex);
+		SetActorSignature(createdChildActor, node.Signature);
+		Context.CreatedActors.Add(createdChildActor);
+
+		// images get their sort priority together with their sprite, it depends on its material
+		if (!ShowsImageSprite(Plan, NodeIndex))
+			createdChildActor->GetRenderComponent()->SetTranslucentSortPriority(layout.SortPriorities[NodeIndex]);
 
 		// then we add an articyReference to it, storing the articy object that this new actor represents with it
 		UArticyReference* articyReference = NewObject<UArticyReference>(createdChildActor);
 		createdChildActor->AddInstanceComponent(articyReference);
-		articyReference->SetReference(child.Get());
+		articyReference->SetReference(layout.Objects[NodeIndex].Get());
+
+		++Context.SpawnedActorCount;
+		++Context.AddedComponentCount;
+	}
 
 #pragma endregion
 
 
 #pragma region Attach Behaviours By Template to the new actor
 
-		for (auto& Pair : ObjectComponentMap)
-		{
-			/* We created in Blueprint an object-component map, which uses the type of an articy object as key
-			*  and the component that should be attached to the actor representation of this articy object.
-			*  (e.g. articy objects of type ConditionalZone should have an ClickableZone component attached)
-			*/
-
-			if (child->IsA(Pair.Key))
-			{				
-				auto component = NewObject<UActorComponent>(createdChildActor, Pair.Value.Get());
-				createdChildActor->AddInstanceComponent(component);
+	{
+		LOCATION_GENERATOR_PHASE_SCOPE(stats, Spawn);
 
-				bHasZoneScript = component->GetClass()->GetName().Contains("ClickableZone");
-			}
+		// the components were already looked up from the object-component map in the data phase
+		for (auto& componentClass : node.Components)
+		{
+			auto component = NewObject<UActorComponent>(createdChildActor, componentClass.Get());
+			createdChildActor->AddInstanceComponent(component);
+			++Context.AddedComponentCount;
 		}
+	}
 
 #pragma endregion
 
 
 #pragma region Create and setup sprite for location images
 
-		if (auto objectWithLocationImage = Cast<UManiacManfredLocationImage>(child))
-		{
-			// load sprite and add to renderer component
-			UArticyAsset* imageAsset = Cast<UArticyAsset>(articyDatabase->GetObject(objectWithLocationImage->ImageAsset));
-			if (imageAsset && imageAsset->Category == EArticyAssetCategory::Image)
-			{
-				// load texture
-				auto texture = Cast<UTexture2D>(imageAsset->LoadAsTexture());
-				// adjust tiling method of the texture
-				texture->AddressX = TextureAddress::TA_Clamp;
-				texture->AddressY = TextureAddress::TA_Clamp;
-				texture->MarkPackageDirty();
-
-				// create sprite from texture
-				FSpriteAssetInitParameters initParams;
-				initParams.SetTextureAndFill(texture);
-				UPaperSprite* sprite = Cast<UPaperSprite>(NewObject<UPaperSprite>(createdChildActor));
-				sprite->SetPivotMode(ESpritePivotMode::Bottom_Left, FVector2D::ZeroVector);
-				sprite->InitializeSprite(initParams);
-
-				// apply sprite to actor
-				createdChildActor->GetRenderComponent()->SetSprite(sprite);			
-			}
+	// while the texture is still streaming, the sprite and the position depending on it are set once it arrived
+	bool bSpritePending = false;
+
+	if (node.LocationImage)
+	{
+		LOCATION_GENERATOR_PHASE_SCOPE(stats, Sprite);
+
+		// if this location image is a background image, we store its reference in order
+		// to return it and pass it to the BackgroundImageHandler Component later in Blueprint
+		if (bIsBackgroundLayer)
+			Context.BackgroundLayer = node.LocationImage;
 
-			// if this location image is a background image, we store its reference in order
-			// to return it and pass it to the BackgroundImageHandler Component later in Blueprint
-			auto displayName = Cast<IArticyObjectWithDisplayName>(child);
-			if (displayName && displayName->GetDisplayName().ToString() == "Background layer")
-				BackgroundLayer = objectWithLocationImage;
+		UArticyAsset* imageAsset = Cast<UArticyAsset>(Context.Database->GetObject(node.LocationImage->ImageAsset));
+		bSpritePending = Context.Settings.bStreamTexturesAsync && ShowsImageSprite(Plan, NodeIndex) && !Context.SpriteCache->IsTextureReady(imageAsset);
+
+		if (bSpritePending)
+		{
+			Context.PendingSprites.Add({ createdChildActor, NodeIndex });
+			++Context.DeferredSpriteCount;
 		}
+		else
+		{
+			SetImageSprite(createdChildActor, Plan, NodeIndex, Context);
+		}
+	}
 
 #pragma endregion
 
 #pragma region Create a Collider if it a zone (has verices and bHasZoneScript is true)
 
-		/* We calculate the bounds for every object with vertices, even if we don't want to attach a collider to it.
-		*  So we make sure, that we don't run into issues when we adjust the transformations
-		*/
+	if (layout.HasFlags(NodeIndex, ELocationLayoutFlags::HasVertices))
+	{
+		if (node.bHasZoneScript)
+		{
+			LOCATION_GENERATOR_PHASE_SCOPE(stats, Collider);
 
-		auto objectWithVertices = Cast<IArticyObjectWithVertices>(child);
-		if (objectWithVertices)
+			// if it a zone, we create a new sprite, set the collision points on it and apply it to the paper sprite actor
+			createdChildActor->GetRenderComponent()->SetSprite(CreateColliderSprite(createdChildActor, Plan, NodeIndex));
+		}
+		else
 		{
-			auto vertices = objectWithVertices->GetVertices();
+			// if the actor represents an image instead of a zone, we disable the collision on it.
+			createdChildActor->GetRenderComponent()->SetCollisionEnabled(ECollisionEnabled::NoCollision);
+		}
+	}
 
-			// we calculate the overall bounds of this polygon
-			bounds = FRect::GetBounds(&vertices);
+#pragma endregion
 
-			// ajdust pixel scaling
-			TArray<FVector2D> colliderPoints;
-			for (int i = 0; i < vertices.Num(); ++i)
-			{
-				auto vec = vertices[i];
-				
-				auto v = FVector2D(vec.X / PixelsToUnits, vec.Y / PixelsToUnits);
-				colliderPoints.Add(v);
-			}
+#pragma region Adjust the objects transformations
 
-			if (bHasZoneScript)
-			{
-				// if it a zone, we create a new sprite, set the collision points on it and apply it to the paper sprite actor
-				FSpriteAssetInitParameters initParams;
-				initParams.SetPixelsPerUnrealUnit(1);
-				UPaperSprite* sprite = Cast<UPaperSprite>(NewObject<UPaperSprite>(createdChildActor));
+	if (layout.HasFlags(NodeIndex, ELocationLayoutFlags::HasTransform) && !bSpritePending)
+	{
+		LOCATION_GENERATOR_PHASE_SCOPE(stats, Transform);
+
+		// if the object has no vertices, we generate the bounds from the sprite size
+		createdChildActor->SetActorLocation(GetNodeLocation(Plan, NodeIndex, createdChildActor->GetRenderComponent()->GetSprite(), PixelsToUnits), false);
+	}
 
-				SetSpritePolygonCollider(sprite, colliderPoints);
+#pragma endregion
 
-				sprite->InitializeSprite(initParams);
-				sprite->MarkPackageDirty();
-				
-				createdChildActor->GetRenderComponent()->SetSprite(sprite);			
-			}
-			else
-			{
-				// we need the bounds again, if this object does not only contain vertices, but also represents an image
-				bounds = FRect::GetBounds(&colliderPoints);
-				// if the actor represents an image instead of a zone, we disable the collision on it.
-				createdChildActor->GetRenderComponent()->SetCollisionEnabled(ECollisionEnabled::NoCollision);
-			}
+	return createdChildActor;
+
+#else
+	return nullptr;
+#endif // WITH_EDITOR
+}
+
+/* Loads the sprite of a location image and applies it to its actor */
+void ULocationGenerator::SetImageSprite(APaperSpriteActor* Actor, const FLocationGenerationPlan& Plan, int32 NodeIndex, FLocationGenerationContext& Context)
+{
+#if WITH_EDITOR
+
+	// load sprite and add to renderer component
+	UPaperSprite* sharedSprite = GetNodeSprite(Plan, NodeIndex, Context);
+	if (sharedSprite && KeepsWholeTexture(Plan.Layout, NodeIndex))
+	{
+		UPaperSprite* sprite = DuplicateObject<UPaperSprite>(sharedSprite, Actor);
+		Actor->GetRenderComponent()->SetSprite(sprite);
+	}
+	else if (sharedSprite)
+	{
+		// apply sprite to actor
+		Actor->GetRenderComponent()->SetSprite(sharedSprite);
+	}
+
+	// opaque and masked images are depth sorted by their y position, only translucent ones are sorted by their priority
+	if (ULocationSpriteCache::NeedsSortPriority(Actor->GetRenderComponent()->GetSprite()))
+		Actor->GetRenderComponent()->SetTranslucentSortPriority(Plan.Layout.SortPriorities[NodeIndex]);
+
+#endif // WITH_EDITOR
+}
+
+/* Sets the sprites of actors whose texture finished streaming, and their position which depends on the sprite size.
+*  With bWaitForTextures all remaining actors get their sprite, waiting for the textures that are still loading.
+*/
+void ULocationGenerator::FinishPendingSprites(const FLocationGenerationPlan& Plan, FLocationGenerationContext& Context, bool bWaitForTextures)
+{
+#if WITH_EDITOR
+
+	for (int32 i = Context.PendingSprites.Num() - 1; i >= 0; --i)
+	{
+		APaperSpriteActor* actor = Context.PendingSprites[i].Key.Get();
+		const int32 nodeIndex = Context.PendingSprites[i].Value;
 
-			bBoundsSet = true;
+		// the actor may have been deleted in the editor while its texture was still streaming
+		if (!actor)
+		{
+			Context.PendingSprites.RemoveAtSwap(i);
+			continue;
 		}
 
-#pragma endregion
+		UArticyAsset* imageAsset = Cast<UArticyAsset>(Context.Database->GetObject(Plan.Nodes[nodeIndex].LocationImage->ImageAsset));
+		if (!bWaitForTextures && !Context.SpriteCache->IsTextureReady(imageAsset))
+			continue;
 
-#pragma region Adjust the objects transformations
+		SetImageSprite(actor, Plan, nodeIndex, Context);
+
+		if (Plan.Layout.HasFlags(nodeIndex, ELocationLayoutFlags::HasTransform))
+			actor->SetActorLocation(GetNodeLocation(Plan, nodeIndex, actor->GetRenderComponent()->GetSprite(), Context.PixelsToUnits), false);
+
+		Context.PendingSprites.RemoveAtSwap(i);
+	}
+
+#endif // WITH_EDITOR
+}
+
+/* Adds a location image to the current batch, the instance gets the same position the actor of the image would get */
+void ULocationGenerator::AddBatchedImage(const FLocationGenerationPlan& Plan, int32 NodeIndex, FLocationGenerationContext& Context)
+{
+#if WITH_EDITOR
+
+	// the kept batch actor already holds this image
+	if (Context.bKeptBatchActor)
+		return;
+
+	const FLocationLayout& layout = Plan.Layout;
+	FLocationGeneratorStats* stats = Context.Settings.Stats;
+
+	UPaperSprite* sprite = nullptr;
+	{
+		LOCATION_GENERATOR_PHASE_SCOPE(stats, Sprite);
+
+		// instances keep the order they were added in, so when streaming textures a batched image waits for its own texture right here
+		sprite = GetNodeSprite(Plan, NodeIndex, Context);
+		if (!sprite)
+			return;
+	}
+
+	// translucent images are drawn in the order they were added, opaque and masked ones can all share one component no matter what lies between them
+	const bool bNeedsSortPriority = ULocationSpriteCache::NeedsSortPriority(sprite);
+	UPaperGroupedSpriteComponent*& batchComponent = bNeedsSortPriority ? Context.BatchComponent : Context.DepthSortedBatchComponent;
+
+	if (!batchComponent)
+	{
+		LOCATION_GENERATOR_PHASE_SCOPE(stats, Spawn);
 
-		auto objectWithTransform = Cast<IArticyObjectWithTransform>(child);
-		if (objectWithTransform)
+		if (!Context.BatchActor)
 		{
-			// if the bounds are not set up to now, we generate them from the sprite size
-			if (!bBoundsSet)
-			{
-				auto sprite = createdChildActor->GetRenderComponent()->GetSprite();
-				if (sprite)
-				{
-					bounds.w = sprite->GetSourceSize().Y / PixelsToUnits;
-					bounds.h = sprite->GetSourceSize().X / PixelsToUnits;
-				}
-			}
+			Context.BatchActor = Context.World->SpawnActorDeferred<APaperGroupedSpriteActor>(APaperGroupedSpriteActor::StaticClass(), FTransform::Identity, Context.WorldContext);
+			Context.BatchActor->SetActorLabel(TEXT("StaticImages"));
+			Context.BatchActor->SetFolderPath(TEXT("GeneratedObjects"));
+			Context.BatchActor->FinishSpawning(FTransform::Identity);
+			SetActorSignature(Context.BatchActor, Context.BatchSignature);
+			batchComponent = Context.BatchActor->GetRenderComponent();
+			Context.CreatedActors.Add(Context.BatchActor);
+			++Context.SpawnedActorCount;
 
-			// update transform
-			auto translation = objectWithTransform->GetTransform()->Translation;
-			if (bHasZoneScript)
-			{
-				// change the position
-				createdChildActor->SetActorLocation(FVector(translation.X / PixelsToUnits, *YIndex,
-					bounds.GetYMax() + (OverallBounds.h - bounds.h - (translation.Y / PixelsToUnits))), false);
-			}
-			else
-			{
-				createdChildActor->SetActorLocation(FVector(translation.X / PixelsToUnits, *YIndex,
-					OverallBounds.h - bounds.h - (translation.Y / PixelsToUnits)), false);
-			}
+			// when reconciling an outdated previous batch is removed with the other unmatched actors
+			if (Context.Settings.bReconcileExistingActors)
+				++Context.CreatedCount;
+		}
+		else
+		{
+			batchComponent = NewObject<UPaperGroupedSpriteComponent>(Context.BatchActor);
+			batchComponent->SetupAttachment(Context.BatchActor->GetRootComponent());
+			Context.BatchActor->AddInstanceComponent(batchComponent);
+			batchComponent->RegisterComponent();
+			++Context.AddedComponentCount;
+		}
+
+		// images never collide, and a batch is sorted like its first image, the instances inside it keep the order they were added in
+		batchComponent->SetMobility(EComponentMobility::Stationary);
+		batchComponent->SetCollisionEnabled(ECollisionEnabled::NoCollision);
+		if (bNeedsSortPriority)
+			batchComponent->SetTranslucentSortPriority(layout.SortPriorities[NodeIndex]);
+		++Context.BatchComponentCount;
+	}
+
+	FVector location;
+	{
+		LOCATION_GENERATOR_PHASE_SCOPE(stats, Transform);
+
+		// the y position is the sort priority of the image, so the instances are still depth sorted against each other
+		location = GetNodeLocation(Plan, NodeIndex, sprite, Context.PixelsToUnits);
+	}
+
+	batchComponent->AddInstance(FTransform(location), sprite, true);
+	++Context.BatchedImageCount;
+
+#endif // WITH_EDITOR
+}
+
+/* Adds an object without an actor of its own to the location data actor, spots, links and paths as data entries and texts as text render components */
+void ULocationGenerator::AddLightweightObject(const FLocationGenerationPlan& Plan, int32 NodeIndex, FLocationGenerationContext& Context)
+{
+#if WITH_EDITOR
+
+	// the kept data actor already holds this object
+	if (Context.bKeptDataActor)
+		return;
+
+	const FLocationLayout& layout = Plan.Layout;
+	const FLocationPlanNode& node = Plan.Nodes[NodeIndex];
+	FLocationGeneratorStats* stats = Context.Settings.Stats;
+
+	if (!Context.DataActor)
+	{
+		LOCATION_GENERATOR_PHASE_SCOPE(stats, Spawn);
+
+		Context.DataActor = Context.World->SpawnActorDeferred<AActor>(AActor::StaticClass(), FTransform::Identity, Context.WorldContext);
+		Context.DataActor->SetActorLabel(TEXT("LocationData"));
+		Context.DataActor->SetFolderPath(TEXT("GeneratedObjects"));
+		Context.DataActor->FinishSpawning(FTransform::Identity);
+		SetActorSignature(Context.DataActor, Context.DataSignature);
+		Context.CreatedActors.Add(Context.DataActor);
+
+		// the text render components need something to be attached to
+		USceneComponent* root = NewObject<USceneComponent>(Context.DataActor, TEXT("Root"));
+		root->SetMobility(EComponentMobility::Stationary);
+		Context.DataActor->SetRootComponent(root);
+		Context.DataActor->AddInstanceComponent(root);
+		root->RegisterComponent();
+
+		Context.DataComponent = NewObject<ULocationDataComponent>(Context.DataActor, TEXT("LocationData"));
+		Context.DataActor->AddInstanceComponent(Context.DataComponent);
+		Context.DataComponent->RegisterComponent();
 
+		Context.DataEntryIndices.Init(INDEX_NONE, Plan.Nodes.Num());
+		++Context.SpawnedActorCount;
+		Context.AddedComponentCount += 2;
+
+		// like the batch, when reconciling an outdated previous data actor is removed with the other unmatched actors
+		if (Context.Settings.bReconcileExistingActors)
+			++Context.CreatedCount;
+	}
+
+	FVector location;
+	{
+		LOCATION_GENERATOR_PHASE_SCOPE(stats, Transform);
+		location = GetNodeLocation(Plan, NodeIndex, nullptr, Context.PixelsToUnits);
+	}
+
+	if (node.Representation == ELocationNodeRepresentation::Text)
+	{
+		LOCATION_GENERATOR_PHASE_SCOPE(stats, Spawn);
+
+		const UManiacManfredLocationText& locationText = *node.LocationText;
+		UTextRenderComponent* textComponent = NewObject<UTextRenderComponent>(Context.DataActor);
+		textComponent->SetupAttachment(Context.DataActor->GetRootComponent());
+		textComponent->SetMobility(EComponentMobility::Stationary);
+		textComponent->SetCollisionEnabled(ECollisionEnabled::NoCollision);
+		textComponent->SetText(locationText.Text);
+		textComponent->SetTextRenderColor(locationText.Color.ToFColor(true));
+		textComponent->SetHorizontalAlignment(EHTA_Left);
+		textComponent->SetVerticalAlignment(EVRTA_TextTop);
+		textComponent->SetVisibility(Context.Settings.bShowLightweightTexts);
+
+		// the text box is drawn in articy, its lines share its height
+		if (node.Bounds.h > 0)
+		{
+			int32 lineCount = 1;
+			for (const TCHAR character : locationText.Text.ToString())
+				lineCount += character == TEXT('\n') ? 1 : 0;
+
+			textComponent->SetWorldSize(node.Bounds.h / lineCount);
+			location.Z += node.Bounds.h;
 		}
 
-#pragma endregion
-		
-		*YIndex += 0.2;
-		// some objects inside a location, can have children themselves, so we just recursively call GenerateChildren again
-		GenerateChildren(createdChildActor, child.Get(), PixelsToUnits, ObjectComponentMap, OverallBounds, YIndex, WorldContext, BackgroundLayer);
+		// text render components face along their x axis, the location is drawn in the X/Z plane and looked at along the y axis
+		textComponent->SetRelativeLocationAndRotation(location, FRotator(0, -90, 0));
+		Context.DataActor->AddInstanceComponent(textComponent);
+		textComponent->RegisterComponent();
+
+		++Context.AddedComponentCount;
+		++Context.TextComponentCount;
+		return;
 	}
 
+	FLocationDataEntry& entry = Context.DataComponent->Entries.AddDefaulted_GetRef();
+	entry.Id = layout.Ids[NodeIndex];
+	entry.Label = node.Label;
+	entry.ShapeType = layout.ShapeTypes[NodeIndex];
+	entry.Location = location;
+	entry.Vertices = TArray<FVector2D>(layout.GetVertices(NodeIndex));
+	entry.bVisible = layout.IsVisibleInHierarchy(NodeIndex);
+
+	for (int32 parent = layout.ParentIndices[NodeIndex]; parent != INDEX_NONE && entry.Parent == INDEX_NONE; parent = layout.ParentIndices[parent])
+		entry.Parent = Context.DataEntryIndices[parent];
+
+	Context.DataEntryIndices[NodeIndex] = Context.DataComponent->Entries.Num() - 1;
+
 #endif // WITH_EDITOR
 }
 
-void ULocationGenerator::SetSpritePolygonCollider(UPaperSprite* Sprite, TArray<FVector2D> Vertices)
+/* Creates the invisible sprite that carries the collider of a zone */
+UPaperSprite* ULocationGenerator::CreateColliderSprite(UObject* Outer, const FLocationGenerationPlan& Plan, int32 NodeIndex)
+{
+#if WITH_EDITOR
+
+	const FLocationPlanNode& node = Plan.Nodes[NodeIndex];
+
+	FSpriteAssetInitParameters initParams;
+	initParams.SetPixelsPerUnrealUnit(1);
+	UPaperSprite* sprite = NewObject<UPaperSprite>(Outer);
+
+	if (node.ColliderShapes.Num() > 0)
+		SetSpritePolygonCollider(sprite, node.ColliderShapes);
+	else
+		SetSpritePolygonCollider(sprite, { TArray<FVector2D>(Plan.GetColliderPoints(NodeIndex)) });
+
+	sprite->InitializeSprite(initParams);
+	sprite->MarkPackageDirty();
+
+	return sprite;
+
+#else
+	return nullptr;
+#endif // WITH_EDITOR
+}
+
+void ULocationGenerator::SetSpritePolygonCollider(UPaperSprite* Sprite, const TArray<TArray<FVector2D>>& Shapes)
 {
 #if WITH_EDITOR
 	// here we use Unreals reflection to set the collider on a sprite
+	TRACE_CPUPROFILER_EVENT_SCOPE(ULocationGenerator::SetSpritePolygonCollider);
 
 	if (FProperty* collisionGeometryProp = Sprite->GetClass()->FindPropertyByName("CollisionGeometry"))
 	{
@@ -315,19 +2296,23 @@ void ULocationGenerator::SetSpritePolygonCollider(UPaperSprite* Sprite, TArray<F
 		if (FStructProperty* structProp = CastField<FStructProperty>(collisionGeometryProp))
 		{
 			UScriptStruct* scriptStruct = structProp->Struct;
-		
+
 			if (FArrayProperty* shapesProp = CastField<FArrayProperty>(scriptStruct->FindPropertyByName("Shapes")))
 			{
 				FSpriteGeometryCollection* collisionGeometryPtr = shapesProp->ContainerPtrToValuePtr<FSpriteGeometryCollection>(structAddress);
 
-				FSpriteGeometryShape polygonCollider;
-				polygonCollider.ShapeType = ESpriteShapeType::Polygon;
-				polygonCollider.Vertices = Vertices;
-
 				collisionGeometryPtr->GeometryType = ESpritePolygonMode::FullyCustom;
 				collisionGeometryPtr->Shapes.Empty();
-				collisionGeometryPtr->Shapes.Add(polygonCollider);
 
+				for (auto& vertices : Shapes)
+				{
+					FSpriteGeometryShape polygonCollider;
+					polygonCollider.ShapeType = ESpriteShapeType::Polygon;
+					polygonCollider.Vertices = vertices;
+					collisionGeometryPtr->Shapes.Add(polygonCollider);
+				}
+
+				TRACE_CPUPROFILER_EVENT_SCOPE(FSpriteGeometryCollection::ConditionGeometry);
 				collisionGeometryPtr->ConditionGeometry();
 			}
 
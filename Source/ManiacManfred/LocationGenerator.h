@@ -7,8 +7,22 @@
 #include "Paper2DClasses.h"
 #include "ArticyBaseInclude.h"
 #include "ArticyGenerated/ManiacManfredArticyTypes.h"
+#include "LocationGeometry.h"
+#include "ProfilingDebugging/CpuProfilerTrace.h"
+#include "Stats/Stats.h"
 #include "LocationGenerator.generated.h"
 
+/* stat LocationGenerator shows the time of every generation phase and what the last generation did */
+DECLARE_STATS_GROUP(TEXT("Location Generator"), STATGROUP_LocationGenerator, STATCAT_Advanced);
+
+DECLARE_CYCLE_STAT_EXTERN(TEXT("Clear"), STAT_LocationGenerator_Clear, STATGROUP_LocationGenerator, MANIACMANFRED_API);
+DECLARE_CYCLE_STAT_EXTERN(TEXT("Layout"), STAT_LocationGenerator_Layout, STATGROUP_LocationGenerator, MANIACMANFRED_API);
+DECLARE_CYCLE_STAT_EXTERN(TEXT("Bounds"), STAT_LocationGenerator_Bounds, STATGROUP_LocationGenerator, MANIACMANFRED_API);
+DECLARE_CYCLE_STAT_EXTERN(TEXT("Spawn"), STAT_LocationGenerator_Spawn, STATGROUP_LocationGenerator, MANIACMANFRED_API);
+DECLARE_CYCLE_STAT_EXTERN(TEXT("Sprite"), STAT_LocationGenerator_Sprite, STATGROUP_LocationGenerator, MANIACMANFRED_API);
+DECLARE_CYCLE_STAT_EXTERN(TEXT("Collider"), STAT_LocationGenerator_Collider, STATGROUP_LocationGenerator, MANIACMANFRED_API);
+DECLARE_CYCLE_STAT_EXTERN(TEXT("Transform"), STAT_LocationGenerator_Transform, STATGROUP_LocationGenerator, MANIACMANFRED_API);
+
 USTRUCT()
 struct MANIACMANFRED_API FRect
 {
@@ -43,27 +57,25 @@ public:
 
 	static FRect GetBounds(const TArray<FVector2D>* Vertices)
 	{
-		FRect rc = FRect();
-		rc.x = INFINITY;
-		rc.y = INFINITY;
-		rc.w = 0;
-		rc.h = 0;
-
-		float right = 0;
-		float bottom = 0;
-		for (int i = 0; i < Vertices->Num(); ++i)
-		{
-			auto vec = (*Vertices)[i];
+		return GetBounds(TArrayView<const FVector2D>(*Vertices));
+	}
 
-			rc.x = FMath::Min(rc.x, vec.X);
-			rc.y = FMath::Min(rc.y, vec.Y);
+	static FRect GetBounds(TArrayView<const FVector2D> Vertices)
+	{
+		return FromBox(LocationGeometry::ComputeBounds(Vertices));
+	}
 
-			right = FMath::Max(right, vec.X);
-			bottom = FMath::Max(bottom, vec.Y);
-		}
+	/* An invalid (empty) box becomes an empty rect at the origin */
+	static FRect FromBox(const FBox2D& Box)
+	{
+		FRect rc = FRect();
+		if (!Box.bIsValid)
+			return rc;
 
-		rc.SetXMax(right);
-		rc.SetYMax(bottom);
+		rc.x = Box.Min.X;
+		rc.y = Box.Min.Y;
+		rc.SetXMax(Box.Max.X);
+		rc.SetYMax(Box.Max.Y);
 
 		return rc;
 	}
@@ -85,6 +97,210 @@ public:
 	}
 };
 
+/* The phases the generation time is split into when measuring it, see FLocationGeneratorStats */
+enum class ELocationGeneratorPhase : uint8
+{
+	/* removing or collecting the previously generated actors */
+	Clear,
+	/* flattening the articy location into a FLocationLayout */
+	Layout,
+	/* the parallel data phase: bounds, collider polygons, actor locations and signatures */
+	Bounds,
+	/* spawning the actors and adding their components */
+	Spawn,
+	/* getting the sprites of location images */
+	Sprite,
+	/* creating the collider sprites of zones */
+	Collider,
+	/* positioning the actors */
+	Transform,
+	Num
+};
+
+struct MANIACMANFRED_API FLocationGeneratorPhaseStats
+{
+	double Seconds = 0;
+	int32 Scopes = 0;
+	/* How many UObjects were added (or, if negative, removed) while the phase was running */
+	int32 ObjectCountDelta = 0;
+	/* How much the used physical memory of the process changed while the phase was running, in bytes */
+	int64 UsedMemoryDelta = 0;
+	/* The highest peak used physical memory of the process seen at the end of one of the phase's scopes, in bytes */
+	uint64 PeakUsedMemory = 0;
+	/* Heap allocations and reallocations made while the phase was running, by all threads. Always 0 in shipping builds. */
+	uint64 Allocations = 0;
+};
+
+/* Where the time of a generation goes. Only collected if FLocationGeneratorSettings::Stats is set, e.g. by the benchmark commandlet. */
+struct MANIACMANFRED_API FLocationGeneratorStats
+{
+	FLocationGeneratorPhaseStats Phases[(int32)ELocationGeneratorPhase::Num];
+
+	FLocationGeneratorPhaseStats& operator[](ELocationGeneratorPhase Phase) { return Phases[(int32)Phase]; }
+	const FLocationGeneratorPhaseStats& operator[](ELocationGeneratorPhase Phase) const { return Phases[(int32)Phase]; }
+
+	void Reset() { *this = FLocationGeneratorStats(); }
+
+	static const TCHAR* GetPhaseName(ELocationGeneratorPhase Phase);
+};
+
+/* Adds the time, the UObjects, the memory and the allocations created inside of a scope to a phase, does nothing if there are no stats to collect */
+struct MANIACMANFRED_API FLocationGeneratorPhaseScope
+{
+	FLocationGeneratorPhaseScope(FLocationGeneratorStats* InStats, ELocationGeneratorPhase InPhase);
+	~FLocationGeneratorPhaseScope();
+
+private:
+
+	FLocationGeneratorStats* Stats;
+	ELocationGeneratorPhase Phase;
+	double StartTime = 0;
+	int32 StartObjectCount = 0;
+	uint64 StartUsedMemory = 0;
+	uint64 StartAllocations = 0;
+
+	static uint64 GetAllocationCount();
+};
+
+/* Times a phase for the FLocationGeneratorStats, the stat group and Unreal Insights at once, Phase is the name of an ELocationGeneratorPhase */
+#define LOCATION_GENERATOR_PHASE_SCOPE(Stats, Phase) \
+	TRACE_CPUPROFILER_EVENT_SCOPE(LocationGenerator_##Phase); \
+	SCOPE_CYCLE_COUNTER(STAT_LocationGenerator_##Phase); \
+	FLocationGeneratorPhaseScope ANONYMOUS_VARIABLE(LocationGeneratorPhaseScope)(Stats, ELocationGeneratorPhase::Phase)
+
+/* Options that change how a location is (re)generated */
+USTRUCT(BlueprintType)
+struct MANIACMANFRED_API FLocationGeneratorSettings
+{
+	GENERATED_BODY()
+
+public:
+
+	/* If set, previously generated actors are matched to their articy objects via their ArticyReference component.
+	*  Only actors whose class, components, image or shape changed are recreated, kept actors that moved or changed their sort order are updated in place,
+	*  actors of deleted objects are removed and everything else stays untouched.
+	*/
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Location Generator")
+	bool bReconcileExistingActors = false;
+
+	/* Cache for the textures and sprites of location images. If none is set, the cache of the generating actor's ULocationSpriteCacheComponent is used. */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Location Generator")
+	TObjectPtr<class ULocationSpriteCache> SpriteCache = nullptr;
+
+	/* Removes zone collider vertices that barely change its outline, see ColliderSimplifyTolerance */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Location Generator|Colliders")
+	bool bSimplifyColliders = false;
+
+	/* How far (in Unreal units) the simplified collider outline may deviate from the zone drawn in articy */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Location Generator|Colliders", meta = (EditCondition = "bSimplifyColliders", ClampMin = "0"))
+	float ColliderSimplifyTolerance = 1.0f;
+
+	/* Splits concave zone colliders into several convex shapes, which are cheaper for Paper2D collision */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Location Generator|Colliders")
+	bool bDecomposeColliders = false;
+
+	/* Packs the textures of all location images into a few shared atlases, so the images of a location can be drawn from the same texture */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Location Generator|Atlas")
+	bool bPackSpriteAtlas = false;
+
+	/* Width and height limit of a single atlas in pixels, images that don't fit keep their own texture */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Location Generator|Atlas", meta = (EditCondition = "bPackSpriteAtlas", ClampMin = "64", ClampMax = "8192"))
+	int32 MaxAtlasSize = 2048;
+
+	/* Pixels around every image inside an atlas, filled with its border pixels so neighbouring images don't bleed in */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Location Generator|Atlas", meta = (EditCondition = "bPackSpriteAtlas", ClampMin = "0", ClampMax = "16"))
+	int32 AtlasPadding = 2;
+
+	/* Fits the sprites of location images tightly around their visible pixels instead of drawing their whole rectangle, so transparent areas cost no fill rate.
+	*  The background layer keeps its rectangle.
+	*/
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Location Generator|Sprites")
+	bool bTightSpriteGeometry = false;
+
+	/* Pixels with less alpha than this count as transparent for the tight sprite geometry */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Location Generator|Sprites", meta = (EditCondition = "bTightSpriteGeometry", ClampMin = "0", ClampMax = "1"))
+	float SpriteAlphaThreshold = 0.0f;
+
+	/* Analyzes the alpha of every location image and draws fully opaque images with the OpaqueSpriteMaterial and images with binary alpha with the MaskedSpriteMaterial.
+	*  Both write depth, so these images skip the sorting and blending of translucent sprites, only images with real alpha gradients keep their sort priority.
+	*  The background layer keeps the default material.
+	*/
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Location Generator|Sprites")
+	bool bClassifyImageAlpha = false;
+
+	/* Share of partially transparent pixels, e.g. anti-aliased edges, an image may have and still be drawn masked instead of translucent */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Location Generator|Sprites", meta = (EditCondition = "bClassifyImageAlpha", ClampMin = "0", ClampMax = "1"))
+	float MaskedAlphaTolerance = 0.01f;
+
+	/* The materials of opaque and masked images, Paper2D's unlit sprite materials if none */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Location Generator|Sprites", meta = (EditCondition = "bClassifyImageAlpha"))
+	TObjectPtr<UMaterialInterface> OpaqueSpriteMaterial = nullptr;
+
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Location Generator|Sprites", meta = (EditCondition = "bClassifyImageAlpha"))
+	TObjectPtr<UMaterialInterface> MaskedSpriteMaterial = nullptr;
+
+	/* Draws all location images that are never clicked, hidden or swapped with a few grouped sprite components instead of one actor each.
+	*  Only zones, the background layer and objects that get components from the ObjectComponentMap keep their own actors.
+	*/
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Location Generator|Batching")
+	bool bBatchStaticImages = false;
+
+	/* Spawns no actors for objects that have nothing to draw or click. Spots, links and paths become entries of a ULocationDataComponent,
+	*  texts become text render components, both on a single LocationData actor. Objects that get components from the ObjectComponentMap keep their actors.
+	*/
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Location Generator|Batching")
+	bool bLightweightObjects = false;
+
+	/* Makes the text render components of lightweight texts visible. Text actors never drew their text, so by default the components stay hidden as well. */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Location Generator|Batching", meta = (EditCondition = "bLightweightObjects"))
+	bool bShowLightweightTexts = false;
+
+	/* Sizes and groups the textures of location images by the biggest size they are drawn with at the TargetResolutions, see FLocationTextureBudget.
+	*  Only this location is looked at, so textures that images of other locations show too are left alone.
+	*/
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Location Generator|Texture Budget")
+	bool bOptimizeTextureBudget = false;
+
+	/* The screen resolutions the game is played at, the camera always shows the whole location */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Location Generator|Texture Budget", meta = (EditCondition = "bOptimizeTextureBudget"))
+	TArray<FIntPoint> TargetResolutions = { FIntPoint(1280, 720), FIntPoint(1920, 1080) };
+
+	/* How far the camera may zoom into a location, textures keep enough pixels for the closest view */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Location Generator|Texture Budget", meta = (EditCondition = "bOptimizeTextureBudget", ClampMin = "1"))
+	float MaxCameraZoom = 1.0f;
+
+	/* Requests the textures of all location images up front and streams them in while the actors are spawned, the sprites are filled in as their textures arrive.
+	*  Only pays off for textures that aren't loaded yet, e.g. when generating for the first time after starting the editor.
+	*/
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Location Generator|Streaming")
+	bool bStreamTexturesAsync = false;
+
+	/* Writes the generated location as flat binary layout to Saved/Locations, which tools and runtime code can memory map and query without loading the map (see FLocationBinaryLayoutView) */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Location Generator")
+	bool bWriteBinaryLayout = false;
+
+	/* Estimates the overdraw of the location images after generating and writes it as heat map to Saved/Locations, see FLocationOverdraw */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Location Generator|Analysis")
+	bool bAnalyzeOverdraw = false;
+
+	/* The screen resolution the overdraw is estimated for */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Location Generator|Analysis", meta = (EditCondition = "bAnalyzeOverdraw"))
+	FIntPoint OverdrawResolution = FIntPoint(1920, 1080);
+
+	/* If set, the time spent in every phase of the generation is added to these stats */
+	FLocationGeneratorStats* Stats = nullptr;
+
+	/* If set, the textures the texture budget pass looked at are added to this report */
+	struct FLocationTextureBudgetReport* TextureBudgetReport = nullptr;
+
+	/* If set, the result of the overdraw analysis is stored here */
+	struct FLocationOverdrawResult* OverdrawResult = nullptr;
+};
+
+struct FLocationGenerationContext;
+struct FLocationGenerationPlan;
+struct FLocationLayout;
+
 /**
  * 
  */
@@ -95,11 +311,86 @@ class MANIACMANFRED_API ULocationGenerator : public UBlueprintFunctionLibrary
 	
 public:
 
+	/* Generates the location in one go, which blocks the editor until all actors exist.
+	*  ULocationGenerationSubsystem::GenerateLocation spreads the same generation over several ticks and can be cancelled.
+	*/
+	UFUNCTION(BlueprintCallable)
+	static void GenerateLocation(UManiacManfredLocation* Location, float PixelsToUnits, const TMap<TSubclassOf<class UArticyBaseObject>, TSubclassOf<class UActorComponent>>& ObjectComponentMap, AActor* WorldContext, /*OUT*/ UManiacManfredLocationImage*& BackgroundLayer);
+
+	UFUNCTION(BlueprintCallable)
+	static void GenerateLocationWithSettings(UManiacManfredLocation* Location, float PixelsToUnits, const TMap<TSubclassOf<class UArticyBaseObject>, TSubclassOf<class UActorComponent>>& ObjectComponentMap, const FLocationGeneratorSettings& Settings, AActor* WorldContext, /*OUT*/ UManiacManfredLocationImage*& BackgroundLayer);
+
+	/* Generates a location that was already flattened, e.g. one built from objects which don't live in an articy database.
+	*  LocationName is only used for logging.
+	*/
+	static void GenerateLocationFromLayout(FLocationLayout&& Layout, FName LocationName, float PixelsToUnits, const TMap<TSubclassOf<class UArticyBaseObject>, TSubclassOf<class UActorComponent>>& ObjectComponentMap, const FLocationGeneratorSettings& Settings, AActor* WorldContext, /*OUT*/ UManiacManfredLocationImage*& BackgroundLayer);
+
+	/* Bakes a location into a cooked layout, which ULocationInstantiationSubsystem can spawn at runtime without the generator.
+	*  Uses the same settings as generating, the sprites end up in the sprite cache of the settings or in a cache inside the cooked layout.
+	*/
 	UFUNCTION(BlueprintCallable)
-	static void GenerateLocation(UManiacManfredLocation* Location, float PixelsToUnits, const TMap<TSubclassOf<class UArticyBaseObject>, TSubclassOf<class UActorComponent>> ObjectComponentMap, AActor* WorldContext, /*OUT*/ UManiacManfredLocationImage*& BackgroundLayer);
+	static void BakeLocation(UManiacManfredLocation* Location, float PixelsToUnits, const TMap<TSubclassOf<class UArticyBaseObject>, TSubclassOf<class UActorComponent>>& ObjectComponentMap, const FLocationGeneratorSettings& Settings, class ULocationCookedLayout* CookedLayout);
 
 private:
 
-	static void GenerateChildren(AActor* Parent, UArticyObject* Child, float PixelsToUnits, const TMap<TSubclassOf<class UArticyBaseObject>, TSubclassOf<class UActorComponent>> ObjectComponentMap, FRect OverallBounds, float* ZIndex, AActor* WorldContext, /*OUT*/ UManiacManfredLocationImage*& BackgroundLayer);
-	static void SetSpritePolygonCollider(UPaperSprite* Sprite, TArray<FVector2D> Vertices);
+	friend class FLocationGenerationJob;
+
+	static void GeneratePlannedLocation(FLocationGenerationPlan& Plan, FName LocationName, FLocationGenerationContext& Context);
+	static void BeginPlannedLocation(FLocationGenerationPlan& Plan, FName LocationName, FLocationGenerationContext& Context);
+	static void FinishPlannedLocation(FLocationGenerationPlan& Plan, FName LocationName, FLocationGenerationContext& Context);
+	static void RollbackPlannedLocation(FLocationGenerationContext& Context);
+	static bool SpawnPlannedActors(const FLocationGenerationPlan& Plan, FLocationGenerationContext& Context, double Deadline, int32 MaxNodes);
+	static APaperSpriteActor* CreateChildActor(AActor* Parent, const FLocationGenerationPlan& Plan, int32 NodeIndex, FLocationGenerationContext& Context);
+	static void SetImageSprite(APaperSpriteActor* Actor, const FLocationGenerationPlan& Plan, int32 NodeIndex, FLocationGenerationContext& Context);
+	static void FinishPendingSprites(const FLocationGenerationPlan& Plan, FLocationGenerationContext& Context, bool bWaitForTextures);
+	static void AddBatchedImage(const FLocationGenerationPlan& Plan, int32 NodeIndex, FLocationGenerationContext& Context);
+	static void AddLightweightObject(const FLocationGenerationPlan& Plan, int32 NodeIndex, FLocationGenerationContext& Context);
+	static UPaperSprite* CreateColliderSprite(UObject* Outer, const FLocationGenerationPlan& Plan, int32 NodeIndex);
+	static void SetSpritePolygonCollider(UPaperSprite* Sprite, const TArray<TArray<FVector2D>>& Shapes);
+};
+
+/* A generation that spawns the actors of a location over several ticks instead of all at once, see ULocationGenerationSubsystem.
+*  The previously generated actors stay in the level until the new ones are complete, so a cancelled generation leaves the location as it was.
+*/
+class MANIACMANFRED_API FLocationGenerationJob
+{
+public:
+
+	FLocationGenerationJob(UManiacManfredLocation* Location, float PixelsToUnits, const TMap<TSubclassOf<class UArticyBaseObject>, TSubclassOf<class UActorComponent>>& InObjectComponentMap, const FLocationGeneratorSettings& Settings, AActor* WorldContext);
+	~FLocationGenerationJob();
+
+	/* Continues the generation until the deadline passed or MaxObjects were spawned, at least one object per call.
+	*  The data phase runs completely inside the first call. Returns true once the location is complete.
+	*/
+	bool Tick(double Deadline, int32 MaxObjects);
+
+	/* Destroys the actors spawned so far and gives kept actors back their previous parents, does nothing once the location is complete */
+	void Cancel();
+
+	bool IsComplete() const { return bComplete; }
+	bool IsCancelled() const { return bCancelled; }
+
+	FName GetLocationName() const { return LocationName; }
+	int32 GetSpawnedObjects() const;
+	int32 GetTotalObjects() const;
+
+	/* Only set once the location is complete */
+	UManiacManfredLocationImage* GetBackgroundLayer() const { return BackgroundLayer; }
+
+	/* The job lives across garbage collections, so the owner of the job has to keep the objects it works with alive */
+	void AddReferencedObjects(FReferenceCollector& Collector);
+
+private:
+
+	/* The context refers to both, so they live as long as the job */
+	TMap<TSubclassOf<class UArticyBaseObject>, TSubclassOf<class UActorComponent>> ObjectComponentMap;
+	UManiacManfredLocationImage* BackgroundLayer = nullptr;
+
+	FName LocationName;
+	TUniquePtr<FLocationGenerationPlan> Plan;
+	TUniquePtr<FLocationGenerationContext> Context;
+
+	bool bStarted = false;
+	bool bComplete = false;
+	bool bCancelled = false;
 };
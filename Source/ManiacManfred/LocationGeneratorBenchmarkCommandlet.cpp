@@ -0,0 +1,629 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#include "LocationGeneratorBenchmarkCommandlet.h"
+#include "LocationGenerator.h"
+#include "LocationGeometry.h"
+#include "LocationLayout.h"
+#include "LocationPickingIndex.h"
+#include "ArticyDatabase.h"
+#include "Engine/Engine.h"
+#include "Engine/World.h"
+#include "HAL/PlatformMemory.h"
+#include "Math/RandomStream.h"
+#include "Misc/FileHelper.h"
+#include "Misc/Paths.h"
+#include "Dom/JsonObject.h"
+#include "Serialization/JsonSerializer.h"
+#include "Serialization/JsonWriter.h"
+
+/* Everything we can pass to the commandlet, see LocationGeneratorBenchmarkCommandlet.h */
+struct FLocationBenchmarkOptions
+{
+	TArray<int32> ObjectCounts;
+	int32 Depth = 3;
+	int32 Vertices = 8;
+	float ZoneRatio = 0.5f;
+	int32 Iterations = 3;
+	bool bReconcile = false;
+	bool bBatchStaticImages = false;
+	int32 Seed = 1;
+	float PixelsToUnits = 2;
+	FString ZoneComponent = TEXT("/Game/Blueprints/ClickableZone.ClickableZone_C");
+	TArray<int32> PickingZoneCounts;
+	int32 PickingQueries = 100000;
+	FString ReportFile;
+
+	static FLocationBenchmarkOptions Parse(const FString& Params)
+	{
+		FLocationBenchmarkOptions options;
+
+		FString objectCounts = TEXT("100+1000+10000");
+		FParse::Value(*Params, TEXT("Objects="), objectCounts, false);
+		TArray<FString> objectCountStrings;
+		objectCounts.ParseIntoArray(objectCountStrings, TEXT("+"));
+		for (auto& count : objectCountStrings)
+			options.ObjectCounts.Add(FMath::Max(FCString::Atoi(*count), 1));
+
+		FString pickingZoneCounts = TEXT("1000+10000");
+		FParse::Value(*Params, TEXT("PickingZones="), pickingZoneCounts, false);
+		TArray<FString> pickingZoneCountStrings;
+		pickingZoneCounts.ParseIntoArray(pickingZoneCountStrings, TEXT("+"));
+		for (auto& count : pickingZoneCountStrings)
+			options.PickingZoneCounts.Add(FMath::Max(FCString::Atoi(*count), 1));
+
+		FParse::Value(*Params, TEXT("PickingQueries="), options.PickingQueries);
+		FParse::Value(*Params, TEXT("Depth="), options.Depth);
+		FParse::Value(*Params, TEXT("Vertices="), options.Vertices);
+		FParse::Value(*Params, TEXT("ZoneRatio="), options.ZoneRatio);
+		FParse::Value(*Params, TEXT("Iterations="), options.Iterations);
+		FParse::Value(*Params, TEXT("Seed="), options.Seed);
+		FParse::Value(*Params, TEXT("PixelsToUnits="), options.PixelsToUnits);
+		FParse::Value(*Params, TEXT("ZoneComponent="), options.ZoneComponent);
+		options.bReconcile = FParse::Param(*Params, TEXT("Reconcile"));
+		options.bBatchStaticImages = FParse::Param(*Params, TEXT("BatchStaticImages"));
+
+		options.Depth = FMath::Max(options.Depth, 1);
+		options.Vertices = FMath::Max(options.Vertices, 3);
+		options.Iterations = FMath::Max(options.Iterations, 1);
+		options.PickingQueries = FMath::Max(options.PickingQueries, 1);
+
+		if (!FParse::Value(*Params, TEXT("Report="), options.ReportFile))
+			options.ReportFile = FPaths::ProjectLogDir() / TEXT("LocationGeneratorBenchmark.json");
+		options.ReportFile = FPaths::ConvertRelativePathToFull(options.ReportFile);
+
+		return options;
+	}
+};
+
+#pragma region Synthetic locations
+
+/* The objects of a synthetic location in generation order, ready for FLocationLayout::BuildFromObjects */
+struct FSyntheticLocation
+{
+	TArray<UArticyObject*> Objects;
+	TArray<int32> ParentIndices;
+
+	/* The objects aren't referenced by anything else, so they are rooted as long as the benchmark needs them */
+	void Release()
+	{
+		for (auto object : Objects)
+			object->RemoveFromRoot();
+		Objects.Empty();
+		ParentIndices.Empty();
+	}
+};
+
+/* The objects don't live in a database, but the generator and the layout still need unique ids to tell them apart */
+static void SetSyntheticId(UArticyObject* Object, int32 Index)
+{
+	if (FStructProperty* idProp = FindFProperty<FStructProperty>(UArticyBaseObject::StaticClass(), TEXT("Id")))
+	{
+		FArticyId* id = idProp->ContainerPtrToValuePtr<FArticyId>(Object);
+		id->High = 0x7FFF0000;
+		id->Low = Index + 1;
+	}
+}
+
+/* A star shaped polygon around a center, so it is never self-intersecting */
+static TArray<FVector2D> MakeSyntheticPolygon(FRandomStream& Random, int32 NumVertices, const FVector2D& Center, float Radius)
+{
+	TArray<FVector2D> vertices;
+	vertices.Reserve(NumVertices);
+	for (int32 i = 0; i < NumVertices; ++i)
+	{
+		const float angle = 2 * PI * i / NumVertices;
+		const float radius = Radius * Random.FRandRange(0.6f, 1.0f);
+		vertices.Add(Center + FVector2D(FMath::Cos(angle), FMath::Sin(angle)) * radius);
+	}
+	return vertices;
+}
+
+template<typename TObjectType>
+static TObjectType* CreateSyntheticObject(FRandomStream& Random, int32 Index, int32 NumVertices)
+{
+	TObjectType* object = NewObject<TObjectType>(GetTransientPackage(), NAME_None, RF_Transient);
+	object->AddToRoot();
+	SetSyntheticId(object, Index);
+
+	object->DisplayName = FText::FromString(FString::Printf(TEXT("Synthetic %d"), Index));
+	// the z index increases in creation order, so siblings are already sorted the way the layout expects them
+	object->ZIndex = Index;
+	object->Visibility = EManiacManfredVisibilityModes::Visible;
+	object->Selectability = EManiacManfredSelectabilityModes::Selectable;
+
+	const FVector2D center(Random.FRandRange(0, 4096), Random.FRandRange(0, 4096));
+	object->Vertices = MakeSyntheticPolygon(Random, NumVertices, center, Random.FRandRange(16, 256));
+	object->Transform = NewObject<UArticyTransformation>(object);
+	object->Transform->Translation = center;
+	object->Transform->Scale = FVector2D::UnitVector;
+
+	return object;
+}
+
+/* Builds a random hierarchy of zones and location images in depth first order */
+static FSyntheticLocation BuildSyntheticLocation(const FLocationBenchmarkOptions& Options, int32 NumObjects, TArrayView<const FArticyId> ImageAssets)
+{
+	FSyntheticLocation location;
+	location.Objects.Reserve(NumObjects);
+	location.ParentIndices.Reserve(NumObjects);
+
+	FRandomStream random(Options.Seed);
+
+	// the path from the location down to the last created object, every new object becomes a child of one of them
+	TArray<int32> openParents;
+	for (int32 i = 0; i < NumObjects; ++i)
+	{
+		const int32 level = random.RandRange(0, FMath::Min(openParents.Num(), Options.Depth - 1));
+		openParents.SetNum(level);
+
+		UArticyObject* object;
+		if (random.FRand() < Options.ZoneRatio)
+			object = CreateSyntheticObject<UManiacManfredZone>(random, i, Options.Vertices);
+		else
+		{
+			auto locationImage = CreateSyntheticObject<UManiacManfredLocationImage>(random, i, Options.Vertices);
+			if (ImageAssets.Num() > 0)
+				locationImage->ImageAsset = ImageAssets[i % ImageAssets.Num()];
+			object = locationImage;
+		}
+
+		location.Objects.Add(object);
+		location.ParentIndices.Add(openParents.Num() > 0 ? openParents.Last() : INDEX_NONE);
+		openParents.Add(i);
+	}
+
+	return location;
+}
+
+#pragma endregion
+
+#pragma region Geometry kernels
+
+struct FGeometryBenchmarkResult
+{
+	int32 Vertices = 0;
+	double LegacyBoundsNs = 0;
+	double KernelBoundsNs = 0;
+	double LegacyTransformNs = 0;
+	double KernelTransformNs = 0;
+	double MaxError = 0;
+};
+
+/* FRect::GetBounds as it was before LocationGeometry, the baseline the kernels are timed against.
+*  right and bottom start at 0, so it is only correct for positive coordinates, the results are checked against LocationGeometry::ComputeReferenceBounds instead.
+*/
+static FRect GetLegacyBounds(const TArray<FVector2D>* Vertices)
+{
+	FRect rc = FRect();
+	rc.x = INFINITY;
+	rc.y = INFINITY;
+	rc.w = 0;
+	rc.h = 0;
+
+	float right = 0;
+	float bottom = 0;
+	for (int i = 0; i < Vertices->Num(); ++i)
+	{
+		auto vec = (*Vertices)[i];
+
+		rc.x = FMath::Min(rc.x, vec.X);
+		rc.y = FMath::Min(rc.y, vec.Y);
+
+		right = FMath::Max(right, vec.X);
+		bottom = FMath::Max(bottom, vec.Y);
+	}
+
+	rc.SetXMax(right);
+	rc.SetYMax(bottom);
+
+	return rc;
+}
+
+static double GetMaxError(const FBox2D& A, const FBox2D& B)
+{
+	return FMath::Max(FMath::Max(FMath::Abs(A.Min.X - B.Min.X), FMath::Abs(A.Min.Y - B.Min.Y)), FMath::Max(FMath::Abs(A.Max.X - B.Max.X), FMath::Abs(A.Max.Y - B.Max.Y)));
+}
+
+/* Compares the kernels with what the generator did per object before them: copy the vertices out of the articy object, take their bounds,
+*  scale them into a new array and take the bounds again, all with FRect::GetBounds
+*/
+static FGeometryBenchmarkResult RunGeometryBenchmark(const FLocationLayout& Layout, float PixelsToUnits, int32 Repeats)
+{
+	FGeometryBenchmarkResult result;
+	result.Vertices = Layout.Vertices.Num();
+	if (result.Vertices == 0)
+		return result;
+
+	// the legacy code got every object's vertices as array of its own
+	TArray<TArray<FVector2D>> objectVertices;
+	objectVertices.SetNum(Layout.Num());
+	for (int32 i = 0; i < Layout.Num(); ++i)
+		objectVertices[i] = TArray<FVector2D>(Layout.GetVertices(i));
+
+	const FVector2D pixelScale(1 / PixelsToUnits, 1 / PixelsToUnits);
+	TArray<FVector2D> scaled;
+	scaled.SetNumUninitialized(Layout.Vertices.Num());
+	double sink = 0;
+
+	double startTime = FPlatformTime::Seconds();
+	for (int32 repeat = 0; repeat < Repeats; ++repeat)
+	{
+		for (int32 i = 0; i < Layout.Num(); ++i)
+			sink += GetLegacyBounds(&objectVertices[i]).x;
+	}
+	result.LegacyBoundsNs = (FPlatformTime::Seconds() - startTime) * 1e9 / ((double)Repeats * result.Vertices);
+
+	startTime = FPlatformTime::Seconds();
+	for (int32 repeat = 0; repeat < Repeats; ++repeat)
+	{
+		for (int32 i = 0; i < Layout.Num(); ++i)
+			sink += LocationGeometry::ComputeBounds(Layout.GetVertices(i)).Min.X;
+	}
+	result.KernelBoundsNs = (FPlatformTime::Seconds() - startTime) * 1e9 / ((double)Repeats * result.Vertices);
+
+	startTime = FPlatformTime::Seconds();
+	for (int32 repeat = 0; repeat < Repeats; ++repeat)
+	{
+		for (int32 i = 0; i < Layout.Num(); ++i)
+		{
+			auto vertices = objectVertices[i];
+			FRect bounds = GetLegacyBounds(&vertices);
+			sink += bounds.x;
+
+			TArray<FVector2D> colliderPoints;
+			for (int j = 0; j < vertices.Num(); ++j)
+			{
+				auto vec = vertices[j];
+				colliderPoints.Add(FVector2D(vec.X / PixelsToUnits, vec.Y / PixelsToUnits));
+			}
+
+			sink += GetLegacyBounds(&colliderPoints).x;
+		}
+	}
+	result.LegacyTransformNs = (FPlatformTime::Seconds() - startTime) * 1e9 / ((double)Repeats * result.Vertices);
+
+	startTime = FPlatformTime::Seconds();
+	for (int32 repeat = 0; repeat < Repeats; ++repeat)
+	{
+		for (int32 i = 0; i < Layout.Num(); ++i)
+		{
+			TArrayView<const FVector2D> vertices = Layout.GetVertices(i);
+			FBox2D rawBounds = LocationGeometry::TransformAndComputeBounds(vertices, pixelScale, FVector2D::ZeroVector, TArrayView<FVector2D>(scaled.GetData() + Layout.VertexStarts[i], vertices.Num()));
+			sink += rawBounds.Min.X + LocationGeometry::TransformBounds(rawBounds, pixelScale, FVector2D::ZeroVector).Min.X;
+		}
+	}
+	result.KernelTransformNs = (FPlatformTime::Seconds() - startTime) * 1e9 / ((double)Repeats * result.Vertices);
+
+	// the kernels have to give the correct bounds, which the legacy loop doesn't for negative coordinates
+	for (int32 i = 0; i < Layout.Num(); ++i)
+	{
+		TArrayView<const FVector2D> vertices = Layout.GetVertices(i);
+		if (vertices.Num() == 0)
+			continue;
+
+		result.MaxError = FMath::Max(result.MaxError, GetMaxError(LocationGeometry::ComputeReferenceBounds(vertices), LocationGeometry::ComputeBounds(vertices)));
+
+		TArray<FVector2D> referenceScaled;
+		for (const FVector2D& vertex : vertices)
+			referenceScaled.Add(vertex * pixelScale);
+		FBox2D kernelScaled = LocationGeometry::TransformBounds(LocationGeometry::ComputeBounds(vertices), pixelScale, FVector2D::ZeroVector);
+		result.MaxError = FMath::Max(result.MaxError, GetMaxError(LocationGeometry::ComputeReferenceBounds(referenceScaled), kernelScaled));
+	}
+
+	// keeps the compiler from removing the loops
+	UE_LOG(LogTemp, Verbose, TEXT("Geometry benchmark checksum %f"), sink);
+
+	return result;
+}
+
+#pragma endregion
+
+#pragma region Zone picking
+
+struct FPickingBenchmarkResult
+{
+	int32 Zones = 0;
+	int32 Queries = 0;
+	int32 Hits = 0;
+	double BuildMilliseconds = 0;
+	double IndexNs = 0;
+	double LinearNs = 0;
+	int32 Mismatches = 0;
+};
+
+/* Picks random points in random overlapping zones, with the picking index and with a linear scan over all zones */
+static FPickingBenchmarkResult RunPickingBenchmark(const FLocationBenchmarkOptions& Options, int32 NumZones)
+{
+	FPickingBenchmarkResult result;
+	result.Zones = NumZones;
+	result.Queries = Options.PickingQueries;
+
+	// the area grows with the number of zones, so the number of zones overlapping at a point stays the same
+	FRandomStream random(Options.Seed);
+	const float size = 512 * FMath::Sqrt((float)NumZones);
+
+	FLocationPickingIndex index;
+	for (int32 i = 0; i < NumZones; ++i)
+	{
+		const FVector2D center(random.FRandRange(0, size), random.FRandRange(0, size));
+		index.AddPolygon(i, random.FRand(), MakeSyntheticPolygon(random, Options.Vertices, center, random.FRandRange(16, 256)));
+	}
+
+	double startTime = FPlatformTime::Seconds();
+	index.Build();
+	result.BuildMilliseconds = (FPlatformTime::Seconds() - startTime) * 1000;
+
+	TArray<FVector2D> points;
+	points.SetNumUninitialized(result.Queries);
+	for (FVector2D& point : points)
+		point = FVector2D(random.FRandRange(0, size), random.FRandRange(0, size));
+
+	TArray<int32> indexResults;
+	indexResults.SetNumUninitialized(result.Queries);
+	startTime = FPlatformTime::Seconds();
+	for (int32 i = 0; i < result.Queries; ++i)
+		indexResults[i] = index.FindTopmostAt(points[i]);
+	result.IndexNs = (FPlatformTime::Seconds() - startTime) * 1e9 / result.Queries;
+
+	// the linear scan gets slow for many zones, so it only checks a part of the queries
+	const int32 linearQueries = FMath::Min(result.Queries, 10000);
+	TArray<int32> linearResults;
+	linearResults.SetNumUninitialized(linearQueries);
+	startTime = FPlatformTime::Seconds();
+	for (int32 i = 0; i < linearQueries; ++i)
+		linearResults[i] = index.FindTopmostAtLinear(points[i]);
+	result.LinearNs = (FPlatformTime::Seconds() - startTime) * 1e9 / linearQueries;
+
+	for (int32 i = 0; i < result.Queries; ++i)
+	{
+		result.Hits += indexResults[i] != INDEX_NONE ? 1 : 0;
+		if (i < linearQueries && indexResults[i] != linearResults[i])
+			++result.Mismatches;
+	}
+
+	return result;
+}
+
+#pragma endregion
+
+/* The measurements of a single GenerateLocation call */
+struct FLocationBenchmarkRun
+{
+	int32 Objects = 0;
+	int32 Iteration = 0;
+	int32 Actors = 0;
+	double TotalSeconds = 0;
+	int64 UsedMemoryDelta = 0;
+	uint64 PeakUsedMemory = 0;
+	FLocationGeneratorStats Stats;
+
+	TSharedRef<FJsonObject> ToJson() const
+	{
+		auto json = MakeShared<FJsonObject>();
+		json->SetNumberField(TEXT("objects"), Objects);
+		json->SetNumberField(TEXT("iteration"), Iteration);
+		json->SetNumberField(TEXT("actors"), Actors);
+		json->SetNumberField(TEXT("totalSeconds"), TotalSeconds);
+		json->SetNumberField(TEXT("usedMemoryDelta"), (double)UsedMemoryDelta);
+		json->SetNumberField(TEXT("peakUsedMemory"), (double)PeakUsedMemory);
+
+		auto phases = MakeShared<FJsonObject>();
+		for (int32 i = 0; i < (int32)ELocationGeneratorPhase::Num; ++i)
+		{
+			const FLocationGeneratorPhaseStats& phaseStats = Stats.Phases[i];
+			auto phase = MakeShared<FJsonObject>();
+			phase->SetNumberField(TEXT("seconds"), phaseStats.Seconds);
+			phase->SetNumberField(TEXT("scopes"), phaseStats.Scopes);
+			phase->SetNumberField(TEXT("objectCountDelta"), phaseStats.ObjectCountDelta);
+			phase->SetNumberField(TEXT("usedMemoryDelta"), (double)phaseStats.UsedMemoryDelta);
+			phase->SetNumberField(TEXT("peakUsedMemory"), (double)phaseStats.PeakUsedMemory);
+			phase->SetNumberField(TEXT("allocations"), (double)phaseStats.Allocations);
+			phases->SetObjectField(FLocationGeneratorStats::GetPhaseName((ELocationGeneratorPhase)i), phase);
+		}
+		json->SetObjectField(TEXT("phases"), phases);
+
+		return json;
+	}
+};
+
+static int32 CountOwnedActors(AActor* Actor)
+{
+	int32 count = Actor->Children.Num();
+	for (auto child : Actor->Children)
+		count += CountOwnedActors(child);
+	return count;
+}
+
+ULocationGeneratorBenchmarkCommandlet::ULocationGeneratorBenchmarkCommandlet()
+{
+	IsClient = false;
+	IsServer = false;
+	IsEditor = true;
+	LogToConsole = true;
+	ShowErrorCount = true;
+}
+
+int32 ULocationGeneratorBenchmarkCommandlet::Main(const FString& Params)
+{
+#if WITH_EDITOR
+
+	FLocationBenchmarkOptions options = FLocationBenchmarkOptions::Parse(Params);
+
+	// the location images use the real image assets of the project, so the sprite phase has something to load
+	TArray<FArticyId> imageAssets;
+	if (UArticyDatabase* database = UArticyDatabase::GetMutableOriginal())
+	{
+		for (auto object : database->GetObjectsOfClass(UArticyAsset::StaticClass()))
+		{
+			auto asset = Cast<UArticyAsset>(object);
+			if (asset && asset->Category == EArticyAssetCategory::Image)
+				imageAssets.Add(asset->GetId());
+		}
+	}
+	if (imageAssets.Num() == 0)
+		UE_LOG(LogTemp, Warning, TEXT("There are no image assets in the articy database, the sprite phase won't load anything."));
+
+	// zones only get a collider if their component is a ClickableZone, like in the real locations
+	TMap<TSubclassOf<class UArticyBaseObject>, TSubclassOf<class UActorComponent>> objectComponentMap;
+	if (UClass* zoneComponent = LoadClass<UActorComponent>(nullptr, *options.ZoneComponent))
+		objectComponentMap.Add(UManiacManfredZone::StaticClass(), zoneComponent);
+	else
+		UE_LOG(LogTemp, Warning, TEXT("Could not load the zone component %s, the collider phase will be skipped."), *options.ZoneComponent);
+
+	TArray<FLocationBenchmarkRun> runs;
+	TArray<FGeometryBenchmarkResult> geometryResults;
+	TArray<FPickingBenchmarkResult> pickingResults;
+
+	for (int32 zoneCount : options.PickingZoneCounts)
+		pickingResults.Add(RunPickingBenchmark(options, zoneCount));
+
+	for (int32 objectCount : options.ObjectCounts)
+	{
+		FSyntheticLocation location = BuildSyntheticLocation(options, objectCount, imageAssets);
+
+		{
+			FLocationLayout layout;
+			layout.BuildFromObjects(location.Objects, location.ParentIndices);
+			geometryResults.Add(RunGeometryBenchmark(layout, options.PixelsToUnits, FMath::Max(1, 1000000 / FMath::Max(layout.Vertices.Num(), 1))));
+		}
+
+		// every size is generated into its own empty world
+		UWorld* world = UWorld::CreateWorld(EWorldType::Editor, false, TEXT("LocationGeneratorBenchmark"));
+		FWorldContext& worldContext = GEngine->CreateNewWorldContext(EWorldType::Editor);
+		worldContext.SetCurrentWorld(world);
+		AActor* generatorActor = world->SpawnActor<AActor>();
+
+		for (int32 iteration = 0; iteration < options.Iterations; ++iteration)
+		{
+			FLocationBenchmarkRun& run = runs.AddDefaulted_GetRef();
+			run.Objects = objectCount;
+			run.Iteration = iteration;
+
+			FLocationGeneratorSettings settings;
+			settings.bReconcileExistingActors = options.bReconcile;
+			settings.bBatchStaticImages = options.bBatchStaticImages;
+			settings.Stats = &run.Stats;
+
+			const FPlatformMemoryStats memoryBefore = FPlatformMemory::GetStats();
+			const double startTime = FPlatformTime::Seconds();
+
+			FLocationLayout layout;
+			{
+				LOCATION_GENERATOR_PHASE_SCOPE(&run.Stats, Layout);
+				layout.BuildFromObjects(location.Objects, location.ParentIndices);
+			}
+
+			UManiacManfredLocationImage* backgroundLayer = nullptr;
+			ULocationGenerator::GenerateLocationFromLayout(MoveTemp(layout), TEXT("SyntheticLocation"), options.PixelsToUnits, objectComponentMap, settings, generatorActor, backgroundLayer);
+
+			run.TotalSeconds = FPlatformTime::Seconds() - startTime;
+			const FPlatformMemoryStats memoryAfter = FPlatformMemory::GetStats();
+			run.UsedMemoryDelta = (int64)memoryAfter.UsedPhysical - (int64)memoryBefore.UsedPhysical;
+			run.PeakUsedMemory = memoryAfter.PeakUsedPhysical;
+			run.Actors = CountOwnedActors(generatorActor);
+		}
+
+		GEngine->DestroyWorldContext(world);
+		world->DestroyWorld(false);
+		location.Release();
+		CollectGarbage(GARBAGE_COLLECTION_KEEPFLAGS);
+	}
+
+	// log and write the report
+	auto json = MakeShared<FJsonObject>();
+	json->SetNumberField(TEXT("depth"), options.Depth);
+	json->SetNumberField(TEXT("vertices"), options.Vertices);
+	json->SetNumberField(TEXT("zoneRatio"), options.ZoneRatio);
+	json->SetBoolField(TEXT("reconcile"), options.bReconcile);
+	json->SetBoolField(TEXT("batchStaticImages"), options.bBatchStaticImages);
+	json->SetNumberField(TEXT("seed"), options.Seed);
+
+	TArray<TSharedPtr<FJsonValue>> runValues;
+	for (auto& run : runs)
+	{
+		UE_LOG(LogTemp, Display, TEXT("%6d objects  run %d  total %.3fs | %d actors  memory %+lld KB  peak %llu MB"),
+			run.Objects, run.Iteration, run.TotalSeconds, run.Actors, run.UsedMemoryDelta / 1024, run.PeakUsedMemory / (1024 * 1024));
+
+		// one row per phase, phases without a scope in this run are left out
+		for (int32 i = 0; i < (int32)ELocationGeneratorPhase::Num; ++i)
+		{
+			const FLocationGeneratorPhaseStats& phaseStats = run.Stats.Phases[i];
+			if (phaseStats.Scopes == 0)
+				continue;
+
+			UE_LOG(LogTemp, Display, TEXT("    %-9s %8.3fs  %7d scopes  %+7d objects  %10llu allocations  memory %+8lld KB  peak %6llu MB"),
+				FLocationGeneratorStats::GetPhaseName((ELocationGeneratorPhase)i), phaseStats.Seconds, phaseStats.Scopes, phaseStats.ObjectCountDelta,
+				phaseStats.Allocations, phaseStats.UsedMemoryDelta / 1024, phaseStats.PeakUsedMemory / (1024 * 1024));
+		}
+
+		runValues.Add(MakeShared<FJsonValueObject>(run.ToJson()));
+	}
+	json->SetArrayField(TEXT("runs"), runValues);
+
+	TArray<TSharedPtr<FJsonValue>> geometryValues;
+	for (int32 i = 0; i < geometryResults.Num(); ++i)
+	{
+		const FGeometryBenchmarkResult& result = geometryResults[i];
+		UE_LOG(LogTemp, Display, TEXT("%6d objects  %7d vertices | bounds FRect %.2fns kernel %.2fns per vertex | bounds + scale FRect %.2fns kernel %.2fns per vertex | max error %g"),
+			options.ObjectCounts[i], result.Vertices, result.LegacyBoundsNs, result.KernelBoundsNs, result.LegacyTransformNs, result.KernelTransformNs, result.MaxError);
+
+		auto geometry = MakeShared<FJsonObject>();
+		geometry->SetNumberField(TEXT("objects"), options.ObjectCounts[i]);
+		geometry->SetNumberField(TEXT("vertices"), result.Vertices);
+		geometry->SetNumberField(TEXT("legacyBoundsNsPerVertex"), result.LegacyBoundsNs);
+		geometry->SetNumberField(TEXT("kernelBoundsNsPerVertex"), result.KernelBoundsNs);
+		geometry->SetNumberField(TEXT("legacyTransformNsPerVertex"), result.LegacyTransformNs);
+		geometry->SetNumberField(TEXT("kernelTransformNsPerVertex"), result.KernelTransformNs);
+		geometry->SetNumberField(TEXT("maxError"), result.MaxError);
+		geometryValues.Add(MakeShared<FJsonValueObject>(geometry));
+	}
+	json->SetArrayField(TEXT("geometry"), geometryValues);
+
+	TArray<TSharedPtr<FJsonValue>> pickingValues;
+	for (auto& result : pickingResults)
+	{
+		UE_LOG(LogTemp, Display, TEXT("%6d zones  build %.2fms | index %.0fns linear %.0fns per query | %d of %d queries hit a zone, %d mismatches"),
+			result.Zones, result.BuildMilliseconds, result.IndexNs, result.LinearNs, result.Hits, result.Queries, result.Mismatches);
+
+		auto picking = MakeShared<FJsonObject>();
+		picking->SetNumberField(TEXT("zones"), result.Zones);
+		picking->SetNumberField(TEXT("queries"), result.Queries);
+		picking->SetNumberField(TEXT("hits"), result.Hits);
+		picking->SetNumberField(TEXT("buildMilliseconds"), result.BuildMilliseconds);
+		picking->SetNumberField(TEXT("indexNsPerQuery"), result.IndexNs);
+		picking->SetNumberField(TEXT("linearNsPerQuery"), result.LinearNs);
+		picking->SetNumberField(TEXT("mismatches"), result.Mismatches);
+		pickingValues.Add(MakeShared<FJsonValueObject>(picking));
+	}
+	json->SetArrayField(TEXT("picking"), pickingValues);
+
+	FString content;
+	FJsonSerializer::Serialize(json, TJsonWriterFactory<>::Create(&content));
+	FFileHelper::SaveStringToFile(content, *options.ReportFile);
+	UE_LOG(LogTemp, Display, TEXT("Report written to %s"), *options.ReportFile);
+
+	// the kernels returning different bounds than the reference loop is a regression
+	for (auto& result : geometryResults)
+	{
+		if (result.MaxError > KINDA_SMALL_NUMBER)
+		{
+			UE_LOG(LogTemp, Error, TEXT("The LocationGeometry kernels differ from the reference bounds by %g."), result.MaxError);
+			return 1;
+		}
+	}
+
+	for (auto& result : pickingResults)
+	{
+		if (result.Mismatches > 0)
+		{
+			UE_LOG(LogTemp, Error, TEXT("The picking index and the linear scan picked different zones in %d queries."), result.Mismatches);
+			return 1;
+		}
+	}
+
+	return 0;
+
+#else
+	return 1;
+#endif // WITH_EDITOR
+}
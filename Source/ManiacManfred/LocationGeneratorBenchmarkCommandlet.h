@@ -0,0 +1,38 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Commandlets/Commandlet.h"
+#include "LocationGeneratorBenchmarkCommandlet.generated.h"
+
+/* Measures how the LocationGenerator and the zone picking scale, using synthetic locations that are built in memory instead of being read from the articy database.
+*
+*  UnrealEditor-Cmd ManiacManfred.uproject -run=LocationGeneratorBenchmark -nullrhi -unattended [options]
+*
+*  -Objects=100+1000+10000   the location sizes to measure, every size is a separate run
+*  -Depth=3                  how deep the object hierarchy below the location gets
+*  -Vertices=8               vertices per zone and image polygon
+*  -ZoneRatio=0.5            how many of the objects are zones, the rest are location images
+*  -Iterations=3             how often every size is generated into the same actor, every run after the first one also has to clear the previous one
+*  -Reconcile                generate with the reconcile mode, so every run after the first one only matches the existing actors
+*  -BatchStaticImages        draw the location images with grouped sprite components instead of one actor each
+*  -PickingZones=1000+10000  zone counts for the picking benchmark, which compares FLocationPickingIndex with a linear scan over all zones
+*  -PickingQueries=100000    random points picked per zone count
+*  -Seed=1                   seed for the random hierarchy and polygons
+*  -Report=<file>            where the json report is written, default is Saved/Logs/LocationGeneratorBenchmark.json
+*
+*  Besides the generator phases, it also times the LocationGeometry kernels against the FRect::GetBounds loops and per object arrays the generator used before them.
+*  The phase rows show the time, UObjects, heap allocations and memory of every phase, for the size and call stacks of single allocations run it with -trace=memory and open the trace in Unreal Insights.
+*/
+UCLASS()
+class MANIACMANFRED_API ULocationGeneratorBenchmarkCommandlet : public UCommandlet
+{
+	GENERATED_BODY()
+
+public:
+
+	ULocationGeneratorBenchmarkCommandlet();
+
+	virtual int32 Main(const FString& Params) override;
+};
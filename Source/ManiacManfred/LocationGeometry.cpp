@@ -0,0 +1,406 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#include "LocationGeometry.h"
+#include "Math/VectorRegister.h"
+
+namespace LocationGeometry
+{
+	/* Bounds and optional transform in one loop, FVector2D is made of doubles so every register holds two vertices */
+	template<bool bTransform>
+	FORCEINLINE FBox2D ProcessVertices(const FVector2D* RESTRICT Vertices, int32 Num, const FVector2D& Scale, const FVector2D& Offset, FVector2D* RESTRICT OutVertices)
+	{
+		if (Num == 0)
+			return FBox2D(ForceInit);
+
+		VectorRegister4Double minimum = MakeVectorRegisterDouble(Vertices[0].X, Vertices[0].Y, Vertices[0].X, Vertices[0].Y);
+		VectorRegister4Double maximum = minimum;
+		const VectorRegister4Double scale = MakeVectorRegisterDouble(Scale.X, Scale.Y, Scale.X, Scale.Y);
+		const VectorRegister4Double offset = MakeVectorRegisterDouble(Offset.X, Offset.Y, Offset.X, Offset.Y);
+
+		int32 i = 0;
+		for (; i + 1 < Num; i += 2)
+		{
+			const VectorRegister4Double pair = VectorLoad(&Vertices[i].X);
+			minimum = VectorMin(minimum, pair);
+			maximum = VectorMax(maximum, pair);
+
+			if (bTransform)
+				VectorStore(VectorMultiplyAdd(pair, scale, offset), &OutVertices[i].X);
+		}
+
+		// fold the two vertex lanes into one
+		double minLanes[4];
+		double maxLanes[4];
+		VectorStore(minimum, minLanes);
+		VectorStore(maximum, maxLanes);
+		FBox2D bounds(FVector2D(FMath::Min(minLanes[0], minLanes[2]), FMath::Min(minLanes[1], minLanes[3])),
+			FVector2D(FMath::Max(maxLanes[0], maxLanes[2]), FMath::Max(maxLanes[1], maxLanes[3])));
+
+		// odd vertex count, the last one is done scalar
+		if (i < Num)
+		{
+			bounds += Vertices[i];
+			if (bTransform)
+				OutVertices[i] = Vertices[i] * Scale + Offset;
+		}
+
+		return bounds;
+	}
+
+	FBox2D ComputeBounds(TArrayView<const FVector2D> Vertices)
+	{
+		return ProcessVertices<false>(Vertices.GetData(), Vertices.Num(), FVector2D::UnitVector, FVector2D::ZeroVector, nullptr);
+	}
+
+	FBox2D ComputeReferenceBounds(TArrayView<const FVector2D> Vertices)
+	{
+		FBox2D bounds(ForceInit);
+		for (const FVector2D& vertex : Vertices)
+			bounds += vertex;
+		return bounds;
+	}
+
+	FBox2D TransformAndComputeBounds(TArrayView<const FVector2D> Vertices, const FVector2D& Scale, const FVector2D& Offset, TArrayView<FVector2D> OutVertices)
+	{
+		check(OutVertices.Num() == Vertices.Num());
+		return ProcessVertices<true>(Vertices.GetData(), Vertices.Num(), Scale, Offset, OutVertices.GetData());
+	}
+
+	FBox2D TransformBounds(const FBox2D& Bounds, const FVector2D& Scale, const FVector2D& Offset)
+	{
+		if (!Bounds.bIsValid)
+			return Bounds;
+
+		// a negative scale (like the y-flip) swaps minimum and maximum
+		const FVector2D a = Bounds.Min * Scale + Offset;
+		const FVector2D b = Bounds.Max * Scale + Offset;
+		return FBox2D(FVector2D(FMath::Min(a.X, b.X), FMath::Min(a.Y, b.Y)), FVector2D(FMath::Max(a.X, b.X), FMath::Max(a.Y, b.Y)));
+	}
+
+	/* Positive if A, B, C turn counter clockwise, negative if they turn clockwise and zero if they are collinear */
+	FORCEINLINE double Cross(const FVector2D& A, const FVector2D& B, const FVector2D& C)
+	{
+		return (B - A) ^ (C - A);
+	}
+
+	static double DistanceToSegmentSquared(const FVector2D& Point, const FVector2D& A, const FVector2D& B)
+	{
+		const FVector2D segment = B - A;
+		const double lengthSquared = segment.SizeSquared();
+		const double t = lengthSquared > 0 ? FMath::Clamp(((Point - A) | segment) / lengthSquared, 0.0, 1.0) : 0.0;
+		return FVector2D::DistSquared(Point, A + segment * t);
+	}
+
+	/* Returns the vertex between First and Last (indices may run past the end and wrap around) that is farthest away from the segment between them */
+	static int32 FindFarthestVertex(TArrayView<const FVector2D> Vertices, int32 First, int32 Last, double& OutDistanceSquared)
+	{
+		const int32 num = Vertices.Num();
+		int32 farthest = INDEX_NONE;
+		OutDistanceSquared = -1;
+		for (int32 i = First + 1; i < Last; ++i)
+		{
+			const double distanceSquared = DistanceToSegmentSquared(Vertices[i % num], Vertices[First % num], Vertices[Last % num]);
+			if (distanceSquared > OutDistanceSquared)
+			{
+				OutDistanceSquared = distanceSquared;
+				farthest = i;
+			}
+		}
+		return farthest;
+	}
+
+	void SimplifyPolygon(TArrayView<const FVector2D> Vertices, double Tolerance, TArray<FVector2D>& OutVertices)
+	{
+		const int32 num = Vertices.Num();
+		OutVertices.Reset();
+		if (num <= 3)
+		{
+			OutVertices.Append(Vertices.GetData(), num);
+			return;
+		}
+
+		// a closed polygon has no end points, so we split it at the first vertex and the vertex farthest away from it
+		int32 split = 1;
+		for (int32 i = 2; i < num; ++i)
+		{
+			if (FVector2D::DistSquared(Vertices[0], Vertices[i]) > FVector2D::DistSquared(Vertices[0], Vertices[split]))
+				split = i;
+		}
+
+		TArray<bool, TInlineAllocator<64>> keep;
+		keep.SetNumZeroed(num);
+		keep[0] = true;
+		keep[split] = true;
+
+		// both halves of the outline, the second one wraps around to the first vertex
+		TArray<TPair<int32, int32>, TInlineAllocator<32>> ranges;
+		ranges.Add(TPair<int32, int32>(0, split));
+		ranges.Add(TPair<int32, int32>(split, num));
+
+		const double toleranceSquared = Tolerance * Tolerance;
+		while (ranges.Num() > 0)
+		{
+			const TPair<int32, int32> range = ranges.Pop();
+			double distanceSquared;
+			const int32 farthest = FindFarthestVertex(Vertices, range.Key, range.Value, distanceSquared);
+			if (farthest != INDEX_NONE && distanceSquared > toleranceSquared)
+			{
+				keep[farthest % num] = true;
+				ranges.Add(TPair<int32, int32>(range.Key, farthest));
+				ranges.Add(TPair<int32, int32>(farthest, range.Value));
+			}
+		}
+
+		// everything collapsed onto the split line, so we keep the vertex that spans the most area
+		int32 keptCount = 0;
+		for (bool bKeep : keep)
+			keptCount += bKeep ? 1 : 0;
+		if (keptCount < 3)
+		{
+			double firstDistanceSquared;
+			double secondDistanceSquared;
+			const int32 first = FindFarthestVertex(Vertices, 0, split, firstDistanceSquared);
+			const int32 second = FindFarthestVertex(Vertices, split, num, secondDistanceSquared);
+			const int32 farthest = firstDistanceSquared >= secondDistanceSquared ? first : second;
+			if (farthest != INDEX_NONE)
+				keep[farthest % num] = true;
+		}
+
+		for (int32 i = 0; i < num; ++i)
+		{
+			if (keep[i])
+				OutVertices.Add(Vertices[i]);
+		}
+	}
+
+	/* Tolerance for collinear vertices, relative to the size of the polygon */
+	static double GetCollinearEpsilon(TArrayView<const FVector2D> Vertices)
+	{
+		const FBox2D bounds = ComputeBounds(Vertices);
+		return bounds.bIsValid ? UE_DOUBLE_SMALL_NUMBER * FMath::Max(1.0, bounds.GetSize().SizeSquared()) : UE_DOUBLE_SMALL_NUMBER;
+	}
+
+	/* All turns have to go the same way and add up to exactly one full turn,
+	*  otherwise the outline winds around more than once and intersects itself, like a pentagram
+	*/
+	static bool IsConvex(TArrayView<const FVector2D> Vertices, double Epsilon)
+	{
+		const int32 num = Vertices.Num();
+		if (num < 3)
+			return false;
+
+		int32 sign = 0;
+		double turning = 0;
+		for (int32 i = 0; i < num; ++i)
+		{
+			const FVector2D& previous = Vertices[(i + num - 1) % num];
+			const FVector2D& vertex = Vertices[i];
+			const FVector2D& next = Vertices[(i + 1) % num];
+
+			const double cross = Cross(previous, vertex, next);
+			turning += FMath::Atan2(cross, (vertex - previous) | (next - vertex));
+			if (FMath::Abs(cross) <= Epsilon)
+				continue;
+
+			const int32 turn = cross > 0 ? 1 : -1;
+			if (sign != 0 && turn != sign)
+				return false;
+			sign = turn;
+		}
+		return FMath::IsNearlyEqual(FMath::Abs(turning), UE_DOUBLE_TWO_PI, UE_KINDA_SMALL_NUMBER);
+	}
+
+	bool IsConvex(TArrayView<const FVector2D> Vertices)
+	{
+		return IsConvex(Vertices, GetCollinearEpsilon(Vertices));
+	}
+
+	static bool IsInsideTriangle(const FVector2D& Point, const FVector2D& A, const FVector2D& B, const FVector2D& C)
+	{
+		return Cross(A, B, Point) >= 0 && Cross(B, C, Point) >= 0 && Cross(C, A, Point) >= 0;
+	}
+
+	/* Merges two counter clockwise polygons (as indices into Vertices) if they share an edge and the result is still convex */
+	static bool TryMergeConvex(TArrayView<const FVector2D> Vertices, const TArray<int32>& A, const TArray<int32>& B, double Epsilon, TArray<int32>& OutMerged)
+	{
+		for (int32 i = 0; i < A.Num(); ++i)
+		{
+			const int32 edgeStart = A[i];
+			const int32 edgeEnd = A[(i + 1) % A.Num()];
+
+			// the neighbour runs along the shared edge in the opposite direction
+			const int32 j = B.IndexOfByKey(edgeEnd);
+			if (j == INDEX_NONE || B[(j + 1) % B.Num()] != edgeStart)
+				continue;
+
+			// all of A starting at the end of the shared edge, then the rest of B
+			OutMerged.Reset();
+			for (int32 k = 0; k < A.Num(); ++k)
+				OutMerged.Add(A[(i + 1 + k) % A.Num()]);
+			for (int32 k = 2; k < B.Num(); ++k)
+				OutMerged.Add(B[(j + k) % B.Num()]);
+
+			TArray<FVector2D, TInlineAllocator<32>> mergedVertices;
+			for (int32 index : OutMerged)
+				mergedVertices.Add(Vertices[index]);
+
+			return IsConvex(mergedVertices, Epsilon);
+		}
+
+		return false;
+	}
+
+	bool DecomposeIntoConvexPolygons(TArrayView<const FVector2D> Vertices, TArray<TArray<FVector2D>>& OutPolygons)
+	{
+		OutPolygons.Reset();
+		const int32 num = Vertices.Num();
+		if (num < 3)
+			return false;
+
+		const double epsilon = GetCollinearEpsilon(Vertices);
+		if (IsConvex(Vertices, epsilon))
+		{
+			OutPolygons.Emplace(Vertices.GetData(), num);
+			return true;
+		}
+
+		// we work counter clockwise and flip the results back at the end, if the input was clockwise
+		double signedArea = 0;
+		for (int32 i = 0; i < num; ++i)
+			signedArea += Vertices[i] ^ Vertices[(i + 1) % num];
+		const bool bClockwise = signedArea < 0;
+
+		TArray<int32> ring;
+		ring.Reserve(num);
+		for (int32 i = 0; i < num; ++i)
+			ring.Add(bClockwise ? num - 1 - i : i);
+
+		// ear clipping
+		TArray<TArray<int32>> polygons;
+		while (ring.Num() > 3)
+		{
+			bool bClipped = false;
+			for (int32 k = 0; k < ring.Num() && !bClipped; ++k)
+			{
+				const int32 prev = ring[(k + ring.Num() - 1) % ring.Num()];
+				const int32 current = ring[k];
+				const int32 next = ring[(k + 1) % ring.Num()];
+				const double cross = Cross(Vertices[prev], Vertices[current], Vertices[next]);
+
+				// collinear vertices don't add any area, we can just drop them
+				if (FMath::Abs(cross) <= epsilon)
+				{
+					ring.RemoveAt(k);
+					bClipped = true;
+					continue;
+				}
+
+				// reflex vertex
+				if (cross < 0)
+					continue;
+
+				bool bEar = true;
+				for (int32 other : ring)
+				{
+					if (other == prev || other == current || other == next)
+						continue;
+					const FVector2D& point = Vertices[other];
+					if (point.Equals(Vertices[prev]) || point.Equals(Vertices[current]) || point.Equals(Vertices[next]))
+						continue;
+					if (IsInsideTriangle(point, Vertices[prev], Vertices[current], Vertices[next]))
+					{
+						bEar = false;
+						break;
+					}
+				}
+
+				if (bEar)
+				{
+					polygons.Add({ prev, current, next });
+					ring.RemoveAt(k);
+					bClipped = true;
+				}
+			}
+
+			// no ear left means the polygon intersects itself
+			if (!bClipped)
+				return false;
+		}
+
+		if (ring.Num() == 3 && FMath::Abs(Cross(Vertices[ring[0]], Vertices[ring[1]], Vertices[ring[2]])) > epsilon)
+			polygons.Add(ring);
+
+		// Hertel-Mehlhorn: merge neighbours as long as the result stays convex
+		TArray<int32> merged;
+		for (int32 a = 0; a < polygons.Num(); ++a)
+		{
+			for (int32 b = a + 1; b < polygons.Num();)
+			{
+				if (TryMergeConvex(Vertices, polygons[a], polygons[b], epsilon, merged))
+				{
+					polygons[a] = merged;
+					polygons.RemoveAt(b);
+					b = a + 1;
+				}
+				else
+					++b;
+			}
+		}
+
+		for (const TArray<int32>& polygon : polygons)
+		{
+			TArray<FVector2D>& outPolygon = OutPolygons.AddDefaulted_GetRef();
+			outPolygon.Reserve(polygon.Num());
+			for (int32 i = 0; i < polygon.Num(); ++i)
+				outPolygon.Add(Vertices[polygon[bClockwise ? polygon.Num() - 1 - i : i]]);
+		}
+
+		return OutPolygons.Num() > 0;
+	}
+
+	void ComputeConvexHull(TArrayView<const FVector2D> Points, TArray<FVector2D>& OutHull)
+	{
+		OutHull.Reset();
+
+		TArray<FVector2D, TInlineAllocator<64>> sorted(Points.GetData(), Points.Num());
+		sorted.Sort([](const FVector2D& A, const FVector2D& B) { return A.X < B.X || (A.X == B.X && A.Y < B.Y); });
+		if (sorted.Num() < 3)
+		{
+			OutHull.Append(sorted.GetData(), sorted.Num());
+			return;
+		}
+
+		// lower hull from left to right, then upper hull from right to left
+		OutHull.Reserve(sorted.Num() + 1);
+		for (int32 i = 0; i < sorted.Num(); ++i)
+		{
+			while (OutHull.Num() >= 2 && Cross(OutHull[OutHull.Num() - 2], OutHull.Last(), sorted[i]) <= 0)
+				OutHull.Pop();
+			OutHull.Add(sorted[i]);
+		}
+		const int32 lowerHullSize = OutHull.Num() + 1;
+		for (int32 i = sorted.Num() - 2; i >= 0; --i)
+		{
+			while (OutHull.Num() >= lowerHullSize && Cross(OutHull[OutHull.Num() - 2], OutHull.Last(), sorted[i]) <= 0)
+				OutHull.Pop();
+			OutHull.Add(sorted[i]);
+		}
+
+		// the last point is the first one again
+		OutHull.Pop();
+	}
+
+	bool IsPointInPolygon(const FVector2D& Point, TArrayView<const FVector2D> Polygon)
+	{
+		// count how many polygon edges a horizontal ray from the point crosses
+		bool bInside = false;
+		for (int32 i = 0, j = Polygon.Num() - 1; i < Polygon.Num(); j = i++)
+		{
+			const FVector2D& a = Polygon[i];
+			const FVector2D& b = Polygon[j];
+			if ((a.Y > Point.Y) != (b.Y > Point.Y) && Point.X < (b.X - a.X) * (Point.Y - a.Y) / (b.Y - a.Y) + a.X)
+				bInside = !bInside;
+		}
+		return bInside;
+	}
+}
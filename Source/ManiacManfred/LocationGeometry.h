@@ -0,0 +1,45 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+
+/* Helpers for the vertex data of articy locations.
+*  The bounds and transform functions work on batches of FVector2D and handle two vertices per vector register,
+*  so bounds, pixel scaling and the y-flip between articy and Unreal can be done in a single pass over the vertices.
+*  The polygon functions prepare zone outlines for collision.
+*/
+namespace LocationGeometry
+{
+	/* Returns the bounds of the vertices, which is invalid (bIsValid == false) for an empty array */
+	MANIACMANFRED_API FBox2D ComputeBounds(TArrayView<const FVector2D> Vertices);
+
+	/* The same bounds as ComputeBounds from a plain loop over the vertices, which the kernels are checked against in tests and benchmarks */
+	MANIACMANFRED_API FBox2D ComputeReferenceBounds(TArrayView<const FVector2D> Vertices);
+
+	/* Writes Vertices * Scale + Offset to OutVertices (which needs the same size) and returns the bounds of the original vertices in the same pass */
+	MANIACMANFRED_API FBox2D TransformAndComputeBounds(TArrayView<const FVector2D> Vertices, const FVector2D& Scale, const FVector2D& Offset, TArrayView<FVector2D> OutVertices);
+
+	/* Returns the bounds the vertices would have after applying Vertex * Scale + Offset, without touching the vertices again */
+	MANIACMANFRED_API FBox2D TransformBounds(const FBox2D& Bounds, const FVector2D& Scale, const FVector2D& Offset);
+
+	/* Removes all vertices of a closed polygon that are closer than Tolerance to the simplified outline (Douglas-Peucker).
+	*  The result always keeps at least 3 vertices and the winding of the input.
+	*/
+	MANIACMANFRED_API void SimplifyPolygon(TArrayView<const FVector2D> Vertices, double Tolerance, TArray<FVector2D>& OutVertices);
+
+	/* True for closed polygons of either winding that are convex and don't intersect themselves, collinear vertices are allowed */
+	MANIACMANFRED_API bool IsConvex(TArrayView<const FVector2D> Vertices);
+
+	/* Splits a simple polygon into convex polygons with the same winding, by ear clipping it into triangles
+	*  and merging neighbouring triangles as long as the result stays convex (Hertel-Mehlhorn).
+	*  Returns false if the polygon can't be triangulated, e.g. because it intersects itself.
+	*/
+	MANIACMANFRED_API bool DecomposeIntoConvexPolygons(TArrayView<const FVector2D> Vertices, TArray<TArray<FVector2D>>& OutPolygons);
+
+	/* Writes the convex hull of a point cloud counter clockwise to OutHull (monotone chain) */
+	MANIACMANFRED_API void ComputeConvexHull(TArrayView<const FVector2D> Points, TArray<FVector2D>& OutHull);
+
+	/* Even-odd rule, works for convex and concave polygons of any winding */
+	MANIACMANFRED_API bool IsPointInPolygon(const FVector2D& Point, TArrayView<const FVector2D> Polygon);
+}
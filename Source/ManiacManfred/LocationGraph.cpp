@@ -0,0 +1,244 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#include "LocationGraph.h"
+#include "LocationSpriteCache.h"
+#include "ArticyDatabase.h"
+#include "ArticyGenerated/ManiacManfredArticyTypes.h"
+
+/* Adds the file of an articy asset to a list of asset paths, once */
+static void AddAssetPath(UArticyDatabase& Database, const FArticyId& AssetId, TArray<FSoftObjectPath>& OutPaths)
+{
+	const FSoftObjectPath path = ULocationSpriteCache::GetAssetPath(Cast<UArticyAsset>(Database.GetObject(AssetId)));
+	if (path.IsValid())
+		OutPaths.AddUnique(path);
+}
+
+/* Adds the sound of an object with the Soundfile feature */
+static void AddSoundPath(UArticyDatabase& Database, const UArticyObject* Object, TArray<FSoftObjectPath>& OutPaths)
+{
+	auto objectWithSoundfile = Cast<IManiacManfredObjectWithSoundfileFeature>(Object);
+	const UManiacManfredSoundfileFeature* soundfile = objectWithSoundfile ? objectWithSoundfile->GetFeatureSoundfile() : nullptr;
+	if (soundfile)
+		AddAssetPath(Database, soundfile->Sound, OutPaths);
+}
+
+void FLocationGraph::Build(UArticyDatabase& Database)
+{
+	Reset();
+
+	TArray<UManiacManfredLocation*> locations;
+	for (auto object : Database.GetObjectsOfClass(UManiacManfredLocation::StaticClass()))
+	{
+		auto location = Cast<UManiacManfredLocation>(object);
+		if (!location)
+			continue;
+
+		FLocationGraphNode& node = Nodes.AddDefaulted_GetRef();
+		node.Id = location->GetId();
+		node.Name = location->GetTechnicalName();
+		IndexById.Add(node.Id, Nodes.Num() - 1);
+		IndexByName.Add(node.Name, Nodes.Num() - 1);
+		locations.Add(location);
+	}
+
+	// all nodes have to exist first, the edges of a location may lead to any other one
+	for (int32 i = 0; i < locations.Num(); ++i)
+		CollectLocation(Database, i, locations[i]);
+
+	// the scanned dialogues are only needed while building
+	DialogueTargets.Reset();
+}
+
+void FLocationGraph::Reset()
+{
+	Nodes.Reset();
+	IndexById.Reset();
+	IndexByName.Reset();
+	DialogueTargets.Reset();
+}
+
+int32 FLocationGraph::FindLocation(FName Name) const
+{
+	const int32* index = IndexByName.Find(Name);
+	return index ? *index : INDEX_NONE;
+}
+
+TArray<int32> FLocationGraph::GetLikelyNext(int32 From, int32 MaxDepth) const
+{
+	TArray<int32> result;
+	if (!Nodes.IsValidIndex(From))
+		return result;
+
+	TBitArray<> visited(false, Nodes.Num());
+	visited[From] = true;
+
+	TArray<int32> frontier = { From };
+	TMap<int32, int32> weights;
+	for (int32 depth = 0; depth < MaxDepth && frontier.Num() > 0; ++depth)
+	{
+		// a location reached from several locations of the previous step sums up their weights
+		weights.Reset();
+		for (int32 location : frontier)
+		{
+			for (const FLocationGraphEdge& edge : Nodes[location].Edges)
+			{
+				if (!visited[edge.Target])
+					weights.FindOrAdd(edge.Target) += edge.Weight;
+			}
+		}
+
+		weights.ValueStableSort(TGreater<int32>());
+		frontier.Reset();
+		for (const TPair<int32, int32>& weight : weights)
+		{
+			visited[weight.Key] = true;
+			frontier.Add(weight.Key);
+		}
+
+		result.Append(frontier);
+	}
+
+	return result;
+}
+
+int32 FLocationGraph::NumEdges() const
+{
+	int32 edges = 0;
+	for (const FLocationGraphNode& node : Nodes)
+		edges += node.Edges.Num();
+
+	return edges;
+}
+
+void FLocationGraph::CollectLocation(UArticyDatabase& Database, int32 Index, const UArticyObject* Object)
+{
+	if (auto link = Cast<UManiacManfredLink>(Object))
+		AddReference(Database, Index, link->Target, ELocationGraphEdgeKinds::Link, false);
+
+	if (auto objectWithZoneCondition = Cast<IManiacManfredObjectWithZoneConditionFeature>(Object))
+	{
+		if (const UManiacManfredZoneConditionFeature* zoneCondition = objectWithZoneCondition->GetFeatureZoneCondition())
+		{
+			AddReference(Database, Index, zoneCondition->IfConditionTrue, ELocationGraphEdgeKinds::Zone, false);
+			AddReference(Database, Index, zoneCondition->IfConditionFalse, ELocationGraphEdgeKinds::Zone, false);
+			AddReference(Database, Index, zoneCondition->LinkIfItemValid, ELocationGraphEdgeKinds::Zone, false);
+			AddReference(Database, Index, zoneCondition->LinkIfItemInvalid, ELocationGraphEdgeKinds::Zone, false);
+		}
+	}
+
+	if (auto locationImage = Cast<UManiacManfredLocationImage>(Object))
+		AddAssetPath(Database, locationImage->ImageAsset, Nodes[Index].Assets);
+
+	if (auto objectWithLocationSettings = Cast<IManiacManfredObjectWithLocationSettingsFeature>(Object))
+	{
+		if (const UManiacManfredLocationSettingsFeature* locationSettings = objectWithLocationSettings->GetFeatureLocationSettings())
+		{
+			for (const FArticyId& background : locationSettings->Backgrounds)
+				AddAssetPath(Database, background, Nodes[Index].Assets);
+
+			AddReference(Database, Index, locationSettings->InitialDialog, ELocationGraphEdgeKinds::DialogChoice, true);
+		}
+	}
+
+	AddSoundPath(Database, Object, Nodes[Index].Assets);
+
+	for (const TWeakObjectPtr<UArticyObject>& child : Object->GetChildren())
+	{
+		// a location inside this one is a node of its own
+		if (child.IsValid() && !child->IsA<UManiacManfredLocation>())
+			CollectLocation(Database, Index, child.Get());
+	}
+}
+
+void FLocationGraph::AddReference(UArticyDatabase& Database, int32 From, const FArticyId& TargetId, ELocationGraphEdgeKinds Kind, bool bInitialDialog)
+{
+	const UArticyObject* target = Cast<UArticyObject>(Database.GetObject(TargetId));
+	if (!target)
+		return;
+
+	// links and zones usually point to another location or an object inside of it, e.g. the spot the player appears at
+	for (const UArticyObject* object = target; object; object = object->GetParent())
+	{
+		if (!object->IsA<UManiacManfredLocation>())
+			continue;
+
+		if (const int32* to = IndexById.Find(object->GetId()))
+			AddEdge(From, *to, Kind);
+		return;
+	}
+
+	// anything else starts a dialogue, which is followed as a whole, since the player could pick any of its choices
+	const UArticyObject* dialogue = target;
+	for (const UArticyObject* object = target; object; object = object->GetParent())
+	{
+		if (object->IsA<UManiacManfredDialogue>())
+		{
+			dialogue = object;
+			break;
+		}
+	}
+
+	const FDialogueTargets& dialogueTargets = GetDialogueTargets(Database, dialogue);
+	for (const FArticyId& locationChange : dialogueTargets.LocationChanges)
+	{
+		const UArticyObject* location = Cast<UArticyObject>(Database.GetObject(locationChange));
+		while (location && !location->IsA<UManiacManfredLocation>())
+			location = location->GetParent();
+
+		const int32* to = location ? IndexById.Find(location->GetId()) : nullptr;
+		if (to)
+			AddEdge(From, *to, ELocationGraphEdgeKinds::DialogChoice);
+	}
+
+	// the initial dialog plays right after entering, so its voice lines are needed as early as the images
+	if (bInitialDialog)
+	{
+		for (const FSoftObjectPath& sound : dialogueTargets.Sounds)
+			Nodes[From].Assets.AddUnique(sound);
+	}
+}
+
+void FLocationGraph::AddEdge(int32 From, int32 To, ELocationGraphEdgeKinds Kind)
+{
+	if (From == To)
+		return;
+
+	TArray<FLocationGraphEdge>& edges = Nodes[From].Edges;
+	FLocationGraphEdge* edge = edges.FindByPredicate([To](const FLocationGraphEdge& Edge) { return Edge.Target == To; });
+	if (!edge)
+	{
+		edge = &edges.AddDefaulted_GetRef();
+		edge->Target = To;
+	}
+
+	++edge->Weight;
+	edge->Kinds |= Kind;
+}
+
+const FLocationGraph::FDialogueTargets& FLocationGraph::GetDialogueTargets(UArticyDatabase& Database, const UArticyObject* Dialogue)
+{
+	if (const FDialogueTargets* dialogueTargets = DialogueTargets.Find(Dialogue->GetId()))
+		return *dialogueTargets;
+
+	FDialogueTargets dialogueTargets;
+	TArray<const UArticyObject*> pending = { Dialogue };
+	while (pending.Num() > 0)
+	{
+		const UArticyObject* object = pending.Pop();
+
+		auto objectWithDialogChoice = Cast<IManiacManfredObjectWithDialogChoiceFeature>(object);
+		const UManiacManfredDialogChoiceFeature* dialogChoice = objectWithDialogChoice ? objectWithDialogChoice->GetFeatureDialogChoice() : nullptr;
+		if (dialogChoice && Database.GetObject(dialogChoice->LocationChange))
+			dialogueTargets.LocationChanges.Add(dialogChoice->LocationChange);
+
+		AddSoundPath(Database, object, dialogueTargets.Sounds);
+
+		for (const TWeakObjectPtr<UArticyObject>& child : object->GetChildren())
+		{
+			if (child.IsValid())
+				pending.Add(child.Get());
+		}
+	}
+
+	return DialogueTargets.Add(Dialogue->GetId(), MoveTemp(dialogueTargets));
+}
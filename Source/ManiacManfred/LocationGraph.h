@@ -0,0 +1,90 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "ArticyBaseInclude.h"
+
+class UArticyDatabase;
+class UArticyObject;
+
+/* How the player gets from one location to another */
+enum class ELocationGraphEdgeKinds : uint8
+{
+	None = 0,
+	/* A link object inside the location */
+	Link = 1 << 0,
+	/* A target of the ZoneCondition feature of a zone */
+	Zone = 1 << 1,
+	/* The LocationChange of a DialogChoice in a dialogue the location starts, through its initial dialog or a zone */
+	DialogChoice = 1 << 2,
+};
+ENUM_CLASS_FLAGS(ELocationGraphEdgeKinds);
+
+struct MANIACMANFRED_API FLocationGraphEdge
+{
+	/* Index of the location this edge leads to */
+	int32 Target = INDEX_NONE;
+	/* How many objects of the location lead there, the more the likelier the player goes there next */
+	int32 Weight = 0;
+	ELocationGraphEdgeKinds Kinds = ELocationGraphEdgeKinds::None;
+};
+
+struct MANIACMANFRED_API FLocationGraphNode
+{
+	FArticyId Id;
+	/* The technical name of the location, which is also the name of its map */
+	FName Name;
+	TArray<FLocationGraphEdge> Edges;
+	/* The textures of its images and backgrounds and the sounds of the location and its initial dialog */
+	TArray<FSoftObjectPath> Assets;
+};
+
+/* Which locations the player can reach from which, read from the articy data once.
+*  Links, zone conditions and the dialog choices of the dialogues a location starts are followed, the targets count as part
+*  of the closest location above them in the hierarchy. Conditions aren't evaluated, every location that could be reached is an edge.
+*/
+struct MANIACMANFRED_API FLocationGraph
+{
+public:
+
+	void Build(UArticyDatabase& Database);
+
+	void Reset();
+
+	int32 Num() const { return Nodes.Num(); }
+
+	const FLocationGraphNode& GetNode(int32 Index) const { return Nodes[Index]; }
+
+	/* Returns the index of a location, INDEX_NONE if there is none with this name */
+	int32 FindLocation(FName Name) const;
+
+	/* Returns the locations at most MaxDepth steps away from a location, the closest ones first and ones at the same distance by the weight of their edges */
+	TArray<int32> GetLikelyNext(int32 From, int32 MaxDepth) const;
+
+	int32 NumEdges() const;
+
+private:
+
+	/* Adds the edges and assets of a location by walking its hierarchy */
+	void CollectLocation(UArticyDatabase& Database, int32 Index, const UArticyObject* Object);
+
+	/* Adds an edge to the location an articy object belongs to, or the edges of the dialogue it belongs to */
+	void AddReference(UArticyDatabase& Database, int32 From, const FArticyId& TargetId, ELocationGraphEdgeKinds Kind, bool bInitialDialog);
+
+	void AddEdge(int32 From, int32 To, ELocationGraphEdgeKinds Kind);
+
+	/* What a dialogue leads to, scanned once per dialogue */
+	struct FDialogueTargets
+	{
+		TArray<FArticyId> LocationChanges;
+		TArray<FSoftObjectPath> Sounds;
+	};
+
+	const FDialogueTargets& GetDialogueTargets(UArticyDatabase& Database, const UArticyObject* Dialogue);
+
+	TArray<FLocationGraphNode> Nodes;
+	TMap<FArticyId, int32> IndexById;
+	TMap<FName, int32> IndexByName;
+	TMap<FArticyId, FDialogueTargets> DialogueTargets;
+};
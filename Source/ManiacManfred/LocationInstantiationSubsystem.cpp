@@ -0,0 +1,267 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#include "LocationInstantiationSubsystem.h"
+#include "LocationActorPoolSubsystem.h"
+#include "LocationCookedLayout.h"
+#include "LocationPickingSubsystem.h"
+#include "LocationSpriteCache.h"
+#include "ArticyDatabase.h"
+#include "Engine/AssetManager.h"
+#include "Engine/World.h"
+#include "Paper2DClasses.h"
+
+int32 ULocationInstantiationSubsystem::InstantiateLocation(TSoftObjectPtr<ULocationCookedLayout> CookedLayout, AActor* Owner, float TimeBudgetMilliseconds)
+{
+	if (CookedLayout.IsNull())
+		return INDEX_NONE;
+
+	FInstantiation& instantiation = Instantiations.AddDefaulted_GetRef();
+	instantiation.Handle = NextHandle++;
+	instantiation.CookedLayout = CookedLayout;
+	instantiation.Owner = Owner;
+	instantiation.TimeBudgetSeconds = FMath::Max(TimeBudgetMilliseconds, 0.1f) / 1000.0;
+
+	// the cooked layout and its sprites are a single small package, spawning starts with the first tick after it arrived
+	if (CookedLayout.IsValid())
+		instantiation.LoadedLayout.Reset(CookedLayout.Get());
+	else
+		instantiation.LoadHandle = UAssetManager::GetStreamableManager().RequestAsyncLoad(CookedLayout.ToSoftObjectPath());
+
+	return instantiation.Handle;
+}
+
+bool ULocationInstantiationSubsystem::CancelInstantiation(int32 Handle)
+{
+	const int32 index = Instantiations.IndexOfByPredicate([Handle](const FInstantiation& Instantiation) { return Instantiation.Handle == Handle; });
+	if (index == INDEX_NONE)
+		return false;
+
+	FInstantiation& instantiation = Instantiations[index];
+	if (instantiation.LoadHandle.IsValid())
+		instantiation.LoadHandle->CancelHandle();
+
+	ReleaseSpawnedActors(instantiation);
+	Instantiations.RemoveAt(index);
+	return true;
+}
+
+bool ULocationInstantiationSubsystem::IsInstantiating(int32 Handle) const
+{
+	return Instantiations.ContainsByPredicate([Handle](const FInstantiation& Instantiation) { return Instantiation.Handle == Handle; });
+}
+
+bool ULocationInstantiationSubsystem::ReleaseLocation(int32 Handle)
+{
+	const int32 index = Instantiated.IndexOfByPredicate([Handle](const FInstantiation& Instantiation) { return Instantiation.Handle == Handle; });
+	if (index == INDEX_NONE)
+		return false;
+
+	ReleaseSpawnedActors(Instantiated[index]);
+	Instantiated.RemoveAtSwap(index);
+
+	// the released zones go back to the pool, a pooled actor must not be picked at the place it had in this location
+	if (ULocationPickingSubsystem* picking = GetWorld()->GetSubsystem<ULocationPickingSubsystem>())
+		picking->Rebuild();
+
+	if (const ULocationActorPoolSubsystem* pool = GetWorld()->GetSubsystem<ULocationActorPoolSubsystem>())
+		pool->LogStats();
+
+	return true;
+}
+
+void ULocationInstantiationSubsystem::Tick(float DeltaTime)
+{
+	Super::Tick(DeltaTime);
+
+	// locations are spawned one after another, so the first one is complete as early as possible
+	while (Instantiations.Num() > 0)
+	{
+		FInstantiation& instantiation = Instantiations[0];
+		if (instantiation.LoadHandle.IsValid() && instantiation.LoadHandle->IsLoadingInProgress())
+			return;
+
+		if (!instantiation.LoadedLayout.IsValid())
+			instantiation.LoadedLayout.Reset(instantiation.CookedLayout.Get());
+
+		ULocationCookedLayout* cookedLayout = instantiation.LoadedLayout.Get();
+		if (!cookedLayout)
+		{
+			UE_LOG(LogTemp, Warning, TEXT("Could not load cooked location layout %s."), *instantiation.CookedLayout.ToString());
+			ReleaseSpawnedActors(instantiation);
+			Instantiations.RemoveAt(0);
+			continue;
+		}
+
+		if (!SpawnObjects(instantiation, *cookedLayout, FPlatformTime::Seconds() + instantiation.TimeBudgetSeconds))
+			return;
+
+		const int32 handle = instantiation.Handle;
+		APaperSpriteActor* backgroundLayer = cookedLayout->BackgroundLayer != INDEX_NONE ? Cast<APaperSpriteActor>(instantiation.ObjectActors[cookedLayout->BackgroundLayer].Get()) : nullptr;
+
+		// the actors are kept, so the location can be released again
+		instantiation.LoadHandle.Reset();
+		instantiation.LoadedLayout.Reset();
+		instantiation.BatchComponent.Reset();
+		instantiation.DepthSortedBatchComponent.Reset();
+		Instantiated.Add(MoveTemp(instantiation));
+		Instantiations.RemoveAt(0);
+
+		// the new zones have to be pickable, and reused pool actors have to be picked at their new transform
+		if (ULocationPickingSubsystem* picking = GetWorld()->GetSubsystem<ULocationPickingSubsystem>())
+			picking->Rebuild();
+
+		// only after removing it, the delegate might start or cancel instantiations itself
+		OnLocationInstantiated.Broadcast(handle, cookedLayout, backgroundLayer);
+
+		// every location gets its own time budget, so we stop after finishing one
+		return;
+	}
+}
+
+TStatId ULocationInstantiationSubsystem::GetStatId() const
+{
+	RETURN_QUICK_DECLARE_CYCLE_STAT(ULocationInstantiationSubsystem, STATGROUP_Tickables);
+}
+
+void ULocationInstantiationSubsystem::Deinitialize()
+{
+	for (FInstantiation& instantiation : Instantiations)
+	{
+		if (instantiation.LoadHandle.IsValid())
+			instantiation.LoadHandle->CancelHandle();
+	}
+	Instantiations.Reset();
+	Instantiated.Reset();
+
+	Super::Deinitialize();
+}
+
+bool ULocationInstantiationSubsystem::SpawnObjects(FInstantiation& Instantiation, const ULocationCookedLayout& CookedLayout, double Deadline)
+{
+	Instantiation.ObjectActors.SetNum(CookedLayout.Objects.Num());
+
+	// at least one object per tick, even if the budget is tiny
+	do
+	{
+		if (Instantiation.NextObject >= CookedLayout.Objects.Num())
+			return true;
+
+		const int32 index = Instantiation.NextObject++;
+		if (CookedLayout.Objects[index].bBatched)
+		{
+			AddBatchedObject(Instantiation, CookedLayout, index);
+		}
+		else
+		{
+			// a separately drawn image between batched ones starts a new batch, the same as when generating
+			if (CookedLayout.Objects[index].bImage)
+				Instantiation.BatchComponent.Reset();
+
+			Instantiation.ObjectActors[index] = SpawnObject(Instantiation, CookedLayout, index);
+		}
+	}
+	while (FPlatformTime::Seconds() < Deadline);
+
+	return Instantiation.NextObject >= CookedLayout.Objects.Num();
+}
+
+AActor* ULocationInstantiationSubsystem::SpawnObject(FInstantiation& Instantiation, const ULocationCookedLayout& CookedLayout, int32 Index)
+{
+	const FLocationCookedObject& object = CookedLayout.Objects[Index];
+
+	// batched images have no actor, so their children belong to the closest parent that has one
+	AActor* owner = Instantiation.Owner.Get();
+	for (int32 parent = object.Parent; parent != INDEX_NONE; parent = CookedLayout.Objects[parent].Parent)
+	{
+		if (AActor* parentActor = Instantiation.ObjectActors[parent].Get())
+		{
+			owner = parentActor;
+			break;
+		}
+	}
+
+	ULocationActorPoolSubsystem* pool = GetWorld()->GetSubsystem<ULocationActorPoolSubsystem>();
+	APaperSpriteActor* actor = pool->AcquireActor(object.Components, owner, FTransform(object.Location));
+	if (!actor)
+		return nullptr;
+
+#if WITH_EDITOR
+	actor->SetActorLabel(object.Label.ToString());
+#endif
+
+	UPaperSpriteComponent* renderComponent = actor->GetRenderComponent();
+	renderComponent->SetMobility(EComponentMobility::Stationary);
+
+	// opaque and masked images are depth sorted by their y position, only translucent ones are sorted by their priority
+	if (ULocationSpriteCache::NeedsSortPriority(object.Sprite))
+		renderComponent->SetTranslucentSortPriority(object.SortPriority);
+
+	// the background gets its own copy of the sprite, the same as when generating, so the sprite of the cooked layout stays untouched
+	if (object.Sprite && object.bBackgroundLayer)
+		renderComponent->SetSprite(DuplicateObject<UPaperSprite>(object.Sprite, actor));
+	else if (object.Sprite)
+		renderComponent->SetSprite(object.Sprite);
+
+	if (!object.bCollisionEnabled)
+		renderComponent->SetCollisionEnabled(ECollisionEnabled::NoCollision);
+
+	pool->ActivateActor(actor, Cast<UArticyObject>(UArticyDatabase::Get(this)->GetObject(object.Id)), object.Components);
+	return actor;
+}
+
+void ULocationInstantiationSubsystem::AddBatchedObject(FInstantiation& Instantiation, const ULocationCookedLayout& CookedLayout, int32 Index)
+{
+	const FLocationCookedObject& object = CookedLayout.Objects[Index];
+	if (!object.Sprite)
+		return;
+
+	// the same split as when generating: translucent images keep their order, opaque and masked ones share one component
+	const bool bNeedsSortPriority = ULocationSpriteCache::NeedsSortPriority(object.Sprite);
+	TWeakObjectPtr<UPaperGroupedSpriteComponent>& batchComponentSlot = bNeedsSortPriority ? Instantiation.BatchComponent : Instantiation.DepthSortedBatchComponent;
+
+	UPaperGroupedSpriteComponent* batchComponent = batchComponentSlot.Get();
+	if (!batchComponent)
+	{
+		APaperGroupedSpriteActor* batchActor = Instantiation.BatchActor.Get();
+		if (!batchActor)
+		{
+			FActorSpawnParameters spawnParameters;
+			spawnParameters.Owner = Instantiation.Owner.Get();
+			spawnParameters.SpawnCollisionHandlingOverride = ESpawnActorCollisionHandlingMethod::AlwaysSpawn;
+			batchActor = GetWorld()->SpawnActor<APaperGroupedSpriteActor>(APaperGroupedSpriteActor::StaticClass(), FTransform::Identity, spawnParameters);
+			if (!batchActor)
+				return;
+
+			Instantiation.BatchActor = batchActor;
+			batchComponent = batchActor->GetRenderComponent();
+		}
+		else
+		{
+			batchComponent = NewObject<UPaperGroupedSpriteComponent>(batchActor);
+			batchComponent->SetupAttachment(batchActor->GetRootComponent());
+			batchActor->AddInstanceComponent(batchComponent);
+			batchComponent->RegisterComponent();
+		}
+
+		batchComponent->SetMobility(EComponentMobility::Stationary);
+		batchComponent->SetCollisionEnabled(ECollisionEnabled::NoCollision);
+		if (bNeedsSortPriority)
+			batchComponent->SetTranslucentSortPriority(object.SortPriority);
+		batchComponentSlot = batchComponent;
+	}
+
+	batchComponent->AddInstance(FTransform(object.Location), object.Sprite, true);
+}
+
+void ULocationInstantiationSubsystem::ReleaseSpawnedActors(FInstantiation& Instantiation)
+{
+	// children first, so no pooled actor is still the owner of one that is in use
+	ULocationActorPoolSubsystem* pool = GetWorld()->GetSubsystem<ULocationActorPoolSubsystem>();
+	for (int32 i = Instantiation.ObjectActors.Num() - 1; i >= 0; --i)
+		pool->ReleaseActor(Cast<APaperSpriteActor>(Instantiation.ObjectActors[i].Get()));
+
+	if (Instantiation.BatchActor.IsValid())
+		Instantiation.BatchActor->Destroy();
+
+	Instantiation.ObjectActors.Reset();
+}
@@ -0,0 +1,88 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Subsystems/WorldSubsystem.h"
+#include "Engine/StreamableManager.h"
+#include "UObject/StrongObjectPtr.h"
+#include "LocationInstantiationSubsystem.generated.h"
+
+class ULocationCookedLayout;
+class APaperSpriteActor;
+class APaperGroupedSpriteActor;
+class UPaperGroupedSpriteComponent;
+
+DECLARE_DYNAMIC_MULTICAST_DELEGATE_ThreeParams(FOnLocationInstantiated, int32, Handle, ULocationCookedLayout*, CookedLayout, APaperSpriteActor*, BackgroundLayer);
+
+/* Spawns locations that were baked with ULocationGenerator::BakeLocation into the world at runtime, also in packaged games.
+*  The cooked layout is loaded asynchronously, afterwards its actors are spawned over several frames, never spending more than the time budget per frame.
+*  The actors look the same as the ones the LocationGenerator creates in the editor: sprite actors with an ArticyReference and the components of the ObjectComponentMap.
+*  Sprite actors are taken from the ULocationActorPoolSubsystem, releasing a location that was left gives them back, so the next location can reuse them.
+*/
+UCLASS()
+class MANIACMANFRED_API ULocationInstantiationSubsystem : public UTickableWorldSubsystem
+{
+	GENERATED_BODY()
+
+public:
+
+	/* Starts loading and spawning a location, the returned handle identifies it in OnLocationInstantiated and CancelInstantiation.
+	*  All spawned actors are owned by Owner (like generated actors are owned by the generating actor), Owner may be null.
+	*/
+	UFUNCTION(BlueprintCallable, Category = "Location Instantiation")
+	int32 InstantiateLocation(TSoftObjectPtr<ULocationCookedLayout> CookedLayout, AActor* Owner, float TimeBudgetMilliseconds = 2.0f);
+
+	/* Stops instantiating a location and releases the actors it spawned so far, returns false if the location was already completed */
+	UFUNCTION(BlueprintCallable, Category = "Location Instantiation")
+	bool CancelInstantiation(int32 Handle);
+
+	UFUNCTION(BlueprintCallable, Category = "Location Instantiation")
+	bool IsInstantiating(int32 Handle) const;
+
+	/* Removes a completed location from the world, its sprite actors go back to the actor pool. Returns false if the handle isn't a completed location. */
+	UFUNCTION(BlueprintCallable, Category = "Location Instantiation")
+	bool ReleaseLocation(int32 Handle);
+
+	/* Called once all actors of a location exist, BackgroundLayer is the actor showing the background image if the location has one */
+	UPROPERTY(BlueprintAssignable, Category = "Location Instantiation")
+	FOnLocationInstantiated OnLocationInstantiated;
+
+	virtual void Tick(float DeltaTime) override;
+	virtual TStatId GetStatId() const override;
+	virtual void Deinitialize() override;
+
+private:
+
+	struct FInstantiation
+	{
+		int32 Handle = 0;
+		TSoftObjectPtr<ULocationCookedLayout> CookedLayout;
+		TSharedPtr<FStreamableHandle> LoadHandle;
+		/* Keeps the loaded layout alive while its objects are spawned over several ticks, it might have been loaded before without a handle */
+		TStrongObjectPtr<ULocationCookedLayout> LoadedLayout;
+		TWeakObjectPtr<AActor> Owner;
+		double TimeBudgetSeconds = 0;
+
+		/* The next object to spawn, and the actor of every object spawned so far (null for batched images) */
+		int32 NextObject = 0;
+		TArray<TWeakObjectPtr<AActor>> ObjectActors;
+		TWeakObjectPtr<APaperGroupedSpriteActor> BatchActor;
+		TWeakObjectPtr<UPaperGroupedSpriteComponent> BatchComponent;
+		TWeakObjectPtr<UPaperGroupedSpriteComponent> DepthSortedBatchComponent;
+	};
+
+	/* Spawns objects of an instantiation until it is done or the deadline passed, returns true once all objects exist */
+	bool SpawnObjects(FInstantiation& Instantiation, const ULocationCookedLayout& CookedLayout, double Deadline);
+
+	AActor* SpawnObject(FInstantiation& Instantiation, const ULocationCookedLayout& CookedLayout, int32 Index);
+	void AddBatchedObject(FInstantiation& Instantiation, const ULocationCookedLayout& CookedLayout, int32 Index);
+	void ReleaseSpawnedActors(FInstantiation& Instantiation);
+
+	TArray<FInstantiation> Instantiations;
+
+	/* Completed locations that weren't released yet */
+	TArray<FInstantiation> Instantiated;
+
+	int32 NextHandle = 1;
+};
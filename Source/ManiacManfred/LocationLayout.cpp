@@ -0,0 +1,222 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#include "LocationLayout.h"
+#include "LocationGeometry.h"
+
+/* Reads visibility and selectability of the location object types which have them */
+template<typename TObjectType>
+bool ReadDisplayModes(const UArticyObject* Object, ELocationLayoutFlags& OutFlags)
+{
+	auto typedObject = Cast<TObjectType>(Object);
+	if (!typedObject)
+		return false;
+
+	if (typedObject->Visibility == EManiacManfredVisibilityModes::Visible)
+		OutFlags |= ELocationLayoutFlags::Visible;
+	if (typedObject->Selectability == EManiacManfredSelectabilityModes::Selectable)
+		OutFlags |= ELocationLayoutFlags::Selectable;
+
+	return true;
+}
+
+/* Collects the objects below Parent in generation order */
+void CollectLayoutObjects(const UArticyObject* Parent, int32 ParentIndex, TArray<UArticyObject*>& OutObjects, TArray<int32>& OutParentIndices)
+{
+	TArray<TWeakObjectPtr<UArticyObject>> children = Parent->GetChildren();
+
+	// The children are usually unsorted, but in this case we have to worry about proper ordering regarding depth sorting
+	children.Sort([](const TWeakObjectPtr<UArticyObject>& ObjA, const TWeakObjectPtr<UArticyObject>& ObjB)
+	{
+		auto objWithZIndexA = Cast<IArticyObjectWithZIndex>(ObjA.Get());
+		auto objWithZIndexB = Cast<IArticyObjectWithZIndex>(ObjB.Get());
+		if (!objWithZIndexA || !objWithZIndexB)
+			return false;
+		return objWithZIndexA->GetZIndex() < objWithZIndexB->GetZIndex();
+	});
+
+	for (auto child : children)
+	{
+		if (!child.IsValid())
+			continue;
+
+		int32 index = OutObjects.Add(child.Get());
+		OutParentIndices.Add(ParentIndex);
+		CollectLayoutObjects(child.Get(), index, OutObjects, OutParentIndices);
+	}
+}
+
+void FLocationLayout::Build(const UArticyObject* Location)
+{
+	TArray<UArticyObject*> objects;
+	TArray<int32> parentIndices;
+	CollectLayoutObjects(Location, INDEX_NONE, objects, parentIndices);
+
+	BuildFromObjects(objects, parentIndices);
+}
+
+void FLocationLayout::BuildFromObjects(TArrayView<UArticyObject* const> InObjects, TArrayView<const int32> InParentIndices)
+{
+	check(InObjects.Num() == InParentIndices.Num());
+	Reset();
+
+	ParentIndices.Append(InParentIndices.GetData(), InParentIndices.Num());
+
+	const int32 num = InObjects.Num();
+	Ids.SetNumUninitialized(num);
+	Objects.SetNum(num);
+	ZIndices.SetNumZeroed(num);
+	SortPriorities.SetNumUninitialized(num);
+	Translations.Init(FVector2D::ZeroVector, num);
+	Scales.Init(FVector2D::UnitVector, num);
+	Rotations.SetNumZeroed(num);
+	ShapeTypes.Init(EManiacManfredShapeType::Invalid, num);
+	VertexStarts.SetNumZeroed(num);
+	VertexCounts.SetNumZeroed(num);
+	VertexBounds.Init(FBox2D(ForceInit), num);
+	ImageAssets.SetNum(num);
+	Flags.Init(ELocationLayoutFlags::None, num);
+	IndexById.Reserve(num);
+
+	// we need the size of the shared vertex buffer first, so it is allocated only once
+	int32 vertexCount = 0;
+	for (int32 i = 0; i < num; ++i)
+	{
+		if (auto objectWithVertices = Cast<IArticyObjectWithVertices>(InObjects[i]))
+		{
+			VertexStarts[i] = vertexCount;
+			VertexCounts[i] = objectWithVertices->GetVertices().Num();
+			vertexCount += VertexCounts[i];
+		}
+	}
+	Vertices.SetNumUninitialized(vertexCount);
+
+	float sortPriority = 0;
+	for (int32 i = 0; i < num; ++i)
+	{
+		UArticyObject* object = InObjects[i];
+		ELocationLayoutFlags flags = ELocationLayoutFlags::None;
+
+		Ids[i] = object->GetId();
+		Objects[i] = object;
+		IndexById.Add(Ids[i], i);
+
+		// the same sort priority the generator used to accumulate while walking the hierarchy
+		SortPriorities[i] = sortPriority;
+		sortPriority += 0.2;
+
+		if (auto objectWithZIndex = Cast<IArticyObjectWithZIndex>(object))
+		{
+			flags |= ELocationLayoutFlags::HasZIndex;
+			ZIndices[i] = objectWithZIndex->GetZIndex();
+		}
+
+		auto objectWithTransform = Cast<IArticyObjectWithTransform>(object);
+		if (objectWithTransform && objectWithTransform->GetTransform())
+		{
+			flags |= ELocationLayoutFlags::HasTransform;
+			Translations[i] = objectWithTransform->GetTransform()->Translation;
+			Scales[i] = objectWithTransform->GetTransform()->Scale;
+			Rotations[i] = objectWithTransform->GetTransform()->Rotation;
+		}
+
+		if (auto objectWithVertices = Cast<IArticyObjectWithVertices>(object))
+		{
+			flags |= ELocationLayoutFlags::HasVertices;
+			const TArray<FVector2D>& vertices = objectWithVertices->GetVertices();
+			FMemory::Memcpy(Vertices.GetData() + VertexStarts[i], vertices.GetData(), vertices.Num() * sizeof(FVector2D));
+			VertexBounds[i] = LocationGeometry::ComputeBounds(vertices);
+		}
+
+		if (auto locationImage = Cast<UManiacManfredLocationImage>(object))
+		{
+			flags |= ELocationLayoutFlags::LocationImage;
+			ImageAssets[i] = locationImage->ImageAsset;
+			ShapeTypes[i] = locationImage->ShapeType;
+
+			auto displayName = Cast<IArticyObjectWithDisplayName>(object);
+			if (displayName && displayName->GetDisplayName().ToString() == "Background layer")
+				flags |= ELocationLayoutFlags::BackgroundLayer;
+		}
+		else if (auto zone = Cast<UManiacManfredZone>(object))
+			ShapeTypes[i] = zone->ShapeType;
+		else if (auto locationText = Cast<UManiacManfredLocationText>(object))
+			ShapeTypes[i] = locationText->ShapeType;
+		else if (object->IsA<UManiacManfredPath>())
+			ShapeTypes[i] = EManiacManfredShapeType::Path;
+		else if (object->IsA<UManiacManfredLink>())
+			ShapeTypes[i] = EManiacManfredShapeType::Link;
+		else if (object->IsA<UManiacManfredSpot>())
+			ShapeTypes[i] = EManiacManfredShapeType::Spot;
+
+		// objects that can't be hidden are always visible
+		if (!ReadDisplayModes<UManiacManfredLocationImage>(object, flags)
+			&& !ReadDisplayModes<UManiacManfredZone>(object, flags)
+			&& !ReadDisplayModes<UManiacManfredLocationText>(object, flags)
+			&& !ReadDisplayModes<UManiacManfredPath>(object, flags)
+			&& !ReadDisplayModes<UManiacManfredLink>(object, flags)
+			&& !ReadDisplayModes<UManiacManfredSpot>(object, flags))
+		{
+			flags |= ELocationLayoutFlags::Visible;
+		}
+
+		if (object->IsA<UManiacManfredDisplayCondition>())
+			flags |= ELocationLayoutFlags::DisplayCondition;
+		if (object->IsA<UManiacManfredConditional_Zone>())
+			flags |= ELocationLayoutFlags::ZoneCondition;
+
+		Flags[i] = flags;
+	}
+}
+
+void FLocationLayout::Reset()
+{
+	Ids.Reset();
+	Objects.Reset();
+	ParentIndices.Reset();
+	ZIndices.Reset();
+	SortPriorities.Reset();
+	Translations.Reset();
+	Scales.Reset();
+	Rotations.Reset();
+	ShapeTypes.Reset();
+	VertexStarts.Reset();
+	VertexCounts.Reset();
+	VertexBounds.Reset();
+	ImageAssets.Reset();
+	Flags.Reset();
+	Vertices.Reset();
+	IndexById.Reset();
+}
+
+int32 FLocationLayout::FindIndex(const FArticyId& Id) const
+{
+	const int32* index = IndexById.Find(Id);
+	return index ? *index : INDEX_NONE;
+}
+
+int32 FLocationLayout::FindTopmostAt(const FVector2D& Point, ELocationLayoutFlags RequiredFlags) const
+{
+	const ELocationLayoutFlags required = RequiredFlags | ELocationLayoutFlags::HasVertices | ELocationLayoutFlags::Visible;
+
+	// later objects are drawn on top, so the first hit from the back is the topmost one
+	for (int32 i = Num() - 1; i >= 0; --i)
+	{
+		if (!EnumHasAllFlags(Flags[i], required) || !VertexBounds[i].IsInside(Point))
+			continue;
+
+		if (LocationGeometry::IsPointInPolygon(Point, GetVertices(i)) && IsVisibleInHierarchy(i))
+			return i;
+	}
+
+	return INDEX_NONE;
+}
+
+bool FLocationLayout::IsVisibleInHierarchy(int32 Index) const
+{
+	for (int32 i = Index; i != INDEX_NONE; i = ParentIndices[i])
+	{
+		if (!HasFlags(i, ELocationLayoutFlags::Visible))
+			return false;
+	}
+	return true;
+}
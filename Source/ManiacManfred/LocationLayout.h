@@ -0,0 +1,93 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "ArticyBaseInclude.h"
+#include "ArticyGenerated/ManiacManfredArticyTypes.h"
+
+/* Which articy features an object in a location layout has */
+enum class ELocationLayoutFlags : uint16
+{
+	None = 0,
+	HasVertices = 1 << 0,
+	HasTransform = 1 << 1,
+	HasZIndex = 1 << 2,
+	LocationImage = 1 << 3,
+	BackgroundLayer = 1 << 4,
+	Visible = 1 << 5,
+	Selectable = 1 << 6,
+	DisplayCondition = 1 << 7,
+	ZoneCondition = 1 << 8,
+};
+ENUM_CLASS_FLAGS(ELocationLayoutFlags);
+
+/* A flattened snapshot of an articy location, stored as one array per field instead of one UObject per articy object.
+*  The objects are stored in the order the LocationGenerator creates them (depth first, children sorted by their ZIndex),
+*  so parents always come before their children and higher indices are drawn on top of lower ones.
+*  All vertices share a single buffer, every object only stores its range in it.
+*
+*  Building the snapshot is the only place where we have to cast to the articy interfaces, everything working on it afterwards
+*  (the generator, zone picking, visibility checks) only reads these arrays and doesn't allocate anymore.
+*/
+struct MANIACMANFRED_API FLocationLayout
+{
+public:
+
+	/* Walks the articy hierarchy below the location and fills all arrays */
+	void Build(const UArticyObject* Location);
+
+	/* Fills all arrays from objects that were already collected in generation order, e.g. objects that don't live in an articy database.
+	*  Every parent index has to point to an earlier object or be INDEX_NONE.
+	*/
+	void BuildFromObjects(TArrayView<UArticyObject* const> InObjects, TArrayView<const int32> InParentIndices);
+
+	void Reset();
+
+	int32 Num() const { return Ids.Num(); }
+
+	/* Returns the index of the object with the given id or INDEX_NONE */
+	int32 FindIndex(const FArticyId& Id) const;
+
+	TArrayView<const FVector2D> GetVertices(int32 Index) const
+	{
+		return TArrayView<const FVector2D>(Vertices.GetData() + VertexStarts[Index], VertexCounts[Index]);
+	}
+
+	bool HasFlags(int32 Index, ELocationLayoutFlags InFlags) const
+	{
+		return EnumHasAllFlags(Flags[Index], InFlags);
+	}
+
+	/* Returns the topmost visible object with vertices under a point in articy coordinates, that has all the required flags */
+	int32 FindTopmostAt(const FVector2D& Point, ELocationLayoutFlags RequiredFlags = ELocationLayoutFlags::None) const;
+
+	/* Returns if the object and all of its parents are visible */
+	bool IsVisibleInHierarchy(int32 Index) const;
+
+	TArray<FArticyId> Ids;
+	/* Only needed to create actors or components for the objects, don't use it for queries */
+	TArray<TWeakObjectPtr<UArticyObject>> Objects;
+	/* Index of the parent object, INDEX_NONE for direct children of the location */
+	TArray<int32> ParentIndices;
+	TArray<float> ZIndices;
+	/* The depth sorting value the generator uses for the translucent sort priority and the y position */
+	TArray<float> SortPriorities;
+	TArray<FVector2D> Translations;
+	TArray<FVector2D> Scales;
+	TArray<float> Rotations;
+	TArray<EManiacManfredShapeType> ShapeTypes;
+	TArray<int32> VertexStarts;
+	TArray<int32> VertexCounts;
+	/* Axis aligned bounds of the vertices in articy coordinates */
+	TArray<FBox2D> VertexBounds;
+	TArray<FArticyId> ImageAssets;
+	TArray<ELocationLayoutFlags> Flags;
+
+	/* The vertices of all objects */
+	TArray<FVector2D> Vertices;
+
+private:
+
+	TMap<FArticyId, int32> IndexById;
+};
@@ -0,0 +1,121 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#include "LocationOverdraw.h"
+#include "Algo/Sort.h"
+#include "Misc/FileHelper.h"
+#include "Misc/Paths.h"
+
+float FLocationOverdrawResult::GetAverageOverdraw(bool bWorstCase) const
+{
+	const double screenPixels = (double)Resolution.X * Resolution.Y;
+	return screenPixels > 0 ? (float)((bWorstCase ? WorstCaseShadedPixels : ShadedPixels) / screenPixels) : 0.0f;
+}
+
+/* Adds up the pixels every layer shades, front to back, and the layers shaded on every pixel. Returns the pixels shaded in total. */
+static double Rasterize(TArrayView<const FLocationOverdrawLayer> Layers, TArrayView<const int32> FrontToBack, bool bWorstCase, double Scale, const FVector2D& Offset,
+	const FIntPoint& Resolution, TArray<float>& OutOverdraw, TArray<double>& OutLayerShadedPixels)
+{
+	OutOverdraw.Init(0.0f, Resolution.X * Resolution.Y);
+	OutLayerShadedPixels.Init(0.0, Layers.Num());
+	TBitArray<> occluded(false, Resolution.X * Resolution.Y);
+	double shadedPixels = 0;
+
+	for (int32 layerIndex : FrontToBack)
+	{
+		const FLocationOverdrawLayer& layer = Layers[layerIndex];
+		if ((layer.bConditional && !bWorstCase) || !layer.Rect.bIsValid || layer.Coverage <= 0)
+			continue;
+
+		// every pixel whose center lies inside the rect
+		const FVector2D min = layer.Rect.Min * Scale + Offset;
+		const FVector2D max = layer.Rect.Max * Scale + Offset;
+		const int32 minX = FMath::Clamp(FMath::CeilToInt(min.X - 0.5), 0, Resolution.X);
+		const int32 maxX = FMath::Clamp(FMath::CeilToInt(max.X - 0.5), 0, Resolution.X);
+		const int32 minY = FMath::Clamp(FMath::CeilToInt(min.Y - 0.5), 0, Resolution.Y);
+		const int32 maxY = FMath::Clamp(FMath::CeilToInt(max.Y - 0.5), 0, Resolution.Y);
+
+		double layerPixels = 0;
+		for (int32 y = minY; y < maxY; ++y)
+		{
+			for (int32 x = minX; x < maxX; ++x)
+			{
+				const int32 pixel = y * Resolution.X + x;
+				if (occluded[pixel])
+					continue;
+
+				OutOverdraw[pixel] += layer.Coverage;
+				layerPixels += layer.Coverage;
+
+				if (layer.bOccludes)
+					occluded[pixel] = true;
+			}
+		}
+
+		OutLayerShadedPixels[layerIndex] = layerPixels;
+		shadedPixels += layerPixels;
+	}
+
+	return shadedPixels;
+}
+
+void FLocationOverdraw::Analyze(TArrayView<const FLocationOverdrawLayer> Layers, const FBox2D& ViewRect, const FIntPoint& Resolution, FLocationOverdrawResult& OutResult)
+{
+	OutResult = FLocationOverdrawResult();
+	OutResult.Resolution = Resolution;
+
+	const FVector2D viewSize = ViewRect.bIsValid ? ViewRect.GetSize() : FVector2D::ZeroVector;
+	if (Resolution.X <= 0 || Resolution.Y <= 0 || viewSize.X <= 0 || viewSize.Y <= 0)
+		return;
+
+	// the whole location is visible, centered with bars on the sides that don't fit the aspect ratio
+	const double scale = FMath::Min(Resolution.X / viewSize.X, Resolution.Y / viewSize.Y);
+	const FVector2D offset = (FVector2D(Resolution) - viewSize * scale) * 0.5 - ViewRect.Min * scale;
+
+	// the topmost layer first, so the depth test of occluding layers can reject the ones below
+	TArray<int32> frontToBack;
+	frontToBack.SetNumUninitialized(Layers.Num());
+	for (int32 i = 0; i < Layers.Num(); ++i)
+		frontToBack[i] = i;
+
+	Algo::Sort(frontToBack, [&Layers](int32 A, int32 B)
+	{
+		return Layers[A].Order != Layers[B].Order ? Layers[A].Order > Layers[B].Order : A > B;
+	});
+
+	TArray<float> defaultOverdraw;
+	TArray<double> defaultLayerShadedPixels;
+	OutResult.ShadedPixels = Rasterize(Layers, frontToBack, false, scale, offset, Resolution, defaultOverdraw, defaultLayerShadedPixels);
+	OutResult.WorstCaseShadedPixels = Rasterize(Layers, frontToBack, true, scale, offset, Resolution, OutResult.Overdraw, OutResult.LayerShadedPixels);
+
+	for (float overdraw : OutResult.Overdraw)
+		OutResult.MaxOverdraw = FMath::Max(OutResult.MaxOverdraw, overdraw);
+}
+
+void FLocationOverdraw::MakeHeatMap(const FLocationOverdrawResult& Result, float MaxLayers, TArray<FColor>& OutPixels)
+{
+	static const FLinearColor Gradient[] = { FLinearColor::Black, FLinearColor::Blue, FLinearColor::Green, FLinearColor::Yellow, FLinearColor::Red };
+	constexpr int32 Steps = UE_ARRAY_COUNT(Gradient) - 1;
+
+	OutPixels.SetNumUninitialized(Result.Overdraw.Num());
+	for (int32 i = 0; i < Result.Overdraw.Num(); ++i)
+	{
+		const float position = FMath::Clamp(Result.Overdraw[i] / FMath::Max(MaxLayers, 1.0f), 0.0f, 1.0f) * Steps;
+		const int32 step = FMath::Min((int32)position, Steps - 1);
+		OutPixels[i] = FMath::Lerp(Gradient[step], Gradient[step + 1], position - step).ToFColor(true);
+	}
+}
+
+bool FLocationOverdraw::ExportHeatMap(const FLocationOverdrawResult& Result, float MaxLayers, const FString& Filename)
+{
+	if (Result.Overdraw.Num() == 0)
+		return false;
+
+	TArray<FColor> pixels;
+	MakeHeatMap(Result, MaxLayers, pixels);
+	return FFileHelper::CreateBitmap(*Filename, Result.Resolution.X, Result.Resolution.Y, pixels.GetData());
+}
+
+FString FLocationOverdraw::GetDefaultHeatMapFilename(FName LocationName)
+{
+	return FPaths::ProjectSavedDir() / TEXT("Locations") / (LocationName.ToString() + TEXT("_Overdraw.bmp"));
+}
@@ -0,0 +1,59 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+
+/* A single drawn layer of a location in articy coordinates, the pixels of the location with the y axis pointing down */
+struct MANIACMANFRED_API FLocationOverdrawLayer
+{
+	FName Label;
+	FBox2D Rect = FBox2D(ForceInit);
+	/* Layers with a higher order are drawn on top, layers with the same order in the order they were added */
+	float Order = 0;
+	/* Share of the rect the sprite geometry covers, below 1 for sprites fitted tightly around their visible pixels */
+	float Coverage = 1;
+	/* The layer writes depth and hides everything beneath it, only fully opaque sprites covering their whole rect do */
+	bool bOccludes = false;
+	/* The layer is only drawn in some states of the location, because it is hidden by default or has a display condition */
+	bool bConditional = false;
+};
+
+/* What drawing the layers of a location costs at a certain resolution */
+struct MANIACMANFRED_API FLocationOverdrawResult
+{
+	FIntPoint Resolution = FIntPoint::ZeroValue;
+	/* Layers shaded on every screen pixel with all conditional layers shown, row by row */
+	TArray<float> Overdraw;
+	/* Pixels shaded per frame with only the unconditional layers, and with all conditional layers shown as well */
+	double ShadedPixels = 0;
+	double WorstCaseShadedPixels = 0;
+	/* Most layers shaded on a single pixel, with all conditional layers shown */
+	float MaxOverdraw = 0;
+	/* Pixels every layer shades with all conditional layers shown, in the order of the layers */
+	TArray<double> LayerShadedPixels;
+
+	/* Shaded pixels per screen pixel */
+	float GetAverageOverdraw(bool bWorstCase) const;
+};
+
+/* Estimates the fill cost of a location on the CPU, without a renderer, so it can run headless before any art is checked in.
+*  The camera shows the whole location, so the layers are rasterized as their rects at the screen size they are drawn with.
+*  Layers are walked front to back, everything behind an occluding layer is rejected by the depth test and costs nothing.
+*/
+struct MANIACMANFRED_API FLocationOverdraw
+{
+public:
+
+	/* Rasterizes the layers at the given resolution, ViewRect is fitted into the screen with black bars like the camera shows the location */
+	static void Analyze(TArrayView<const FLocationOverdrawLayer> Layers, const FBox2D& ViewRect, const FIntPoint& Resolution, FLocationOverdrawResult& OutResult);
+
+	/* Colors the overdraw of every pixel from black (nothing drawn) over blue, green and yellow to red for MaxLayers and more */
+	static void MakeHeatMap(const FLocationOverdrawResult& Result, float MaxLayers, TArray<FColor>& OutPixels);
+
+	/* Writes the heat map as bitmap, returns false if the file couldn't be written */
+	static bool ExportHeatMap(const FLocationOverdrawResult& Result, float MaxLayers, const FString& Filename);
+
+	/* Saved/Locations/<Location>_Overdraw.bmp, next to the binary layouts */
+	static FString GetDefaultHeatMapFilename(FName LocationName);
+};
@@ -0,0 +1,102 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#include "LocationPickingIndex.h"
+
+/* Leaves with up to this many polygons aren't split any further */
+static const int32 MaxPolygonsPerLeaf = 4;
+
+void FLocationPickingIndex::AddPolygon(int32 Zone, float Priority, TArrayView<const FVector2D> InVertices)
+{
+	if (InVertices.Num() < 3)
+		return;
+
+	PolygonZones.Add(Zone);
+	PolygonPriorities.Add(Priority);
+	PolygonBounds.Add(LocationGeometry::ComputeBounds(InVertices));
+	VertexStarts.Add(Vertices.Num());
+	VertexCounts.Add(InVertices.Num());
+	Vertices.Append(InVertices.GetData(), InVertices.Num());
+}
+
+void FLocationPickingIndex::Build()
+{
+	Nodes.Reset();
+	PolygonOrder.Reset();
+	if (PolygonZones.Num() == 0)
+		return;
+
+	PolygonOrder.SetNumUninitialized(PolygonZones.Num());
+	for (int32 i = 0; i < PolygonOrder.Num(); ++i)
+		PolygonOrder[i] = i;
+
+	// a binary tree with n / MaxPolygonsPerLeaf leaves has less than twice as many nodes
+	Nodes.Reserve(2 * PolygonZones.Num() / MaxPolygonsPerLeaf + 1);
+	BuildNode(0, PolygonOrder.Num());
+}
+
+int32 FLocationPickingIndex::BuildNode(int32 First, int32 Count)
+{
+	const int32 nodeIndex = Nodes.AddDefaulted();
+
+	FBox2D bounds(ForceInit);
+	FBox2D centers(ForceInit);
+	for (int32 i = First; i < First + Count; ++i)
+	{
+		const FBox2D& polygonBounds = PolygonBounds[PolygonOrder[i]];
+		bounds += polygonBounds;
+		centers += polygonBounds.GetCenter();
+	}
+	Nodes[nodeIndex].Bounds = bounds;
+
+	if (Count <= MaxPolygonsPerLeaf)
+	{
+		Nodes[nodeIndex].SecondChildOrFirstPolygon = First;
+		Nodes[nodeIndex].PolygonCount = Count;
+		return nodeIndex;
+	}
+
+	// split at the median of the polygon centers along the longer axis
+	const FVector2D extent = centers.GetSize();
+	const int32 axis = extent.X >= extent.Y ? 0 : 1;
+	Sort(PolygonOrder.GetData() + First, Count, [this, axis](int32 A, int32 B)
+	{
+		return PolygonBounds[A].GetCenter()[axis] < PolygonBounds[B].GetCenter()[axis];
+	});
+
+	// the first child directly follows its parent, so we only have to remember the second one
+	const int32 half = Count / 2;
+	BuildNode(First, half);
+	const int32 secondChild = BuildNode(First + half, Count - half);
+	Nodes[nodeIndex].SecondChildOrFirstPolygon = secondChild;
+	Nodes[nodeIndex].PolygonCount = 0;
+
+	return nodeIndex;
+}
+
+void FLocationPickingIndex::Reset()
+{
+	Nodes.Reset();
+	PolygonOrder.Reset();
+	PolygonZones.Reset();
+	PolygonPriorities.Reset();
+	PolygonBounds.Reset();
+	VertexStarts.Reset();
+	VertexCounts.Reset();
+	Vertices.Reset();
+}
+
+int32 FLocationPickingIndex::FindTopmostAtLinear(const FVector2D& Point) const
+{
+	int32 bestPolygon = INDEX_NONE;
+	for (int32 polygon = 0; polygon < PolygonZones.Num(); ++polygon)
+	{
+		if (bestPolygon != INDEX_NONE && PolygonPriorities[polygon] < PolygonPriorities[bestPolygon])
+			continue;
+
+		TArrayView<const FVector2D> vertices(Vertices.GetData() + VertexStarts[polygon], VertexCounts[polygon]);
+		if (Contains(PolygonBounds[polygon], Point) && LocationGeometry::IsPointInPolygon(Point, vertices))
+			bestPolygon = polygon;
+	}
+
+	return bestPolygon != INDEX_NONE ? PolygonZones[bestPolygon] : INDEX_NONE;
+}
@@ -0,0 +1,119 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "LocationGeometry.h"
+
+/* A bounding volume hierarchy over zone polygons, answering which zone is the topmost one under a point.
+*  A zone can consist of several polygons (e.g. a decomposed collider), every polygon carries the priority of its zone
+*  and the polygon with the highest priority wins, ties go to the polygon that was added last.
+*
+*  Queries don't allocate: they walk the hierarchy with a fixed stack, only test polygons whose bounds contain the point
+*  and skip polygons that couldn't beat the best hit so far.
+*/
+struct MANIACMANFRED_API FLocationPickingIndex
+{
+public:
+
+	/* Adds a polygon (convex or concave, any winding) to a zone. Build has to be called afterwards. */
+	void AddPolygon(int32 Zone, float Priority, TArrayView<const FVector2D> Vertices);
+
+	/* Builds the hierarchy over all added polygons */
+	void Build();
+
+	void Reset();
+
+	int32 NumPolygons() const { return PolygonZones.Num(); }
+
+	/* Returns the zone of the topmost polygon containing the point or INDEX_NONE */
+	int32 FindTopmostAt(const FVector2D& Point) const
+	{
+		return FindTopmostAt(Point, [](int32 Zone) { return true; });
+	}
+
+	/* Same as FindTopmostAt, but ignores zones the filter returns false for (e.g. hidden ones). The filter is only called for hits. */
+	template<typename FilterType>
+	int32 FindTopmostAt(const FVector2D& Point, FilterType Filter) const;
+
+	/* Tests every polygon without the hierarchy, only meant as reference for benchmarks and validation */
+	int32 FindTopmostAtLinear(const FVector2D& Point) const;
+
+private:
+
+	/* Leaves have a polygon count, inner nodes have their first child directly behind them and store the index of the second one */
+	struct FNode
+	{
+		FBox2D Bounds;
+		int32 SecondChildOrFirstPolygon = 0;
+		int32 PolygonCount = 0;
+	};
+
+	int32 BuildNode(int32 First, int32 Count);
+
+	FORCEINLINE static bool Contains(const FBox2D& Bounds, const FVector2D& Point)
+	{
+		return Point.X >= Bounds.Min.X && Point.X <= Bounds.Max.X && Point.Y >= Bounds.Min.Y && Point.Y <= Bounds.Max.Y;
+	}
+
+	TArray<FNode> Nodes;
+	/* The polygons in the order the leaves reference them */
+	TArray<int32> PolygonOrder;
+
+	TArray<int32> PolygonZones;
+	TArray<float> PolygonPriorities;
+	TArray<FBox2D> PolygonBounds;
+	TArray<int32> VertexStarts;
+	TArray<int32> VertexCounts;
+	TArray<FVector2D> Vertices;
+};
+
+template<typename FilterType>
+int32 FLocationPickingIndex::FindTopmostAt(const FVector2D& Point, FilterType Filter) const
+{
+	if (Nodes.Num() == 0)
+		return INDEX_NONE;
+
+	int32 bestPolygon = INDEX_NONE;
+	float bestPriority = 0;
+
+	// the hierarchy is balanced, so 64 levels are far more than we will ever need
+	int32 stack[64];
+	int32 stackSize = 0;
+	stack[stackSize++] = 0;
+
+	while (stackSize > 0)
+	{
+		const FNode& node = Nodes[stack[--stackSize]];
+		if (!Contains(node.Bounds, Point))
+			continue;
+
+		if (node.PolygonCount == 0)
+		{
+			const int32 nodeIndex = &node - Nodes.GetData();
+			stack[stackSize++] = nodeIndex + 1;
+			stack[stackSize++] = node.SecondChildOrFirstPolygon;
+			continue;
+		}
+
+		for (int32 i = 0; i < node.PolygonCount; ++i)
+		{
+			const int32 polygon = PolygonOrder[node.SecondChildOrFirstPolygon + i];
+			const float priority = PolygonPriorities[polygon];
+			if (bestPolygon != INDEX_NONE && (priority < bestPriority || (priority == bestPriority && polygon < bestPolygon)))
+				continue;
+
+			if (!Contains(PolygonBounds[polygon], Point))
+				continue;
+
+			TArrayView<const FVector2D> vertices(Vertices.GetData() + VertexStarts[polygon], VertexCounts[polygon]);
+			if (LocationGeometry::IsPointInPolygon(Point, vertices) && Filter(PolygonZones[polygon]))
+			{
+				bestPolygon = polygon;
+				bestPriority = priority;
+			}
+		}
+	}
+
+	return bestPolygon != INDEX_NONE ? PolygonZones[bestPolygon] : INDEX_NONE;
+}
@@ -0,0 +1,114 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#include "LocationPickingSubsystem.h"
+#include "ArticyReference.h"
+#include "EngineUtils.h"
+#include "Engine/World.h"
+#include "GameFramework/PlayerController.h"
+#include "PhysicsEngine/BodySetup.h"
+#include "PaperSpriteActor.h"
+#include "PaperSpriteComponent.h"
+
+void ULocationPickingSubsystem::OnWorldBeginPlay(UWorld& InWorld)
+{
+	Super::OnWorldBeginPlay(InWorld);
+	Rebuild();
+}
+
+void ULocationPickingSubsystem::Rebuild()
+{
+	Index.Reset();
+	Zones.Reset();
+
+	TArray<FVector2D> projectedPoints;
+	TArray<FVector2D> hull;
+
+	for (TActorIterator<APaperSpriteActor> it(GetWorld()); it; ++it)
+	{
+		APaperSpriteActor* actor = *it;
+		UPaperSpriteComponent* renderComponent = actor->GetRenderComponent();
+		if (!actor->FindComponentByClass<UArticyReference>() || !renderComponent || !renderComponent->IsCollisionEnabled())
+			continue;
+
+		UBodySetup* bodySetup = renderComponent->GetBodySetup();
+		if (!bodySetup)
+			continue;
+
+		const int32 zone = Zones.Num();
+		const float priority = actor->GetActorLocation().Y;
+		const FTransform& componentTransform = renderComponent->GetComponentTransform();
+		bool bHasPolygons = false;
+
+		// Paper2D extrudes every collider polygon into a convex element, its outline on the location plane is the hull of its vertices
+		for (const FKConvexElem& convex : bodySetup->AggGeom.ConvexElems)
+		{
+			const FTransform elementTransform = convex.GetTransform() * componentTransform;
+			projectedPoints.Reset();
+			for (const FVector& vertex : convex.VertexData)
+			{
+				const FVector worldVertex = elementTransform.TransformPosition(vertex);
+				projectedPoints.Add(FVector2D(worldVertex.X, worldVertex.Z));
+			}
+
+			LocationGeometry::ComputeConvexHull(projectedPoints, hull);
+			if (hull.Num() >= 3)
+			{
+				Index.AddPolygon(zone, priority, hull);
+				bHasPolygons = true;
+			}
+		}
+
+		for (const FKBoxElem& box : bodySetup->AggGeom.BoxElems)
+		{
+			const FTransform elementTransform = box.GetTransform() * componentTransform;
+			const FVector extent(box.X * 0.5f, box.Y * 0.5f, box.Z * 0.5f);
+			projectedPoints.Reset();
+			for (int32 corner = 0; corner < 8; ++corner)
+			{
+				const FVector localCorner((corner & 1) ? extent.X : -extent.X, (corner & 2) ? extent.Y : -extent.Y, (corner & 4) ? extent.Z : -extent.Z);
+				const FVector worldVertex = elementTransform.TransformPosition(localCorner);
+				projectedPoints.Add(FVector2D(worldVertex.X, worldVertex.Z));
+			}
+
+			LocationGeometry::ComputeConvexHull(projectedPoints, hull);
+			if (hull.Num() >= 3)
+			{
+				Index.AddPolygon(zone, priority, hull);
+				bHasPolygons = true;
+			}
+		}
+
+		if (bHasPolygons)
+			Zones.Add(actor);
+	}
+
+	Index.Build();
+
+	UE_LOG(LogTemp, Log, TEXT("Location picking: %d zones with %d collider polygons."), Zones.Num(), Index.NumPolygons());
+}
+
+APaperSpriteActor* ULocationPickingSubsystem::FindZoneAt(FVector WorldLocation) const
+{
+	// zones can be hidden or disabled by display conditions after we collected them
+	const int32 zone = Index.FindTopmostAt(FVector2D(WorldLocation.X, WorldLocation.Z), [this](int32 Zone)
+	{
+		const APaperSpriteActor* actor = Zones[Zone].Get();
+		return actor && !actor->IsHidden() && actor->GetRenderComponent()->IsCollisionEnabled();
+	});
+
+	return zone != INDEX_NONE ? Zones[zone].Get() : nullptr;
+}
+
+APaperSpriteActor* ULocationPickingSubsystem::FindZoneUnderCursor(APlayerController* PlayerController) const
+{
+	FVector origin;
+	FVector direction;
+	if (!PlayerController || !PlayerController->DeprojectMousePositionToWorld(origin, direction))
+		return nullptr;
+
+	// the location lies in the X/Z plane, for the orthographic camera of the game the ray origin is already on it
+	if (!FMath::IsNearlyZero(direction.Y))
+		origin -= direction * (origin.Y / direction.Y);
+
+	return FindZoneAt(origin);
+}
@@ -0,0 +1,48 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Subsystems/WorldSubsystem.h"
+#include "LocationPickingIndex.h"
+#include "LocationPickingSubsystem.generated.h"
+
+class APaperSpriteActor;
+class APlayerController;
+
+/* Answers which generated zone is under the cursor without a physics trace.
+*  When play begins it collects the colliders of all generated zones (sprite actors with an ArticyReference and collision enabled),
+*  projects them onto the location plane (X/Z) and puts them into a FLocationPickingIndex.
+*  Zones with a higher sort priority (which the generator stores in the Y location) are on top.
+*  The ULocationInstantiationSubsystem rebuilds the index whenever it completed or released a location.
+*/
+UCLASS()
+class MANIACMANFRED_API ULocationPickingSubsystem : public UWorldSubsystem
+{
+	GENERATED_BODY()
+
+public:
+
+	virtual void OnWorldBeginPlay(UWorld& InWorld) override;
+
+	/* Collects the zone colliders again, needed if zones were spawned or destroyed after play began */
+	UFUNCTION(BlueprintCallable, Category = "Location Picking")
+	void Rebuild();
+
+	/* Returns the topmost visible zone at a world location, Y is ignored */
+	UFUNCTION(BlueprintCallable, Category = "Location Picking")
+	APaperSpriteActor* FindZoneAt(FVector WorldLocation) const;
+
+	/* Returns the topmost visible zone under the mouse cursor of a player */
+	UFUNCTION(BlueprintCallable, Category = "Location Picking")
+	APaperSpriteActor* FindZoneUnderCursor(APlayerController* PlayerController) const;
+
+	int32 NumZones() const { return Zones.Num(); }
+
+private:
+
+	FLocationPickingIndex Index;
+
+	/* The zone actors, indexed by the zone index of the picking index */
+	TArray<TWeakObjectPtr<APaperSpriteActor>> Zones;
+};
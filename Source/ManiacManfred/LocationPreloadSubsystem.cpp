@@ -0,0 +1,236 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#include "LocationPreloadSubsystem.h"
+#include "ArticyDatabase.h"
+#include "AssetRegistry/IAssetRegistry.h"
+#include "Engine/AssetManager.h"
+#include "Engine/World.h"
+#include "UObject/UObjectGlobals.h"
+
+/* Gives up a request, whether it is still loading or not */
+static void ReleasePreloadHandle(const TSharedPtr<FStreamableHandle>& Handle)
+{
+	if (!Handle.IsValid())
+		return;
+
+	if (Handle->HasLoadCompleted())
+		Handle->ReleaseHandle();
+	else
+		Handle->CancelHandle();
+}
+
+void ULocationPreloadSubsystem::Initialize(FSubsystemCollectionBase& Collection)
+{
+	Super::Initialize(Collection);
+
+	// the links between locations don't change while playing, so the original database is enough
+	if (UArticyDatabase* database = UArticyDatabase::GetMutableOriginal())
+	{
+		Graph.Build(*database);
+		UE_LOG(LogTemp, Log, TEXT("Location graph: %d locations, %d edges."), Graph.Num(), Graph.NumEdges());
+	}
+	else
+		UE_LOG(LogTemp, Warning, TEXT("Could not load the articy database, no locations are preloaded."));
+
+	PostLoadMapHandle = FCoreUObjectDelegates::PostLoadMapWithWorld.AddUObject(this, &ULocationPreloadSubsystem::OnMapLoaded);
+}
+
+void ULocationPreloadSubsystem::Deinitialize()
+{
+	FCoreUObjectDelegates::PostLoadMapWithWorld.Remove(PostLoadMapHandle);
+
+	for (const FPreload& preload : Preloads)
+		ReleasePreloadHandle(preload.Handle);
+	Preloads.Reset();
+	Graph.Reset();
+
+	Super::Deinitialize();
+}
+
+void ULocationPreloadSubsystem::SetCurrentLocation(FName LocationName)
+{
+	const int32 location = Graph.FindLocation(LocationName);
+	if (location == INDEX_NONE)
+	{
+		UE_LOG(LogTemp, Warning, TEXT("There is no articy location named %s, nothing is preloaded."), *LocationName.ToString());
+		return;
+	}
+
+	if (location == CurrentLocation)
+		return;
+
+	++Entered;
+	const FPreload* preload = Preloads.FindByPredicate([location](const FPreload& Preload) { return Preload.Location == location; });
+	if (preload && preload->Handle.IsValid() && preload->Handle->HasLoadCompleted())
+		++Hits;
+
+	CurrentLocation = location;
+	UpdatePreloads();
+	LogStats();
+}
+
+void ULocationPreloadSubsystem::SetMemoryBudget(float Megabytes, int32 InMaxDepth)
+{
+	MemoryBudgetBytes = (int64)(FMath::Max(Megabytes, 0.0f) * 1024 * 1024);
+	MaxDepth = FMath::Max(InMaxDepth, 0);
+
+	if (CurrentLocation != INDEX_NONE)
+		UpdatePreloads();
+}
+
+bool ULocationPreloadSubsystem::IsPreloaded(FName LocationName) const
+{
+	const int32 location = Graph.FindLocation(LocationName);
+	const FPreload* preload = Preloads.FindByPredicate([location](const FPreload& Preload) { return Preload.Location == location; });
+	return location != INDEX_NONE && preload && preload->Handle.IsValid() && preload->Handle->HasLoadCompleted();
+}
+
+TArray<FName> ULocationPreloadSubsystem::GetPreloadedLocations() const
+{
+	TArray<FName> names;
+	for (const FPreload& preload : Preloads)
+		names.Add(Graph.GetNode(preload.Location).Name);
+
+	return names;
+}
+
+void ULocationPreloadSubsystem::LogStats() const
+{
+	UE_LOG(LogTemp, Log, TEXT("Location preload: %d of %d entered locations were preloaded, %d locations preloaded with %.2f of %.2f MB, %d likely locations didn't fit into the budget."),
+		Hits, Entered, Preloads.Num(), GetPreloadedBytes() / (1024.0 * 1024.0), MemoryBudgetBytes / (1024.0 * 1024.0), Skipped);
+}
+
+void ULocationPreloadSubsystem::OnMapLoaded(UWorld* World)
+{
+	// with several play in editor instances, every instance has its own subsystem
+	if (!World || World->GetGameInstance() != GetGameInstance())
+		return;
+
+	const FName mapName(UWorld::RemovePIEPrefix(World->GetMapName()));
+	if (Graph.FindLocation(mapName) != INDEX_NONE)
+		SetCurrentLocation(mapName);
+}
+
+void ULocationPreloadSubsystem::OnPreloadCompleted(int32 Location)
+{
+	FPreload* preload = Preloads.FindByPredicate([Location](const FPreload& Preload) { return Preload.Location == Location; });
+	if (!preload || !preload->Handle.IsValid())
+		return;
+
+	TArray<UObject*> assets;
+	preload->Handle->GetLoadedAssets(assets);
+
+	int64 bytes = 0;
+	for (UObject* asset : assets)
+	{
+		if (asset)
+			bytes += asset->GetResourceSizeBytes(EResourceSizeMode::EstimatedTotal);
+	}
+
+	// packages the asset registry has no size for were estimated with nothing
+	if (bytes > 0)
+		preload->Bytes = bytes;
+
+	UE_LOG(LogTemp, Log, TEXT("Preloaded %s: %d assets, %.2f MB in %.2fs."),
+		*Graph.GetNode(Location).Name.ToString(), assets.Num(), preload->Bytes / (1024.0 * 1024.0), FPlatformTime::Seconds() - preload->StartTime);
+
+	TrimToBudget();
+}
+
+void ULocationPreloadSubsystem::UpdatePreloads()
+{
+	LikelyNext = Graph.GetLikelyNext(CurrentLocation, MaxDepth);
+
+	// the current location is held by its world now, locations that aren't likely anymore are given up even if they are still loading
+	for (int32 i = Preloads.Num() - 1; i >= 0; --i)
+	{
+		if (!LikelyNext.Contains(Preloads[i].Location))
+		{
+			ReleasePreloadHandle(Preloads[i].Handle);
+			Preloads.RemoveAt(i);
+		}
+	}
+
+	FStreamableManager& streamableManager = UAssetManager::GetStreamableManager();
+	int64 preloadedBytes = GetPreloadedBytes();
+	for (int32 location : LikelyNext)
+	{
+		if (Preloads.ContainsByPredicate([location](const FPreload& Preload) { return Preload.Location == location; }))
+			continue;
+
+		int64 estimatedBytes = 0;
+		TArray<FSoftObjectPath> paths = GetPreloadPaths(location, estimatedBytes);
+		if (paths.Num() == 0)
+			continue;
+
+		// a less likely location may still fit if it is smaller
+		if (preloadedBytes + estimatedBytes > MemoryBudgetBytes)
+		{
+			UE_LOG(LogTemp, Verbose, TEXT("%s doesn't fit into the preload budget (%.2f MB)."), *Graph.GetNode(location).Name.ToString(), estimatedBytes / (1024.0 * 1024.0));
+			++Skipped;
+			continue;
+		}
+
+		FPreload& preload = Preloads.AddDefaulted_GetRef();
+		preload.Location = location;
+		preload.Bytes = estimatedBytes;
+		preload.StartTime = FPlatformTime::Seconds();
+		preload.Handle = streamableManager.RequestAsyncLoad(MoveTemp(paths), FStreamableDelegate::CreateUObject(this, &ULocationPreloadSubsystem::OnPreloadCompleted, location));
+		preloadedBytes += estimatedBytes;
+	}
+
+	// TrimToBudget gives up the least likely preloads first
+	Preloads.Sort([this](const FPreload& A, const FPreload& B) { return LikelyNext.IndexOfByKey(A.Location) < LikelyNext.IndexOfByKey(B.Location); });
+	TrimToBudget();
+}
+
+void ULocationPreloadSubsystem::TrimToBudget()
+{
+	while (Preloads.Num() > 0 && GetPreloadedBytes() > MemoryBudgetBytes)
+	{
+		const FPreload& preload = Preloads.Last();
+		UE_LOG(LogTemp, Log, TEXT("Released the preload of %s, it doesn't fit into the budget."), *Graph.GetNode(preload.Location).Name.ToString());
+
+		ReleasePreloadHandle(preload.Handle);
+		Preloads.Pop();
+		++Skipped;
+	}
+}
+
+TArray<FSoftObjectPath> ULocationPreloadSubsystem::GetPreloadPaths(int32 Location, int64& OutEstimatedBytes) const
+{
+	const FLocationGraphNode& node = Graph.GetNode(Location);
+	const FString mapName = node.Name.ToString();
+
+	TArray<FSoftObjectPath> candidates;
+	candidates.Add(FSoftObjectPath(MapPath / mapName + TEXT(".") + mapName));
+	candidates.Append(node.Assets);
+
+	// requesting packages that don't exist only produces warnings, e.g. for locations without a map
+	IAssetRegistry& assetRegistry = IAssetRegistry::GetChecked();
+	TArray<FSoftObjectPath> paths;
+	OutEstimatedBytes = 0;
+	for (const FSoftObjectPath& candidate : candidates)
+	{
+		if (!assetRegistry.GetAssetByObjectPath(candidate).IsValid())
+			continue;
+
+		// cooked games only keep the sizes of packages if the project serializes them into the asset registry
+		TOptional<FAssetPackageData> packageData = assetRegistry.GetAssetPackageDataCopy(candidate.GetLongPackageFName());
+		if (packageData.IsSet())
+			OutEstimatedBytes += FMath::Max<int64>(packageData->DiskSize, 0);
+
+		paths.Add(candidate);
+	}
+
+	return paths;
+}
+
+int64 ULocationPreloadSubsystem::GetPreloadedBytes() const
+{
+	int64 bytes = 0;
+	for (const FPreload& preload : Preloads)
+		bytes += preload.Bytes;
+
+	return bytes;
+}
@@ -0,0 +1,95 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Subsystems/GameInstanceSubsystem.h"
+#include "Engine/StreamableManager.h"
+#include "LocationGraph.h"
+#include "LocationPreloadSubsystem.generated.h"
+
+/* Streams in the maps, textures and sounds of the locations the player will likely enter next, so changing the location doesn't wait for the disk.
+*  The location graph is built from the articy data when the game starts. Whenever a map named like a location was loaded,
+*  the locations reachable from it are requested in order of likelihood, as long as their estimated memory fits into the budget.
+*  Preloaded assets are only held by their streamable handle, entering a location hands them over to its world, leaving the
+*  neighbourhood of a location releases them for the garbage collector.
+*/
+UCLASS()
+class MANIACMANFRED_API ULocationPreloadSubsystem : public UGameInstanceSubsystem
+{
+	GENERATED_BODY()
+
+public:
+
+	virtual void Initialize(FSubsystemCollectionBase& Collection) override;
+	virtual void Deinitialize() override;
+
+	/* Preloads the neighbourhood of a location and releases everything else, called automatically for maps named like a location */
+	UFUNCTION(BlueprintCallable, Category = "Location Preload")
+	void SetCurrentLocation(FName LocationName);
+
+	/* The most memory preloads may take and how many location changes ahead to look, 1 only preloads direct neighbours */
+	UFUNCTION(BlueprintCallable, Category = "Location Preload")
+	void SetMemoryBudget(float Megabytes, int32 InMaxDepth = 1);
+
+	/* True if all assets of a location are loaded */
+	UFUNCTION(BlueprintCallable, Category = "Location Preload")
+	bool IsPreloaded(FName LocationName) const;
+
+	/* The locations being preloaded or preloaded, the likeliest one first */
+	UFUNCTION(BlueprintCallable, Category = "Location Preload")
+	TArray<FName> GetPreloadedLocations() const;
+
+	const FLocationGraph& GetGraph() const { return Graph; }
+
+	void LogStats() const;
+
+private:
+
+	struct FPreload
+	{
+		int32 Location = INDEX_NONE;
+		TSharedPtr<FStreamableHandle> Handle;
+		/* What the asset registry says the packages take on disk, replaced by the resource size of the assets once they are loaded */
+		int64 Bytes = 0;
+		double StartTime = 0;
+	};
+
+	void OnMapLoaded(UWorld* World);
+	void OnPreloadCompleted(int32 Location);
+
+	/* Releases the preloads that aren't likely anymore and requests the likeliest ones that fit into the budget */
+	void UpdatePreloads();
+
+	/* Releases the least likely preloads until the rest fits into the budget */
+	void TrimToBudget();
+
+	/* The map of a location and the assets the graph found for it, without packages the asset registry doesn't know */
+	TArray<FSoftObjectPath> GetPreloadPaths(int32 Location, int64& OutEstimatedBytes) const;
+
+	int64 GetPreloadedBytes() const;
+
+	FLocationGraph Graph;
+
+	/* The maps are named like the technical names of their locations, the same as GenerateLocationsCommandlet expects */
+	FString MapPath = TEXT("/Game/Maps");
+
+	int32 CurrentLocation = INDEX_NONE;
+
+	/* The likely next locations of the current one, in order of likelihood */
+	TArray<int32> LikelyNext;
+
+	TArray<FPreload> Preloads;
+
+	int64 MemoryBudgetBytes = 256ll * 1024 * 1024;
+	int32 MaxDepth = 1;
+
+	FDelegateHandle PostLoadMapHandle;
+
+	/* Locations that were entered after their preload completed, and all that were entered */
+	int32 Hits = 0;
+	int32 Entered = 0;
+
+	/* Likely locations that weren't requested or were released again because they didn't fit into the budget */
+	int32 Skipped = 0;
+};
@@ -0,0 +1,702 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#include "LocationSpriteCache.h"
+#include "LocationAtlasPacker.h"
+#include "Paper2DClasses.h"
+#include "Engine/AssetManager.h"
+#include "Engine/Texture2D.h"
+#include "Materials/MaterialInterface.h"
+#include "Misc/Paths.h"
+#include "ProfilingDebugging/CpuProfilerTrace.h"
+
+/* Where the articy importer puts the assets of the articy project */
+static const FString ArticyResourceFolder = TEXT("/Game/ArticyContent/Resources");
+
+FSoftObjectPath ULocationSpriteCache::GetAssetPath(const UArticyAsset* Asset)
+{
+	if (!Asset || Asset->AssetRef.IsEmpty())
+		return FSoftObjectPath();
+
+	const FString packageName = ArticyResourceFolder / FPaths::GetPath(Asset->AssetRef) / FPaths::GetBaseFilename(Asset->AssetRef);
+	return FSoftObjectPath(packageName + TEXT(".") + FPaths::GetBaseFilename(Asset->AssetRef));
+}
+
+FLocationSpriteCacheEntry* ULocationSpriteCache::LoadEntry(UArticyAsset* ImageAsset)
+{
+#if WITH_EDITOR
+
+	if (!ImageAsset || ImageAsset->Category != EArticyAssetCategory::Image)
+		return nullptr;
+
+	// the entry is only added once its texture loaded, so the cache never stores (and saves) entries without one
+	FLocationSpriteCacheEntry* entry = Entries.Find(ImageAsset->GetId());
+	if (!entry || !entry->Texture)
+	{
+		UTexture2D* loadedTexture = nullptr;
+
+		// a requested load only blocks until this one texture arrived, the others keep streaming in the meantime
+		TSharedPtr<FStreamableHandle> request;
+		if (TextureRequests.RemoveAndCopyValue(ImageAsset->GetId(), request))
+		{
+			if (!request->HasLoadCompleted())
+			{
+				TRACE_CPUPROFILER_EVENT_SCOPE(ULocationSpriteCache::WaitForTexture);
+				request->WaitUntilComplete();
+			}
+
+			loadedTexture = Cast<UTexture2D>(request->GetLoadedAsset());
+			if (loadedTexture)
+				++TexturesStreamed;
+		}
+
+		if (!loadedTexture)
+		{
+			TRACE_CPUPROFILER_EVENT_SCOPE(ULocationSpriteCache::LoadTexture);
+			loadedTexture = Cast<UTexture2D>(ImageAsset->LoadAsTexture());
+		}
+
+		if (!loadedTexture)
+			return nullptr;
+
+		++TextureLoads;
+		if (!entry)
+			entry = &Entries.Add(ImageAsset->GetId());
+		entry->Texture = loadedTexture;
+	}
+
+	// adjust tiling method of the texture, but only touch its package if the settings really change
+	UTexture2D* texture = entry->Texture;
+	if (texture->AddressX != TextureAddress::TA_Clamp || texture->AddressY != TextureAddress::TA_Clamp)
+	{
+		texture->Modify();
+		texture->AddressX = TextureAddress::TA_Clamp;
+		texture->AddressY = TextureAddress::TA_Clamp;
+		texture->MarkPackageDirty();
+	}
+
+	return entry;
+
+#else
+	return nullptr;
+#endif // WITH_EDITOR
+}
+
+int32 ULocationSpriteCache::RequestTextures(TArrayView<UArticyAsset* const> ImageAssets)
+{
+#if WITH_EDITOR
+
+	FStreamableManager& streamableManager = UAssetManager::GetStreamableManager();
+	int32 requested = 0;
+
+	for (UArticyAsset* imageAsset : ImageAssets)
+	{
+		if (!imageAsset || imageAsset->Category != EArticyAssetCategory::Image || TextureRequests.Contains(imageAsset->GetId()))
+			continue;
+
+		const FLocationSpriteCacheEntry* entry = Entries.Find(imageAsset->GetId());
+		if (entry && entry->Texture)
+			continue;
+
+		// every texture gets its own handle, so waiting for one of them doesn't wait for all
+		const FSoftObjectPath path = GetAssetPath(imageAsset);
+		TSharedPtr<FStreamableHandle> request = path.IsValid() ? streamableManager.RequestAsyncLoad(path, FStreamableDelegate(), FStreamableManager::AsyncLoadHighPriority) : nullptr;
+		if (!request.IsValid())
+			continue;
+
+		TextureRequests.Add(imageAsset->GetId(), request);
+		++requested;
+	}
+
+	return requested;
+
+#else
+	return 0;
+#endif // WITH_EDITOR
+}
+
+bool ULocationSpriteCache::IsTextureReady(UArticyAsset* ImageAsset) const
+{
+	if (!ImageAsset || ImageAsset->Category != EArticyAssetCategory::Image)
+		return true;
+
+	const FLocationSpriteCacheEntry* entry = Entries.Find(ImageAsset->GetId());
+	if (entry && entry->Texture)
+		return true;
+
+	const TSharedPtr<FStreamableHandle>* request = TextureRequests.Find(ImageAsset->GetId());
+	return request && (*request)->HasLoadCompleted();
+}
+
+void ULocationSpriteCache::ReleaseTextureRequests()
+{
+	for (const TPair<FArticyId, TSharedPtr<FStreamableHandle>>& request : TextureRequests)
+		request.Value->ReleaseHandle();
+
+	TextureRequests.Reset();
+}
+
+UTexture2D* ULocationSpriteCache::GetOrLoadTexture(UArticyAsset* ImageAsset)
+{
+	const FLocationSpriteCacheEntry* entry = LoadEntry(ImageAsset);
+	return entry ? entry->Texture.Get() : nullptr;
+}
+
+bool ULocationSpriteCache::IsPacked(UArticyAsset* ImageAsset) const
+{
+	const FLocationSpriteCacheEntry* entry = ImageAsset ? Entries.Find(ImageAsset->GetId()) : nullptr;
+	return entry && entry->Atlas;
+}
+
+#if WITH_EDITOR
+
+/* Counts the fully transparent pixels of a texture and the ones in between, returns false if its source pixels can't be read */
+static bool AnalyzeAlpha(UTexture2D* Texture, float& OutTransparentShare, float& OutPartialAlphaShare)
+{
+	TArray64<uint8> mipData;
+	if (!Texture->Source.IsValid() || Texture->Source.GetFormat() != TSF_BGRA8 || !Texture->Source.GetMipData(mipData, 0, 0, 0) || mipData.Num() < 4)
+		return false;
+
+	int64 transparent = 0;
+	int64 partial = 0;
+	for (int64 i = 3; i < mipData.Num(); i += 4)
+	{
+		const uint8 alpha = mipData[i];
+		if (alpha == 0)
+			++transparent;
+		else if (alpha != 255)
+			++partial;
+	}
+
+	const double pixels = (double)(mipData.Num() / 4);
+	OutTransparentShare = transparent / pixels;
+	OutPartialAlphaShare = partial / pixels;
+	return true;
+}
+
+#endif // WITH_EDITOR
+
+ELocationImageAlpha ULocationSpriteCache::ClassifyAlpha(UArticyAsset* ImageAsset, float MaskedTolerance)
+{
+#if WITH_EDITOR
+
+	FLocationSpriteCacheEntry* entry = LoadEntry(ImageAsset);
+	if (!entry)
+		return ELocationImageAlpha::Translucent;
+
+	TRACE_CPUPROFILER_EVENT_SCOPE(ULocationSpriteCache::ClassifyAlpha);
+
+	const FGuid sourceId = entry->Texture->Source.GetId();
+	if (!entry->AlphaSourceId.IsValid() || entry->AlphaSourceId != sourceId)
+	{
+		if (!AnalyzeAlpha(entry->Texture, entry->TransparentShare, entry->PartialAlphaShare))
+		{
+			entry->TransparentShare = 0;
+			entry->PartialAlphaShare = 1;
+		}
+
+		entry->AlphaSourceId = sourceId;
+		MarkPackageDirty();
+	}
+
+	if (entry->PartialAlphaShare > MaskedTolerance)
+		return ELocationImageAlpha::Translucent;
+
+	if (entry->PartialAlphaShare > 0 || entry->TransparentShare > 0)
+		return ELocationImageAlpha::Masked;
+
+	return ELocationImageAlpha::Opaque;
+
+#else
+	return ELocationImageAlpha::Translucent;
+#endif // WITH_EDITOR
+}
+
+bool ULocationSpriteCache::NeedsSortPriority(const UPaperSprite* Sprite)
+{
+	const UMaterialInterface* material = Sprite ? Sprite->GetDefaultMaterial() : nullptr;
+	if (!material)
+		return true;
+
+	const EBlendMode blendMode = material->GetBlendMode();
+	return blendMode != BLEND_Opaque && blendMode != BLEND_Masked;
+}
+
+UPaperSprite* ULocationSpriteCache::GetOrCreateSprite(UArticyAsset* ImageAsset, const FLocationSpriteOptions& Options)
+{
+#if WITH_EDITOR
+
+	FLocationSpriteCacheEntry* entry = LoadEntry(ImageAsset);
+	if (!entry)
+		return nullptr;
+
+	if (Options.IsDefault())
+		return UpdateSprite(entry->Sprite, *entry, ImageAsset, Options);
+
+	FLocationSpriteCacheVariant* variant = entry->Variants.FindByPredicate([&Options](const FLocationSpriteCacheVariant& Variant) { return Variant.Options == Options; });
+	if (!variant)
+	{
+		variant = &entry->Variants.AddDefaulted_GetRef();
+		variant->Options = Options;
+	}
+
+	return UpdateSprite(variant->Sprite, *entry, ImageAsset, Options);
+
+#else
+	return nullptr;
+#endif // WITH_EDITOR
+}
+
+#if WITH_EDITOR
+
+/* UPaperSprite doesn't expose its render geometry, so we reach it via reflection like the collider in ULocationGenerator::SetSpritePolygonCollider */
+static FSpriteGeometryCollection* GetRenderGeometry(UPaperSprite* Sprite)
+{
+	FStructProperty* renderGeometryProp = CastField<FStructProperty>(UPaperSprite::StaticClass()->FindPropertyByName(TEXT("RenderGeometry")));
+	return renderGeometryProp ? renderGeometryProp->ContainerPtrToValuePtr<FSpriteGeometryCollection>(Sprite) : nullptr;
+}
+
+#endif // WITH_EDITOR
+
+UPaperSprite* ULocationSpriteCache::UpdateSprite(TObjectPtr<UPaperSprite>& Slot, FLocationSpriteCacheEntry& Entry, UArticyAsset* ImageAsset, const FLocationSpriteOptions& Options)
+{
+#if WITH_EDITOR
+
+	// packed images show their region of the atlas instead of the whole texture
+	UTexture2D* texture = Entry.Texture;
+	UTexture2D* sourceTexture = Entry.Atlas ? Entry.Atlas.Get() : texture;
+	const FVector2D imageOffset = Entry.Atlas ? FVector2D(Entry.AtlasOffset) : FVector2D::ZeroVector;
+	const FVector2D imageSize(texture->GetImportedSize());
+
+	// a clipped sprite only shows a part of the image, which stays where it is inside the whole image
+	FIntRect region(FIntPoint::ZeroValue, texture->GetImportedSize());
+	if (Options.Region.Width() > 0 && Options.Region.Height() > 0)
+		region.Clip(Options.Region);
+
+	const FVector2D sourceOffset = imageOffset + FVector2D(region.Min);
+	const FVector2D sourceSize(region.Size());
+
+	// the sprite is outdated if the texture was reimported with a different size or the image was (un)packed in the meantime
+	UPaperSprite* sprite = Slot;
+	if (sprite && sprite->GetSourceTexture() == sourceTexture && sprite->GetSourceUV() == sourceOffset && sprite->GetSourceSize() == sourceSize
+		&& (!Options.Material || sprite->GetDefaultMaterial() == Options.Material))
+	{
+		return sprite;
+	}
+
+	if (!sprite)
+	{
+		const FString suffix = Options.IsDefault() ? FString() : TEXT("_Variant");
+		FName spriteName = MakeUniqueObjectName(this, UPaperSprite::StaticClass(), FName(*FString::Printf(TEXT("Sprite_%s%s"), *ImageAsset->GetTechnicalName().ToString(), *suffix)));
+		sprite = NewObject<UPaperSprite>(this, spriteName, RF_Public | RF_Transactional);
+		Slot = sprite;
+	}
+	else
+	{
+		sprite->Modify();
+	}
+
+	// the render geometry is turned into triangles when the sprite is initialized, so it has to be set up before
+	if (Options.bTightGeometry)
+	{
+		if (FSpriteGeometryCollection* renderGeometry = GetRenderGeometry(sprite))
+		{
+			renderGeometry->GeometryType = ESpritePolygonMode::ShrinkWrapped;
+			renderGeometry->AlphaThreshold = Options.AlphaThreshold;
+		}
+	}
+
+	// create sprite from texture, its pivot is the bottom left corner of the whole image even if it only shows a part of it
+	FSpriteAssetInitParameters initParams;
+	initParams.SetTextureAndFill(sourceTexture);
+	initParams.Offset = sourceOffset;
+	initParams.Dimension = sourceSize;
+	initParams.DefaultMaterialOverride = Options.Material;
+	if (region.Size() == texture->GetImportedSize())
+		sprite->SetPivotMode(ESpritePivotMode::Bottom_Left, FVector2D::ZeroVector);
+	else
+		sprite->SetPivotMode(ESpritePivotMode::Custom, imageOffset + FVector2D(0, imageSize.Y));
+	{
+		TRACE_CPUPROFILER_EVENT_SCOPE(UPaperSprite::InitializeSprite);
+		sprite->InitializeSprite(initParams);
+	}
+	++SpritesCreated;
+
+	MarkPackageDirty();
+
+	return sprite;
+
+#else
+	return nullptr;
+#endif // WITH_EDITOR
+}
+
+void ULocationSpriteCache::RefreshSprites(UArticyAsset* ImageAsset, FLocationSpriteCacheEntry& Entry)
+{
+#if WITH_EDITOR
+
+	if (!Entry.Texture)
+		return;
+
+	if (Entry.Sprite)
+		UpdateSprite(Entry.Sprite, Entry, ImageAsset, FLocationSpriteOptions());
+
+	for (FLocationSpriteCacheVariant& variant : Entry.Variants)
+	{
+		if (variant.Sprite)
+			UpdateSprite(variant.Sprite, Entry, ImageAsset, variant.Options);
+	}
+
+#endif // WITH_EDITOR
+}
+
+double ULocationSpriteCache::GetRenderedArea(UPaperSprite* Sprite)
+{
+#if WITH_EDITOR
+
+	FSpriteGeometryCollection* renderGeometry = Sprite ? GetRenderGeometry(Sprite) : nullptr;
+	if (!renderGeometry)
+		return 0;
+
+	TArray<FVector2D> triangles;
+	renderGeometry->Triangulate(triangles, false);
+
+	double area = 0;
+	for (int32 i = 0; i + 2 < triangles.Num(); i += 3)
+		area += FMath::Abs((triangles[i + 1] - triangles[i]) ^ (triangles[i + 2] - triangles[i])) * 0.5;
+
+	return area;
+
+#else
+	return 0;
+#endif // WITH_EDITOR
+}
+
+#if WITH_EDITOR
+
+/* Copies an image into its atlas region and repeats its border pixels into the padding around it */
+static void CopyIntoAtlas(const TArray64<uint8>& Pixels, const FIntPoint& Size, TArray64<uint8>& AtlasPixels, const FIntPoint& AtlasSize, const FIntPoint& Position, int32 Padding)
+{
+	constexpr int32 BytesPerPixel = 4;
+
+	for (int32 y = -Padding; y < Size.Y + Padding; ++y)
+	{
+		const uint8* sourceRow = &Pixels[(int64)FMath::Clamp(y, 0, Size.Y - 1) * Size.X * BytesPerPixel];
+		uint8* atlasRow = &AtlasPixels[((int64)(Position.Y + y) * AtlasSize.X + Position.X) * BytesPerPixel];
+
+		FMemory::Memcpy(atlasRow, sourceRow, Size.X * BytesPerPixel);
+		for (int32 x = 1; x <= Padding; ++x)
+		{
+			FMemory::Memcpy(atlasRow - x * BytesPerPixel, sourceRow, BytesPerPixel);
+			FMemory::Memcpy(atlasRow + (Size.X - 1 + x) * BytesPerPixel, sourceRow + (Size.X - 1) * BytesPerPixel, BytesPerPixel);
+		}
+	}
+}
+
+#endif // WITH_EDITOR
+
+void ULocationSpriteCache::PackAtlases(TArrayView<UArticyAsset* const> ImageAssets, int32 MaxAtlasSize, int32 Padding, FLocationAtlasReport& OutReport)
+{
+#if WITH_EDITOR
+
+	TRACE_CPUPROFILER_EVENT_SCOPE(ULocationSpriteCache::PackAtlases);
+
+	OutReport = FLocationAtlasReport();
+	Padding = FMath::Max(Padding, 0);
+
+	// every image only once, and only images whose source pixels we can copy into an atlas as they are
+	TArray<UArticyAsset*> visitedAssets;
+	TArray<FLocationSpriteCacheEntry*> packedEntries;
+	TArray<FIntPoint> sizes;
+	TSet<FArticyId> visitedIds;
+	uint32 signature = HashCombine(GetTypeHash(MaxAtlasSize), GetTypeHash(Padding));
+
+	for (UArticyAsset* asset : ImageAssets)
+	{
+		if (!asset)
+			continue;
+
+		bool bAlreadyVisited = false;
+		visitedIds.Add(asset->GetId(), &bAlreadyVisited);
+		if (bAlreadyVisited)
+			continue;
+
+		visitedAssets.Add(asset);
+
+		FLocationSpriteCacheEntry* entry = LoadEntry(asset);
+		if (!entry)
+			continue;
+
+		const FTextureSource& source = entry->Texture->Source;
+		const FIntPoint size(source.GetSizeX(), source.GetSizeY());
+		if (!source.IsValid() || source.GetFormat() != TSF_BGRA8 || size.X + 2 * Padding > MaxAtlasSize || size.Y + 2 * Padding > MaxAtlasSize)
+		{
+			entry->Atlas = nullptr;
+			++OutReport.UnpackedImages;
+			continue;
+		}
+
+		packedEntries.Add(entry);
+		sizes.Add(size);
+
+		// the source id changes with every reimport, so the atlases are repacked if any pixels changed
+		signature = HashCombine(signature, HashCombine(GetTypeHash(asset->GetId()), GetTypeHash(source.GetId())));
+	}
+
+	const bool bAllPacked = !packedEntries.ContainsByPredicate([](const FLocationSpriteCacheEntry* Entry) { return !Entry->Atlas; });
+	if (signature == AtlasSignature && bAllPacked)
+	{
+		TSet<UTexture2D*> usedAtlases;
+		for (int32 i = 0; i < packedEntries.Num(); ++i)
+		{
+			bool bAlreadyCounted = false;
+			usedAtlases.Add(packedEntries[i]->Atlas, &bAlreadyCounted);
+			if (!bAlreadyCounted)
+				OutReport.AtlasSizes.Add(FIntPoint(packedEntries[i]->Atlas->Source.GetSizeX(), packedEntries[i]->Atlas->Source.GetSizeY()));
+
+			OutReport.UsedPixels += (int64)sizes[i].X * sizes[i].Y;
+		}
+
+		OutReport.PackedImages = packedEntries.Num();
+		OutReport.bReusedAtlases = true;
+		return;
+	}
+
+	TArray<FLocationAtlasPlacement> placements;
+	TArray<FIntPoint> atlasSizes;
+	FLocationAtlasPacker::Pack(sizes, MaxAtlasSize, Padding, placements, atlasSizes);
+
+	TArray<TArray64<uint8>> atlasPixels;
+	atlasPixels.SetNum(atlasSizes.Num());
+	for (int32 atlas = 0; atlas < atlasSizes.Num(); ++atlas)
+		atlasPixels[atlas].SetNumZeroed((int64)atlasSizes[atlas].X * atlasSizes[atlas].Y * 4);
+
+	// the atlases take over the texture settings of the first image that was packed into them
+	TArray<UTexture2D*> atlasTemplates;
+	atlasTemplates.SetNumZeroed(atlasSizes.Num());
+
+	TArray<bool> bCopied;
+	bCopied.SetNumZeroed(packedEntries.Num());
+
+	TArray64<uint8> mipData;
+	for (int32 i = 0; i < packedEntries.Num(); ++i)
+	{
+		const FLocationAtlasPlacement& placement = placements[i];
+		UTexture2D* texture = packedEntries[i]->Texture;
+		if (placement.Atlas == INDEX_NONE || !texture->Source.GetMipData(mipData, 0, 0, 0) || mipData.Num() < (int64)sizes[i].X * sizes[i].Y * 4)
+		{
+			packedEntries[i]->Atlas = nullptr;
+			++OutReport.UnpackedImages;
+			continue;
+		}
+
+		bCopied[i] = true;
+		CopyIntoAtlas(mipData, sizes[i], atlasPixels[placement.Atlas], atlasSizes[placement.Atlas], placement.Position, Padding);
+		if (!atlasTemplates[placement.Atlas])
+			atlasTemplates[placement.Atlas] = texture;
+	}
+
+	TArray<UTexture2D*> createdAtlases;
+	for (int32 atlas = 0; atlas < atlasSizes.Num(); ++atlas)
+	{
+		UTexture2D* atlasTemplate = atlasTemplates[atlas];
+		if (!atlasTemplate)
+		{
+			createdAtlases.Add(nullptr);
+			continue;
+		}
+
+		FName atlasName = MakeUniqueObjectName(this, UTexture2D::StaticClass(), TEXT("Atlas"));
+		UTexture2D* atlasTexture = NewObject<UTexture2D>(this, atlasName, RF_Public | RF_Transactional);
+		atlasTexture->Source.Init(atlasSizes[atlas].X, atlasSizes[atlas].Y, 1, 1, TSF_BGRA8, atlasPixels[atlas].GetData());
+		atlasTexture->SRGB = atlasTemplate->SRGB;
+		atlasTexture->CompressionSettings = atlasTemplate->CompressionSettings;
+		atlasTexture->LODGroup = atlasTemplate->LODGroup;
+		atlasTexture->Filter = atlasTemplate->Filter;
+		atlasTexture->MipGenSettings = atlasTemplate->MipGenSettings;
+		atlasTexture->AddressX = TextureAddress::TA_Clamp;
+		atlasTexture->AddressY = TextureAddress::TA_Clamp;
+		atlasTexture->PostEditChange();
+
+		Atlases.Add(atlasTexture);
+		createdAtlases.Add(atlasTexture);
+		OutReport.AtlasSizes.Add(atlasSizes[atlas]);
+	}
+
+	for (int32 i = 0; i < packedEntries.Num(); ++i)
+	{
+		if (!bCopied[i])
+			continue;
+
+		FLocationSpriteCacheEntry* entry = packedEntries[i];
+		entry->Atlas = createdAtlases[placements[i].Atlas];
+		entry->AtlasOffset = placements[i].Position;
+		++OutReport.PackedImages;
+		OutReport.UsedPixels += (int64)sizes[i].X * sizes[i].Y;
+	}
+
+	// actors that are kept when reconciling don't ask for their sprite again, so existing sprites have to be updated right away
+	for (UArticyAsset* asset : visitedAssets)
+	{
+		if (FLocationSpriteCacheEntry* entry = Entries.Find(asset->GetId()))
+			RefreshSprites(asset, *entry);
+	}
+
+	AtlasSignature = signature;
+	DiscardUnusedAtlases();
+	MarkPackageDirty();
+
+#endif // WITH_EDITOR
+}
+
+void ULocationSpriteCache::ReleaseFromAtlases(TArrayView<UArticyAsset* const> ImageAssets)
+{
+#if WITH_EDITOR
+
+	for (UArticyAsset* asset : ImageAssets)
+	{
+		FLocationSpriteCacheEntry* entry = asset ? Entries.Find(asset->GetId()) : nullptr;
+		if (!entry || !entry->Atlas)
+			continue;
+
+		entry->Atlas = nullptr;
+
+		// actors that are kept when reconciling don't ask for their sprite again, so it has to be updated right away
+		RefreshSprites(asset, *entry);
+	}
+
+	AtlasSignature = 0;
+	DiscardUnusedAtlases();
+
+#endif // WITH_EDITOR
+}
+
+void ULocationSpriteCache::SaveAtlases(TArrayView<UArticyAsset* const> ImageAssets, FLocationAtlasSnapshot& OutSnapshot) const
+{
+	OutSnapshot = FLocationAtlasSnapshot();
+	OutSnapshot.AtlasSignature = AtlasSignature;
+
+	for (UTexture2D* atlas : Atlases)
+		OutSnapshot.Atlases.Emplace(atlas);
+
+	for (UArticyAsset* asset : ImageAssets)
+	{
+		if (!asset)
+			continue;
+
+		// images without an entry yet use their own texture, if they are packed later that has to be undone too
+		FLocationAtlasSnapshot::FImage& image = OutSnapshot.Images.AddDefaulted_GetRef();
+		image.ImageAsset = asset;
+		if (const FLocationSpriteCacheEntry* entry = Entries.Find(asset->GetId()))
+		{
+			image.Atlas.Reset(entry->Atlas);
+			image.AtlasOffset = entry->AtlasOffset;
+		}
+	}
+}
+
+void ULocationSpriteCache::RestoreAtlases(const FLocationAtlasSnapshot& Snapshot)
+{
+#if WITH_EDITOR
+
+	if (Snapshot.Images.Num() == 0)
+		return;
+
+	for (const TStrongObjectPtr<UTexture2D>& atlas : Snapshot.Atlases)
+	{
+		if (!atlas || Atlases.Contains(atlas.Get()))
+			continue;
+
+		// DiscardUnusedAtlases moved it to the transient package, another atlas may have its name by now
+		atlas->Rename(*MakeUniqueObjectName(this, UTexture2D::StaticClass(), TEXT("Atlas")).ToString(), this, REN_DontCreateRedirectors);
+		Atlases.Add(atlas.Get());
+	}
+
+	for (const FLocationAtlasSnapshot::FImage& image : Snapshot.Images)
+	{
+		FLocationSpriteCacheEntry* entry = Entries.Find(image.ImageAsset->GetId());
+		if (!entry || (entry->Atlas == image.Atlas.Get() && entry->AtlasOffset == image.AtlasOffset))
+			continue;
+
+		entry->Atlas = image.Atlas.Get();
+		entry->AtlasOffset = image.AtlasOffset;
+		RefreshSprites(image.ImageAsset, *entry);
+	}
+
+	AtlasSignature = Snapshot.AtlasSignature;
+	DiscardUnusedAtlases();
+	MarkPackageDirty();
+
+#endif // WITH_EDITOR
+}
+
+void ULocationSpriteCache::DiscardUnusedAtlases()
+{
+#if WITH_EDITOR
+
+	TSet<UTexture2D*> usedAtlases;
+	for (const auto& entry : Entries)
+	{
+		if (entry.Value.Atlas)
+			usedAtlases.Add(entry.Value.Atlas);
+	}
+
+	for (int32 i = Atlases.Num() - 1; i >= 0; --i)
+	{
+		UTexture2D* atlas = Atlases[i];
+		if (atlas && usedAtlases.Contains(atlas))
+			continue;
+
+		// move it out of our package, otherwise it would still be saved with it
+		if (atlas)
+			atlas->Rename(nullptr, GetTransientPackage(), REN_DontCreateRedirectors);
+
+		Atlases.RemoveAt(i);
+		MarkPackageDirty();
+	}
+
+#endif // WITH_EDITOR
+}
+
+ULocationSpriteCache* ULocationSpriteCache::GetOrCreateForActor(AActor* Actor)
+{
+	ULocationSpriteCacheComponent* component = Actor->FindComponentByClass<ULocationSpriteCacheComponent>();
+	if (!component)
+	{
+		component = NewObject<ULocationSpriteCacheComponent>(Actor, TEXT("LocationSpriteCacheComponent"), RF_Transactional);
+		Actor->AddInstanceComponent(component);
+		component->RegisterComponent();
+	}
+
+	// caches of earlier generations were only found by their name inside the actor
+	if (!component->SpriteCache)
+	{
+		component->Modify();
+		component->SpriteCache = GetOrCreateInside(Actor);
+	}
+
+	return component->SpriteCache;
+}
+
+ULocationSpriteCache* ULocationSpriteCache::GetOrCreateInside(UObject* Outer)
+{
+	static const FName CacheName = TEXT("LocationSpriteCache");
+
+	if (auto cache = FindObject<ULocationSpriteCache>(Outer, *CacheName.ToString()))
+		return cache;
+
+	return NewObject<ULocationSpriteCache>(Outer, CacheName, RF_Transactional);
+}
+
+int64 FLocationAtlasReport::GetAtlasPixels() const
+{
+	int64 atlasPixels = 0;
+	for (const FIntPoint& size : AtlasSizes)
+		atlasPixels += (int64)size.X * size.Y;
+	return atlasPixels;
+}
+
+float FLocationAtlasReport::GetOccupancy() const
+{
+	const int64 atlasPixels = GetAtlasPixels();
+	return atlasPixels > 0 ? (float)((double)UsedPixels / atlasPixels) : 0.0f;
+}
@@ -0,0 +1,267 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Engine/DataAsset.h"
+#include "Components/ActorComponent.h"
+#include "Engine/StreamableManager.h"
+#include "UObject/StrongObjectPtr.h"
+#include "ArticyBaseInclude.h"
+#include "LocationSpriteCache.generated.h"
+
+class UMaterialInterface;
+class UPaperSprite;
+class UTexture2D;
+
+/* How an image uses its alpha channel, which decides the material its sprites can be drawn with */
+UENUM()
+enum class ELocationImageAlpha : uint8
+{
+	/* Every pixel is fully opaque */
+	Opaque,
+	/* Pixels are either fully opaque or fully transparent, apart from a few soft edge pixels */
+	Masked,
+	/* The image really blends with what lies behind it */
+	Translucent
+};
+
+/* How a sprite shows its image, the default options show the whole image as a rectangle trimmed to its opaque pixels */
+USTRUCT()
+struct MANIACMANFRED_API FLocationSpriteOptions
+{
+	GENERATED_BODY()
+
+public:
+
+	/* The part of the image the sprite shows in image pixels, the whole image if empty. The sprite is still placed like the whole image. */
+	UPROPERTY(VisibleAnywhere, Category = "Sprite Cache")
+	FIntRect Region = FIntRect();
+
+	/* Fits the render geometry tightly around the pixels that aren't transparent, instead of drawing their bounding rectangle */
+	UPROPERTY(VisibleAnywhere, Category = "Sprite Cache")
+	bool bTightGeometry = false;
+
+	/* Pixels with less alpha than this are cut away by the tight geometry */
+	UPROPERTY(VisibleAnywhere, Category = "Sprite Cache")
+	float AlphaThreshold = 0;
+
+	/* The material the sprite is drawn with, the default sprite material of Paper2D if none */
+	UPROPERTY(VisibleAnywhere, Category = "Sprite Cache")
+	TObjectPtr<UMaterialInterface> Material = nullptr;
+
+	bool IsDefault() const { return *this == FLocationSpriteOptions(); }
+
+	bool operator==(const FLocationSpriteOptions& Other) const
+	{
+		return Region == Other.Region && bTightGeometry == Other.bTightGeometry && (!bTightGeometry || AlphaThreshold == Other.AlphaThreshold) && Material == Other.Material;
+	}
+};
+
+/* A sprite of an image that doesn't use the default options */
+USTRUCT()
+struct MANIACMANFRED_API FLocationSpriteCacheVariant
+{
+	GENERATED_BODY()
+
+public:
+
+	UPROPERTY(VisibleAnywhere, Category = "Sprite Cache")
+	FLocationSpriteOptions Options;
+
+	UPROPERTY(VisibleAnywhere, Category = "Sprite Cache")
+	TObjectPtr<UPaperSprite> Sprite = nullptr;
+};
+
+USTRUCT()
+struct MANIACMANFRED_API FLocationSpriteCacheEntry
+{
+	GENERATED_BODY()
+
+public:
+
+	UPROPERTY(VisibleAnywhere, Category = "Sprite Cache")
+	TObjectPtr<UTexture2D> Texture = nullptr;
+
+	UPROPERTY(VisibleAnywhere, Category = "Sprite Cache")
+	TObjectPtr<UPaperSprite> Sprite = nullptr;
+
+	/* Sprites showing only a part of the image or using a tight render geometry */
+	UPROPERTY(VisibleAnywhere, Category = "Sprite Cache")
+	TArray<FLocationSpriteCacheVariant> Variants;
+
+	/* The atlas the image was packed into, the sprite uses the texture itself if there is none */
+	UPROPERTY(VisibleAnywhere, Category = "Sprite Cache")
+	TObjectPtr<UTexture2D> Atlas = nullptr;
+
+	/* Where the image lies inside the atlas, in pixels */
+	UPROPERTY(VisibleAnywhere, Category = "Sprite Cache")
+	FIntPoint AtlasOffset = FIntPoint::ZeroValue;
+
+	/* Share of the image pixels that are fully transparent and that are neither transparent nor opaque, see ULocationSpriteCache::ClassifyAlpha */
+	UPROPERTY(VisibleAnywhere, Category = "Sprite Cache")
+	float TransparentShare = 0;
+
+	UPROPERTY(VisibleAnywhere, Category = "Sprite Cache")
+	float PartialAlphaShare = 1;
+
+	/* The source the shares were computed from, a reimport changes it and the image is analyzed again */
+	UPROPERTY()
+	FGuid AlphaSourceId;
+};
+
+/* What packing the images of a location into atlases resulted in */
+struct MANIACMANFRED_API FLocationAtlasReport
+{
+	/* Images that are shown from an atlas now */
+	int32 PackedImages = 0;
+	/* Images that keep their own texture, because they are too big for an atlas or their source data can't be copied */
+	int32 UnpackedImages = 0;
+	/* Pixels of the packed images, without padding */
+	int64 UsedPixels = 0;
+	/* Size of every atlas the images were packed into */
+	TArray<FIntPoint> AtlasSizes;
+	/* The images and settings didn't change since the last packing, so the existing atlases were kept */
+	bool bReusedAtlases = false;
+
+	int64 GetAtlasPixels() const;
+	/* Share of the atlas pixels that are covered by images */
+	float GetOccupancy() const;
+};
+
+/* Which atlas some images were packed into, see ULocationSpriteCache::SaveAtlases */
+struct MANIACMANFRED_API FLocationAtlasSnapshot
+{
+	struct FImage
+	{
+		UArticyAsset* ImageAsset = nullptr;
+		/* Null if the image used its own texture */
+		TStrongObjectPtr<UTexture2D> Atlas;
+		FIntPoint AtlasOffset = FIntPoint::ZeroValue;
+	};
+
+	TArray<FImage> Images;
+	/* Every atlas of the cache, packing may discard them in the meantime */
+	TArray<TStrongObjectPtr<UTexture2D>> Atlases;
+	uint32 AtlasSignature = 0;
+};
+
+/* Maps articy image assets to their loaded texture and a sprite that all location images showing this asset share.
+*  The LocationGenerator creates a cache inside the generating actor if none is assigned in the settings,
+*  but you can also create a cache asset to share the sprites between several locations.
+*/
+UCLASS(BlueprintType)
+class MANIACMANFRED_API ULocationSpriteCache : public UDataAsset
+{
+	GENERATED_BODY()
+
+public:
+
+	/* Returns the shared sprite for an image asset, loading its texture and creating the sprite only the first time it is requested */
+	UPaperSprite* GetOrCreateSprite(UArticyAsset* ImageAsset, const FLocationSpriteOptions& Options = FLocationSpriteOptions());
+
+	/* The area of the texture a sprite draws in pixels, which is what it costs to fill */
+	static double GetRenderedArea(UPaperSprite* Sprite);
+
+	/* Packs the textures of image assets into as few atlases as possible, the sprites of these assets show their atlas region afterwards.
+	*  Images that are bigger than MaxAtlasSize keep their own texture, the padding around every image repeats its border pixels so filtering doesn't bleed neighbours in.
+	*/
+	void PackAtlases(TArrayView<UArticyAsset* const> ImageAssets, int32 MaxAtlasSize, int32 Padding, FLocationAtlasReport& OutReport);
+
+	/* Lets the sprites of these image assets show their own textures again, atlases nobody uses anymore are discarded */
+	void ReleaseFromAtlases(TArrayView<UArticyAsset* const> ImageAssets);
+
+	bool HasAtlases() const { return Atlases.Num() > 0; }
+
+	/* Remembers which atlases these image assets are packed into, so RestoreAtlases can undo a packing that was abandoned */
+	void SaveAtlases(TArrayView<UArticyAsset* const> ImageAssets, FLocationAtlasSnapshot& OutSnapshot) const;
+
+	/* Packs the saved image assets back into the atlases they were in, atlases packing had discarded return into the cache */
+	void RestoreAtlases(const FLocationAtlasSnapshot& Snapshot);
+
+	/* Analyzes the source pixels of an image asset once and tells how it uses its alpha.
+	*  Images with at most MaskedTolerance of their pixels partially transparent, e.g. anti-aliased edges, still count as masked.
+	*  Images whose source pixels can't be read count as translucent.
+	*/
+	ELocationImageAlpha ClassifyAlpha(UArticyAsset* ImageAsset, float MaskedTolerance);
+
+	/* False if the sprite is drawn with an opaque or masked material, which writes depth and therefore doesn't need a translucent sort priority */
+	static bool NeedsSortPriority(const UPaperSprite* Sprite);
+
+	/* Returns the texture of an image asset, loading it if necessary */
+	UTexture2D* GetOrLoadTexture(UArticyAsset* ImageAsset);
+
+	/* True if the sprite of this image asset shows a region of an atlas instead of the texture itself */
+	bool IsPacked(UArticyAsset* ImageAsset) const;
+
+	/* Starts loading the textures of image assets that aren't loaded yet through the streamable manager, so they arrive in parallel instead of one after another.
+	*  GetOrCreateSprite only waits for the texture it needs, images whose texture path can't be resolved are still loaded synchronously when requested.
+	*  Returns how many loads were started.
+	*/
+	int32 RequestTextures(TArrayView<UArticyAsset* const> ImageAssets);
+
+	/* The path the articy importer put the texture or sound of an asset at, without loading it. Empty if the asset has no file. */
+	static FSoftObjectPath GetAssetPath(const UArticyAsset* Asset);
+
+	/* True if GetOrCreateSprite doesn't have to wait for the texture of this asset anymore */
+	bool IsTextureReady(UArticyAsset* ImageAsset) const;
+
+	/* Forgets the requested loads no sprite was created for, the textures stay loaded as long as something else references them */
+	void ReleaseTextureRequests();
+
+	/* Returns the cache of an actor's ULocationSpriteCacheComponent, adding the component and creating a new cache if there is none yet */
+	static ULocationSpriteCache* GetOrCreateForActor(AActor* Actor);
+
+	/* Returns the cache stored inside any other object, creating a new one if there is none yet.
+	*  Nothing but its outer references it, so the caller has to keep it in a property of its own (see ULocationCookedLayout::SpriteCache).
+	*/
+	static ULocationSpriteCache* GetOrCreateInside(UObject* Outer);
+
+	int32 GetTextureLoads() const { return TextureLoads; }
+	int32 GetSpritesCreated() const { return SpritesCreated; }
+	/* How many of the texture loads were streamed asynchronously */
+	int32 GetTexturesStreamed() const { return TexturesStreamed; }
+
+private:
+
+	/* Finds or adds the entry of an image asset and loads its texture, returns nullptr if the asset has no texture */
+	FLocationSpriteCacheEntry* LoadEntry(UArticyAsset* ImageAsset);
+
+	/* Creates or updates the sprite in Slot, so it shows the image of the entry as the options say */
+	UPaperSprite* UpdateSprite(TObjectPtr<UPaperSprite>& Slot, FLocationSpriteCacheEntry& Entry, UArticyAsset* ImageAsset, const FLocationSpriteOptions& Options);
+
+	/* Updates every sprite of an entry that exists already, e.g. after the image was (un)packed */
+	void RefreshSprites(UArticyAsset* ImageAsset, FLocationSpriteCacheEntry& Entry);
+
+	/* Drops atlases that no entry points to anymore */
+	void DiscardUnusedAtlases();
+
+	UPROPERTY(VisibleAnywhere, Category = "Sprite Cache")
+	TMap<FArticyId, FLocationSpriteCacheEntry> Entries;
+
+	UPROPERTY(VisibleAnywhere, Category = "Sprite Cache")
+	TArray<TObjectPtr<UTexture2D>> Atlases;
+
+	/* Hash of the images and settings of the last packing */
+	UPROPERTY()
+	uint32 AtlasSignature = 0;
+
+	/* Texture loads started by RequestTextures, which no entry took over yet */
+	TMap<FArticyId, TSharedPtr<FStreamableHandle>> TextureRequests;
+
+	int32 TextureLoads = 0;
+	int32 TexturesStreamed = 0;
+	int32 SpritesCreated = 0;
+};
+
+/* Holds the sprite cache of the actor generating a location, so the cache is referenced by the actor and saved with its level */
+UCLASS(ClassGroup = "Location Generator")
+class MANIACMANFRED_API ULocationSpriteCacheComponent : public UActorComponent
+{
+	GENERATED_BODY()
+
+public:
+
+	UPROPERTY(VisibleAnywhere, Category = "Sprite Cache")
+	TObjectPtr<ULocationSpriteCache> SpriteCache = nullptr;
+};
@@ -0,0 +1,168 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#include "LocationTextureBudget.h"
+#include "Engine/Texture2D.h"
+
+int64 FLocationTextureBudgetReport::GetBytesBefore() const
+{
+	int64 bytes = 0;
+	for (const FLocationTextureBudgetEntry& entry : Entries)
+		bytes += entry.BytesBefore;
+	return bytes;
+}
+
+int64 FLocationTextureBudgetReport::GetBytesAfter() const
+{
+	int64 bytes = 0;
+	for (const FLocationTextureBudgetEntry& entry : Entries)
+		bytes += entry.BytesAfter;
+	return bytes;
+}
+
+int32 FLocationTextureBudgetReport::GetChangedTextures() const
+{
+	return Entries.FilterByPredicate([](const FLocationTextureBudgetEntry& Entry) { return Entry.bChanged; }).Num();
+}
+
+int32 FLocationTextureBudgetReport::GetSharedTextures() const
+{
+	return Entries.FilterByPredicate([](const FLocationTextureBudgetEntry& Entry) { return Entry.bShared; }).Num();
+}
+
+/* The size a texture ends up with, a max texture size drops its top mips until it fits */
+static FIntPoint GetReducedSize(FIntPoint Size, int32 MaxTextureSize)
+{
+	if (MaxTextureSize <= 0)
+		return Size;
+
+	while (FMath::Max(Size.X, Size.Y) > MaxTextureSize && (Size.X > 1 || Size.Y > 1))
+		Size = FIntPoint(FMath::Max(Size.X / 2, 1), FMath::Max(Size.Y / 2, 1));
+
+	return Size;
+}
+
+FLocationTextureBudgetDecision FLocationTextureBudget::Decide(const FIntPoint& SourceSize, const FVector2D& MaxScreenSize, const FVector2D& MinScreenSize, bool bHasAlpha)
+{
+	FLocationTextureBudgetDecision decision;
+	decision.bHasAlpha = bHasAlpha;
+
+	if (SourceSize.X <= 0 || SourceSize.Y <= 0)
+		return decision;
+
+	// an image might be stretched, so the axis that is drawn biggest compared to its pixels decides
+	const int32 sourceLargest = FMath::Max(SourceSize.X, SourceSize.Y);
+	const double maxRatio = FMath::Max(MaxScreenSize.X / SourceSize.X, MaxScreenSize.Y / SourceSize.Y);
+	const int32 requiredSize = FMath::CeilToInt(maxRatio * sourceLargest);
+	if (requiredSize > 0 && requiredSize < sourceLargest)
+	{
+		const int32 maxTextureSize = (int32)FMath::RoundUpToPowerOfTwo(requiredSize);
+		decision.MaxTextureSize = maxTextureSize < sourceLargest ? maxTextureSize : 0;
+	}
+
+	// reducing the size needs the mip chain, otherwise we only need mips if the image is ever drawn at less than half of its pixels
+	const FIntPoint reducedSize = GetReducedSize(SourceSize, decision.MaxTextureSize);
+	const double minRatio = FMath::Min(MinScreenSize.X / reducedSize.X, MinScreenSize.Y / reducedSize.Y);
+	decision.bGenerateMips = decision.MaxTextureSize > 0 || minRatio < 0.5;
+
+	return decision;
+}
+
+int64 FLocationTextureBudget::EstimateMemory(const UTexture2D* Texture)
+{
+#if WITH_EDITORONLY_DATA
+
+	if (!Texture || !Texture->Source.IsValid())
+		return 0;
+
+	const FIntPoint size = GetReducedSize(FIntPoint(Texture->Source.GetSizeX(), Texture->Source.GetSizeY()), Texture->MaxTextureSize);
+
+	int32 bitsPerPixel;
+	switch (Texture->CompressionSettings)
+	{
+	case TC_Default:
+		// DXT1 without alpha, DXT5 with alpha
+		bitsPerPixel = Texture->CompressionNoAlpha ? 4 : 8;
+		break;
+	case TC_Normalmap:
+	case TC_Masks:
+	case TC_Grayscale:
+	case TC_Alpha:
+	case TC_DistanceFieldFont:
+	case TC_HDR_Compressed:
+	case TC_BC7:
+		bitsPerPixel = 8;
+		break;
+	case TC_HDR:
+		bitsPerPixel = 64;
+		break;
+	default:
+		// e.g. UserInterface2D, which isn't compressed at all
+		bitsPerPixel = 32;
+		break;
+	}
+
+	int64 bytes = (int64)size.X * size.Y * bitsPerPixel / 8;
+
+	// the whole mip chain adds another third
+	if (Texture->MipGenSettings != TMGS_NoMipmaps)
+		bytes += bytes / 3;
+
+	return bytes;
+
+#else
+	return 0;
+#endif // WITH_EDITORONLY_DATA
+}
+
+bool FLocationTextureBudget::HasAlpha(UTexture2D* Texture)
+{
+#if WITH_EDITORONLY_DATA
+
+	TArray64<uint8> mipData;
+	if (!Texture->Source.IsValid() || Texture->Source.GetFormat() != TSF_BGRA8 || !Texture->Source.GetMipData(mipData, 0, 0, 0))
+		return true;
+
+	for (int64 i = 3; i < mipData.Num(); i += 4)
+	{
+		if (mipData[i] != 255)
+			return true;
+	}
+
+	return false;
+
+#else
+	return true;
+#endif // WITH_EDITORONLY_DATA
+}
+
+bool FLocationTextureBudget::Apply(UTexture2D* Texture, const FLocationTextureBudgetDecision& Decision)
+{
+#if WITH_EDITORONLY_DATA
+
+	// textures without mips stay fully loaded in the UI group, which device profiles don't bias, the others can still be streamed and biased on low end devices
+	const TextureMipGenSettings mipGenSettings = Decision.bGenerateMips ? TMGS_FromTextureGroup : TMGS_NoMipmaps;
+	const TextureGroup lodGroup = Decision.bGenerateMips ? TEXTUREGROUP_World : TEXTUREGROUP_UI;
+
+	// other compressions were chosen on purpose, e.g. UserInterface2D for pixel art, only DXT1 or DXT5 depends on the alpha
+	const bool bCompressionNoAlpha = Texture->CompressionSettings == TC_Default ? !Decision.bHasAlpha : (bool)Texture->CompressionNoAlpha;
+
+	if (Texture->MaxTextureSize == Decision.MaxTextureSize && Texture->CompressionNoAlpha == bCompressionNoAlpha
+		&& Texture->MipGenSettings == mipGenSettings && Texture->LODGroup == lodGroup)
+	{
+		return false;
+	}
+
+	Texture->Modify();
+	Texture->MaxTextureSize = Decision.MaxTextureSize;
+	Texture->CompressionNoAlpha = bCompressionNoAlpha;
+	Texture->MipGenSettings = mipGenSettings;
+	Texture->LODGroup = lodGroup;
+	Texture->PostEditChange();
+	Texture->MarkPackageDirty();
+
+	return true;
+
+#else
+	return false;
+#endif // WITH_EDITORONLY_DATA
+}
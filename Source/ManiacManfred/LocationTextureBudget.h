@@ -0,0 +1,70 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+
+class UTexture2D;
+
+/* The texture settings the budget pass chose for a single texture */
+struct MANIACMANFRED_API FLocationTextureBudgetDecision
+{
+	/* 0 if the texture keeps its full resolution */
+	int32 MaxTextureSize = 0;
+	bool bHasAlpha = true;
+	bool bGenerateMips = false;
+};
+
+/* What the budget pass found out about a single texture */
+struct MANIACMANFRED_API FLocationTextureBudgetEntry
+{
+	FString Texture;
+	FIntPoint SourceSize = FIntPoint::ZeroValue;
+	/* The biggest and smallest size in screen pixels an image shows the texture with, over all images and target resolutions */
+	FVector2D MaxScreenSize = FVector2D::ZeroVector;
+	FVector2D MinScreenSize = FVector2D::ZeroVector;
+	FLocationTextureBudgetDecision Decision;
+	/* Estimated memory of the texture with all its mips, before and after the pass */
+	int64 BytesBefore = 0;
+	int64 BytesAfter = 0;
+	/* The texture settings were actually changed, otherwise they already matched */
+	bool bChanged = false;
+	/* Other locations show the texture too, so it was left alone */
+	bool bShared = false;
+};
+
+/* What the texture budget pass did for a location */
+struct MANIACMANFRED_API FLocationTextureBudgetReport
+{
+	TArray<FLocationTextureBudgetEntry> Entries;
+	/* Images that are drawn from an atlas, their own textures aren't rendered and were left alone */
+	int32 PackedImages = 0;
+
+	int64 GetBytesBefore() const;
+	int64 GetBytesAfter() const;
+	int32 GetChangedTextures() const;
+	int32 GetSharedTextures() const;
+};
+
+/* Sizes the textures of location images to the biggest size they are ever drawn with, instead of the resolution the artist exported.
+*  Location images are drawn with a fixed scale by an orthographic camera, so the screen size is known in advance:
+*  a texture bigger than its screen size only costs memory, mips are only needed if the image is drawn at less than half its size.
+*/
+struct MANIACMANFRED_API FLocationTextureBudget
+{
+public:
+
+	/* Chooses the settings for a texture of the given size that is drawn at most MaxScreenSize and at least MinScreenSize big */
+	static FLocationTextureBudgetDecision Decide(const FIntPoint& SourceSize, const FVector2D& MaxScreenSize, const FVector2D& MinScreenSize, bool bHasAlpha);
+
+	/* Estimates the memory of a texture with its current settings, using the block sizes of the desktop formats */
+	static int64 EstimateMemory(const UTexture2D* Texture);
+
+	/* True if any pixel of the source data isn't fully opaque, sources that can't be read are treated as having alpha */
+	static bool HasAlpha(UTexture2D* Texture);
+
+	/* Applies a decision to a texture, only touching its package if a setting really changes. Returns true if it changed.
+	*  The compression settings are kept, the alpha of the decision only drops the alpha channel of textures with the default compression.
+	*/
+	static bool Apply(UTexture2D* Texture, const FLocationTextureBudgetDecision& Decision);
+};
@@ -0,0 +1,21 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "UObject/Interface.h"
+#include "LocationZoneBehaviour.generated.h"
+
+UINTERFACE(MinimalAPI, Blueprintable)
+class ULocationZoneBehaviour : public UInterface
+{
+	GENERATED_BODY()
+};
+
+/* Marks a component of the ObjectComponentMap as zone behaviour (e.g. the ClickableZone Blueprint, add it in its class settings).
+*  The LocationGenerator gives actors with such a component a collider built from the zone polygon and positions them by the raw bounds of the zone.
+*/
+class MANIACMANFRED_API ILocationZoneBehaviour
+{
+	GENERATED_BODY()
+};
@@ -14,8 +14,8 @@ public class ManiacManfred : ModuleRules
 		
 		PrivateDependencyModuleNames.AddRange(new string[] { "Json" });
 
-		// Uncomment if you are using Slate UI
-		// PrivateDependencyModuleNames.AddRange(new string[] { "Slate", "SlateCore" });
+		// the progress notification of ULocationGenerationSubsystem
+		PrivateDependencyModuleNames.AddRange(new string[] { "Slate", "SlateCore" });
 		
 		// Uncomment if you are using online features
 		// PrivateDependencyModuleNames.Add("OnlineSubsystem");
@@ -0,0 +1,153 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#include "ExpressoBytecode.h"
+#include "ArticyDatabase.h"
+#include "ArticyScriptFragment.h"
+#include "ArticyGenerated/ManiacManfredGlobalVariables.h"
+#include "Misc/AutomationTest.h"
+#include "UObject/Package.h"
+#include "UObject/UObjectIterator.h"
+
+#if WITH_DEV_AUTOMATION_TESTS
+
+/* Compiles the scripts of the articy database against global variables of their own, so the tests can change them without touching the asset */
+static bool BuildTestScripts(FAutomationTestBase& Test, FExpressoBytecodeScripts& OutScripts)
+{
+	if (!UArticyDatabase::GetMutableOriginal())
+	{
+		Test.AddError(TEXT("Could not load the articy database."));
+		return false;
+	}
+
+	OutScripts.Build(NewObject<UManiacManfredGlobalVariables>(GetTransientPackage()));
+	return true;
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FExpressoBytecodeMatchesLambdasTest, "ManiacManfred.ExpressoBytecode.MatchesLambdas", EAutomationTestFlags_ApplicationContextMask | EAutomationTestFlags::ProductFilter)
+
+bool FExpressoBytecodeMatchesLambdasTest::RunTest(const FString& Parameters)
+{
+	FExpressoBytecodeScripts scripts;
+	if (!BuildTestScripts(*this, scripts))
+		return false;
+
+	const FExpressoBytecodeComparison comparison = FExpressoBytecodeComparison::Run(scripts, 64, 1);
+	for (const FString& description : comparison.Descriptions)
+		AddError(description);
+
+	AddInfo(FString::Printf(TEXT("%d programs compared with %d samples."), scripts.NumPrograms(), comparison.Samples));
+	TestEqual(TEXT("Samples giving different results"), comparison.Mismatches, 0);
+
+	return true;
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FExpressoBytecodeOutdatedStoreTest, "ManiacManfred.ExpressoBytecode.OutdatedStore", EAutomationTestFlags_ApplicationContextMask | EAutomationTestFlags::ProductFilter)
+
+bool FExpressoBytecodeOutdatedStoreTest::RunTest(const FString& Parameters)
+{
+	FExpressoBytecodeScripts scripts;
+	if (!BuildTestScripts(*this, scripts))
+		return false;
+
+	FExpressoVariableStore& store = scripts.GetStore();
+	UArticyGlobalVariables* globalVariables = store.GetGlobalVariables();
+
+	// a condition has to see the global variables as they are once the store was invalidated, even if it still holds other values
+	UArticyScriptCondition* condition = nullptr;
+	for (TObjectIterator<UArticyScriptCondition> it; it && !condition; ++it)
+		condition = scripts.FindCondition(*it) != INDEX_NONE ? *it : nullptr;
+
+	if (condition)
+	{
+		const FExpressoBytecodeScripts::FProgram& program = scripts.GetProgram(scripts.FindCondition(condition));
+		for (int32 state = 0; state < 2; ++state)
+		{
+			for (int32 variable : program.Variables)
+				store.Values[variable] = state;
+			store.Flush();
+
+			for (int32 variable : program.Variables)
+				store.Values[variable] = 1 - state;
+			store.Invalidate();
+
+			TestEqual(FString::Printf(TEXT("%s with outdated store"), *condition->GetExpression().TrimStartAndEnd()),
+				scripts.Evaluate(condition), condition->Evaluate(globalVariables, nullptr));
+		}
+	}
+	else
+	{
+		AddWarning(TEXT("No condition was compiled."));
+	}
+
+	// an instruction must not write back outdated values of variables it doesn't use
+	UArticyScriptInstruction* instruction = nullptr;
+	for (TObjectIterator<UArticyScriptInstruction> it; it && !instruction; ++it)
+		instruction = scripts.FindInstruction(*it) != INDEX_NONE ? *it : nullptr;
+
+	if (instruction)
+	{
+		const FExpressoBytecodeScripts::FProgram& program = scripts.GetProgram(scripts.FindInstruction(instruction));
+		int32 unused = INDEX_NONE;
+		for (int32 variable = 0; variable < store.Num() && unused == INDEX_NONE; ++variable)
+			unused = program.Variables.Contains(variable) ? INDEX_NONE : variable;
+
+		if (unused != INDEX_NONE)
+		{
+			const int32 value = store.IsBool(unused) ? 1 : 7;
+			store.Values[unused] = value;
+			store.Flush();
+
+			store.Values[unused] = 0;
+			scripts.Execute(instruction);
+			store.Gather();
+
+			TestEqual(FString::Printf(TEXT("%s after %s"), *store.GetName(unused), *instruction->GetExpression().TrimStartAndEnd()), store.Values[unused], value);
+		}
+	}
+	else
+	{
+		AddWarning(TEXT("No instruction was compiled."));
+	}
+
+	return true;
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FExpressoBytecodeStoreStaysCurrentTest, "ManiacManfred.ExpressoBytecode.StoreStaysCurrent", EAutomationTestFlags_ApplicationContextMask | EAutomationTestFlags::ProductFilter)
+
+bool FExpressoBytecodeStoreStaysCurrentTest::RunTest(const FString& Parameters)
+{
+	FExpressoBytecodeScripts scripts;
+	if (!BuildTestScripts(*this, scripts))
+		return false;
+
+	FExpressoVariableStore& store = scripts.GetStore();
+
+	// every compiled instruction writes through, so gathering afterwards must not find anything the store doesn't know yet
+	int32 executed = 0;
+	TSet<int32> instructionHashes;
+	for (TObjectIterator<UArticyScriptInstruction> it; it; ++it)
+	{
+		bool bAlreadyInSet = false;
+		instructionHashes.Add(it->GetExpressionHash(), &bAlreadyInSet);
+		if (bAlreadyInSet || scripts.FindInstruction(*it) == INDEX_NONE)
+			continue;
+
+		scripts.Execute(*it);
+		++executed;
+
+		const TArray<int32> values = store.Values;
+		store.Gather();
+		if (values != store.Values)
+		{
+			AddError(FString::Printf(TEXT("The store is outdated after %s."), *it->GetExpression().TrimStartAndEnd()));
+			break;
+		}
+	}
+
+	if (executed == 0)
+		AddWarning(TEXT("No instruction was compiled."));
+
+	return true;
+}
+
+#endif // WITH_DEV_AUTOMATION_TESTS
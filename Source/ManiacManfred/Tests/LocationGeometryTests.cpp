@@ -0,0 +1,248 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#include "LocationGeometry.h"
+#include "Algo/Reverse.h"
+#include "Math/RandomStream.h"
+#include "Misc/AutomationTest.h"
+
+#if WITH_DEV_AUTOMATION_TESTS
+
+/* Positive for counter clockwise polygons */
+static double GetSignedArea(TArrayView<const FVector2D> Polygon)
+{
+	double area = 0;
+	for (int32 i = 0; i < Polygon.Num(); ++i)
+		area += Polygon[i] ^ Polygon[(i + 1) % Polygon.Num()];
+	return area / 2;
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FLocationGeometryEmptyTest, "ManiacManfred.LocationGeometry.Empty", EAutomationTestFlags_ApplicationContextMask | EAutomationTestFlags::ProductFilter)
+
+bool FLocationGeometryEmptyTest::RunTest(const FString& Parameters)
+{
+	TArray<FVector2D> vertices;
+	TArray<FVector2D> transformed;
+
+	TestFalse(TEXT("Bounds of no vertices are invalid"), LocationGeometry::ComputeBounds(vertices).bIsValid);
+	TestFalse(TEXT("Transformed bounds of no vertices are invalid"), LocationGeometry::TransformAndComputeBounds(vertices, FVector2D(2, 2), FVector2D(1, 1), transformed).bIsValid);
+	TestFalse(TEXT("Transforming invalid bounds keeps them invalid"), LocationGeometry::TransformBounds(FBox2D(ForceInit), FVector2D(2, -2), FVector2D(1, 1)).bIsValid);
+	TestFalse(TEXT("No point lies inside an empty polygon"), LocationGeometry::IsPointInPolygon(FVector2D::ZeroVector, vertices));
+
+	return true;
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FLocationGeometrySingleVertexTest, "ManiacManfred.LocationGeometry.SingleVertex", EAutomationTestFlags_ApplicationContextMask | EAutomationTestFlags::ProductFilter)
+
+bool FLocationGeometrySingleVertexTest::RunTest(const FString& Parameters)
+{
+	const TArray<FVector2D> vertices = { FVector2D(3, -4) };
+	TArray<FVector2D> transformed;
+	transformed.SetNumZeroed(1);
+
+	const FBox2D bounds = LocationGeometry::ComputeBounds(vertices);
+	TestTrue(TEXT("Bounds of a single vertex are valid"), bounds.bIsValid);
+	TestEqual(TEXT("Minimum is the vertex"), bounds.Min, vertices[0]);
+	TestEqual(TEXT("Maximum is the vertex"), bounds.Max, vertices[0]);
+
+	const FBox2D transformedBounds = LocationGeometry::TransformAndComputeBounds(vertices, FVector2D(2, 0.5), FVector2D(1, 1), transformed);
+	TestEqual(TEXT("Bounds are the ones of the untransformed vertex"), transformedBounds.Min, vertices[0]);
+	TestEqual(TEXT("The vertex is scaled and offset"), transformed[0], FVector2D(7, -1));
+
+	return true;
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FLocationGeometryOddCountTest, "ManiacManfred.LocationGeometry.OddVertexCounts", EAutomationTestFlags_ApplicationContextMask | EAutomationTestFlags::ProductFilter)
+
+bool FLocationGeometryOddCountTest::RunTest(const FString& Parameters)
+{
+	// the kernels handle two vertices per register, the last vertex of an odd count is handled on its own, so it is the extreme one here
+	FRandomStream random(1);
+	const FVector2D scale(0.5, -0.5);
+	const FVector2D offset(10, 20);
+
+	for (int32 num = 1; num <= 9; num += 2)
+	{
+		TArray<FVector2D> vertices;
+		for (int32 i = 0; i < num - 1; ++i)
+			vertices.Add(FVector2D(random.FRandRange(-10, 10), random.FRandRange(-10, 10)));
+		vertices.Add(FVector2D(100, -100));
+
+		TArray<FVector2D> transformed;
+		transformed.SetNumZeroed(num);
+
+		const FBox2D expected = LocationGeometry::ComputeReferenceBounds(vertices);
+		TestEqual(FString::Printf(TEXT("Bounds of %d vertices"), num), LocationGeometry::ComputeBounds(vertices), expected);
+		TestEqual(FString::Printf(TEXT("Transformed bounds of %d vertices"), num), LocationGeometry::TransformAndComputeBounds(vertices, scale, offset, transformed), expected);
+
+		// the kernels may use fused multiply-adds, which round differently in the last bit
+		for (int32 i = 0; i < num; ++i)
+			TestTrue(FString::Printf(TEXT("Vertex %d of %d"), i, num), transformed[i].Equals(vertices[i] * scale + offset, KINDA_SMALL_NUMBER));
+
+		const FBox2D transformedBounds = LocationGeometry::TransformBounds(expected, scale, offset);
+		const FBox2D expectedTransformedBounds = LocationGeometry::ComputeReferenceBounds(transformed);
+		TestTrue(FString::Printf(TEXT("Transformed bounds of %d vertices without touching them"), num),
+			transformedBounds.Min.Equals(expectedTransformedBounds.Min, KINDA_SMALL_NUMBER) && transformedBounds.Max.Equals(expectedTransformedBounds.Max, KINDA_SMALL_NUMBER));
+	}
+
+	return true;
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FLocationGeometryNegativeTest, "ManiacManfred.LocationGeometry.NegativeCoordinates", EAutomationTestFlags_ApplicationContextMask | EAutomationTestFlags::ProductFilter)
+
+bool FLocationGeometryNegativeTest::RunTest(const FString& Parameters)
+{
+	// FRect::GetBounds used to start the maximum at 0, which gave a maximum of 0 for polygons left of or above the origin
+	const TArray<FVector2D> vertices = { FVector2D(-30, -20), FVector2D(-10, -25), FVector2D(-5, -8), FVector2D(-28, -2) };
+
+	const FBox2D bounds = LocationGeometry::ComputeBounds(vertices);
+	TestEqual(TEXT("Minimum"), bounds.Min, FVector2D(-30, -25));
+	TestEqual(TEXT("Maximum"), bounds.Max, FVector2D(-5, -2));
+
+	// the y-flip swaps minimum and maximum
+	const FBox2D flipped = LocationGeometry::TransformBounds(bounds, FVector2D(1, -1), FVector2D::ZeroVector);
+	TestEqual(TEXT("Flipped minimum"), flipped.Min, FVector2D(-30, 2));
+	TestEqual(TEXT("Flipped maximum"), flipped.Max, FVector2D(-5, 25));
+
+	return true;
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FLocationGeometryPointInConcaveTest, "ManiacManfred.LocationGeometry.PointInConcavePolygon", EAutomationTestFlags_ApplicationContextMask | EAutomationTestFlags::ProductFilter)
+
+bool FLocationGeometryPointInConcaveTest::RunTest(const FString& Parameters)
+{
+	// a U shape, open at the top
+	TArray<FVector2D> polygon = { FVector2D(0, 0), FVector2D(30, 0), FVector2D(30, 30), FVector2D(20, 30), FVector2D(20, 10), FVector2D(10, 10), FVector2D(10, 30), FVector2D(0, 30) };
+
+	for (int32 winding = 0; winding < 2; ++winding)
+	{
+		const TCHAR* windingName = winding == 0 ? TEXT("counter clockwise") : TEXT("clockwise");
+
+		TestTrue(FString::Printf(TEXT("Bottom of the U (%s)"), windingName), LocationGeometry::IsPointInPolygon(FVector2D(15, 5), polygon));
+		TestTrue(FString::Printf(TEXT("Left arm (%s)"), windingName), LocationGeometry::IsPointInPolygon(FVector2D(5, 25), polygon));
+		TestTrue(FString::Printf(TEXT("Right arm (%s)"), windingName), LocationGeometry::IsPointInPolygon(FVector2D(25, 25), polygon));
+		TestFalse(FString::Printf(TEXT("Inside the notch (%s)"), windingName), LocationGeometry::IsPointInPolygon(FVector2D(15, 20), polygon));
+		TestFalse(FString::Printf(TEXT("Outside the bounds (%s)"), windingName), LocationGeometry::IsPointInPolygon(FVector2D(40, 5), polygon));
+
+		Algo::Reverse(polygon);
+	}
+
+	TestFalse(TEXT("A U shape isn't convex"), LocationGeometry::IsConvex(polygon));
+
+	return true;
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FLocationGeometryIsConvexTest, "ManiacManfred.LocationGeometry.IsConvex", EAutomationTestFlags_ApplicationContextMask | EAutomationTestFlags::ProductFilter)
+
+bool FLocationGeometryIsConvexTest::RunTest(const FString& Parameters)
+{
+	TArray<FVector2D> square = { FVector2D(0, 0), FVector2D(10, 0), FVector2D(10, 10), FVector2D(0, 10) };
+	TestTrue(TEXT("A square is convex"), LocationGeometry::IsConvex(square));
+	Algo::Reverse(square);
+	TestTrue(TEXT("A clockwise square is convex"), LocationGeometry::IsConvex(square));
+
+	const TArray<FVector2D> collinear = { FVector2D(0, 0), FVector2D(5, 0), FVector2D(10, 0), FVector2D(10, 10), FVector2D(0, 10) };
+	TestTrue(TEXT("A collinear vertex keeps a polygon convex"), LocationGeometry::IsConvex(collinear));
+
+	// every vertex turns the same way, but the outline winds around twice
+	TArray<FVector2D> pentagram;
+	for (int32 i = 0; i < 5; ++i)
+	{
+		const double angle = i * 2 * UE_DOUBLE_TWO_PI / 5;
+		pentagram.Add(FVector2D(FMath::Cos(angle), FMath::Sin(angle)) * 10);
+	}
+	TestFalse(TEXT("A pentagram isn't convex"), LocationGeometry::IsConvex(pentagram));
+	Algo::Reverse(pentagram);
+	TestFalse(TEXT("A clockwise pentagram isn't convex"), LocationGeometry::IsConvex(pentagram));
+
+	const TArray<FVector2D> line = { FVector2D(0, 0), FVector2D(10, 0) };
+	TestFalse(TEXT("Two vertices aren't a convex polygon"), LocationGeometry::IsConvex(line));
+
+	return true;
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FLocationGeometrySimplifyTest, "ManiacManfred.LocationGeometry.SimplifyPolygon", EAutomationTestFlags_ApplicationContextMask | EAutomationTestFlags::ProductFilter)
+
+bool FLocationGeometrySimplifyTest::RunTest(const FString& Parameters)
+{
+	TArray<FVector2D> simplified;
+
+	// a square with a small bump in its bottom edge, which only survives a tolerance below its height
+	TArray<FVector2D> bumped = { FVector2D(0, 0), FVector2D(5, 0.5), FVector2D(10, 0), FVector2D(10, 10), FVector2D(0, 10) };
+	LocationGeometry::SimplifyPolygon(bumped, 1, simplified);
+	TestEqual(TEXT("The bump is within the tolerance"), simplified, TArray<FVector2D>({ FVector2D(0, 0), FVector2D(10, 0), FVector2D(10, 10), FVector2D(0, 10) }));
+	LocationGeometry::SimplifyPolygon(bumped, 0.25, simplified);
+	TestEqual(TEXT("The bump is outside the tolerance"), simplified, bumped);
+
+	// the edge from the last vertex back to the first one is part of the outline as well
+	const TArray<FVector2D> closingBump = { FVector2D(0, 0), FVector2D(10, 0), FVector2D(10, 10), FVector2D(0, 10), FVector2D(-3, 5) };
+	LocationGeometry::SimplifyPolygon(closingBump, 1, simplified);
+	TestEqual(TEXT("A bump in the closing edge is kept"), simplified, closingBump);
+
+	const TArray<FVector2D> closingCollinear = { FVector2D(0, 0), FVector2D(10, 0), FVector2D(10, 10), FVector2D(0, 10), FVector2D(-0.5, 5) };
+	LocationGeometry::SimplifyPolygon(closingCollinear, 1, simplified);
+	TestEqual(TEXT("A vertex close to the closing edge is removed"), simplified, TArray<FVector2D>({ FVector2D(0, 0), FVector2D(10, 0), FVector2D(10, 10), FVector2D(0, 10) }));
+
+	Algo::Reverse(bumped);
+	LocationGeometry::SimplifyPolygon(bumped, 1, simplified);
+	TestEqual(TEXT("A clockwise square keeps 4 vertices"), simplified.Num(), 4);
+	TestTrue(TEXT("A clockwise square stays clockwise"), GetSignedArea(simplified) < 0);
+
+	// everything lies within the tolerance of the line between the first vertex and the one farthest from it
+	const TArray<FVector2D> sliver = { FVector2D(0, 0), FVector2D(10, 0.1), FVector2D(20, 0), FVector2D(10, -0.1) };
+	LocationGeometry::SimplifyPolygon(sliver, 1, simplified);
+	TestEqual(TEXT("A sliver keeps 3 vertices"), simplified.Num(), 3);
+
+	const TArray<FVector2D> triangle = { FVector2D(0, 0), FVector2D(10, 0.1), FVector2D(20, 0) };
+	LocationGeometry::SimplifyPolygon(triangle, 1, simplified);
+	TestEqual(TEXT("A triangle stays as it is"), simplified, triangle);
+
+	return true;
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FLocationGeometryDecomposeTest, "ManiacManfred.LocationGeometry.DecomposeIntoConvexPolygons", EAutomationTestFlags_ApplicationContextMask | EAutomationTestFlags::ProductFilter)
+
+bool FLocationGeometryDecomposeTest::RunTest(const FString& Parameters)
+{
+	TArray<TArray<FVector2D>> pieces;
+
+	const TArray<FVector2D> square = { FVector2D(0, 0), FVector2D(10, 0), FVector2D(10, 10), FVector2D(0, 10) };
+	TestTrue(TEXT("A square can be decomposed"), LocationGeometry::DecomposeIntoConvexPolygons(square, pieces));
+	TestEqual(TEXT("A convex polygon stays in one piece"), pieces.Num(), 1);
+
+	// a U shape, open at the top, and an L shape
+	TArray<TArray<FVector2D>> polygons;
+	polygons.Add({ FVector2D(0, 0), FVector2D(30, 0), FVector2D(30, 30), FVector2D(20, 30), FVector2D(20, 10), FVector2D(10, 10), FVector2D(10, 30), FVector2D(0, 30) });
+	polygons.Add({ FVector2D(0, 0), FVector2D(20, 0), FVector2D(20, 5), FVector2D(5, 5), FVector2D(5, 20), FVector2D(0, 20) });
+
+	for (TArray<FVector2D>& polygon : polygons)
+	{
+		for (int32 winding = 0; winding < 2; ++winding)
+		{
+			if (winding == 1)
+				Algo::Reverse(polygon);
+
+			const FString name = FString::Printf(TEXT("%d vertices (%s)"), polygon.Num(), winding == 0 ? TEXT("counter clockwise") : TEXT("clockwise"));
+			const double area = GetSignedArea(polygon);
+
+			if (!TestTrue(FString::Printf(TEXT("%s can be decomposed"), *name), LocationGeometry::DecomposeIntoConvexPolygons(polygon, pieces)))
+				continue;
+
+			TestTrue(FString::Printf(TEXT("%s is split"), *name), pieces.Num() > 1);
+
+			double piecesArea = 0;
+			for (const TArray<FVector2D>& piece : pieces)
+			{
+				TestTrue(FString::Printf(TEXT("Every piece of %s is convex"), *name), LocationGeometry::IsConvex(piece));
+
+				const double pieceArea = GetSignedArea(piece);
+				TestTrue(FString::Printf(TEXT("Every piece of %s has its winding"), *name), pieceArea * area > 0);
+				piecesArea += pieceArea;
+			}
+			TestTrue(FString::Printf(TEXT("The pieces of %s cover its area"), *name), FMath::IsNearlyEqual(piecesArea, area, 1e-6));
+		}
+	}
+
+	return true;
+}
+
+#endif // WITH_DEV_AUTOMATION_TESTS